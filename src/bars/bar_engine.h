@@ -0,0 +1,184 @@
+// src/bars/bar_engine.h
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "core/ring_buffer.h"
+#include "models/normalized_update.h"
+#include "models/symbol_table.h"
+
+enum class BarKind : uint8_t { TIME, TICK, VOLUME, DOLLAR };
+
+inline constexpr size_t kBarKindCount = 4;
+
+struct Bar {
+  SymbolId symbol = kInvalidSymbol;
+  BarKind kind = BarKind::TIME;
+  uint64_t open_ts = 0;    // exchange_ts of the first trade (TIME: interval start)
+  uint64_t close_ts = 0;   // exchange_ts of the last trade (TIME: interval end)
+  double open = 0.0;
+  double high = 0.0;
+  double low = 0.0;
+  double close = 0.0;
+  double volume = 0.0;     // Base quantity
+  double notional = 0.0;   // Sum of price * quantity
+  uint32_t trade_count = 0;
+
+  double Vwap() const { return volume > 0.0 ? notional / volume : close; }
+};
+
+// Thresholds for one symbol. Zero disables that bar kind; any combination
+// can run at once.
+struct BarSpec {
+  uint64_t time_interval = 0;  // In exchange_ts units; bars align to multiples
+  uint32_t ticks = 0;          // Trades per bar
+  double volume = 0.0;         // Base quantity per bar
+  double dollars = 0.0;        // Notional per bar
+};
+
+// Builds OHLCV/VWAP bars from TRADE updates for every registered symbol and
+// publishes completed bars to a ring for downstream consumers.
+//
+// All per-symbol state is allocated up front in one flat array indexed by
+// SymbolId, so OnTrade never allocates. Tick, volume and dollar bars close on
+// the trade that reaches the threshold (that trade is included, trades are
+// never split). Time bars close on the first trade of a later interval, or
+// from AdvanceTime() for symbols that have gone quiet. If the ring is full
+// the bar is dropped and counted.
+template <size_t RingSize>
+class BarEngine {
+ public:
+  BarEngine(LockFreeRingBuffer<Bar, RingSize>& output, size_t max_symbols)
+      : output_(output), symbols_(max_symbols) {}
+
+  // Enables bars for a symbol. Call before trades for it arrive.
+  bool AddSymbol(SymbolId symbol, const BarSpec& spec) {
+    if (symbol >= symbols_.size()) {
+      return false;
+    }
+    SymbolState& state = symbols_[symbol];
+    state.spec = spec;
+    state.enabled = true;
+    for (size_t k = 0; k < kBarKindCount; ++k) {
+      state.bars[k] = Bar();
+      state.bars[k].symbol = symbol;
+      state.bars[k].kind = static_cast<BarKind>(k);
+    }
+    return true;
+  }
+
+  // Non-trade updates and unregistered symbols are ignored.
+  void OnTrade(SymbolId symbol, const NormalizedUpdate& trade) {
+    if (trade.type != NormalizedUpdate::Type::TRADE || symbol >= symbols_.size()) {
+      return;
+    }
+    SymbolState& state = symbols_[symbol];
+    if (!state.enabled) {
+      return;
+    }
+    const BarSpec& spec = state.spec;
+    const uint64_t ts = trade.exchange_ts;
+
+    if (spec.time_interval != 0) {
+      Bar& bar = state.bars[static_cast<size_t>(BarKind::TIME)];
+      const uint64_t start = ts - ts % spec.time_interval;
+      if (bar.trade_count != 0 && start >= bar.close_ts) {
+        Emit(bar);
+      }
+      if (bar.trade_count == 0) {
+        bar.open_ts = start;
+        bar.close_ts = start + spec.time_interval;
+      }
+      Accumulate(bar, trade);
+    }
+    if (spec.ticks != 0) {
+      Bar& bar = AccumulateOpen(state.bars[static_cast<size_t>(BarKind::TICK)], trade);
+      if (bar.trade_count >= spec.ticks) {
+        Emit(bar);
+      }
+    }
+    if (spec.volume > 0.0) {
+      Bar& bar = AccumulateOpen(state.bars[static_cast<size_t>(BarKind::VOLUME)], trade);
+      if (bar.volume >= spec.volume) {
+        Emit(bar);
+      }
+    }
+    if (spec.dollars > 0.0) {
+      Bar& bar = AccumulateOpen(state.bars[static_cast<size_t>(BarKind::DOLLAR)], trade);
+      if (bar.notional >= spec.dollars) {
+        Emit(bar);
+      }
+    }
+  }
+
+  // Closes time bars whose interval ended at or before now (exchange_ts
+  // units). Call periodically so quiet symbols still publish.
+  void AdvanceTime(uint64_t now) {
+    for (SymbolState& state : symbols_) {
+      Bar& bar = state.bars[static_cast<size_t>(BarKind::TIME)];
+      if (state.enabled && bar.trade_count != 0 && now >= bar.close_ts) {
+        Emit(bar);
+      }
+    }
+  }
+
+  // The bar being built, e.g. for a live partial-bar display.
+  const Bar& OpenBar(SymbolId symbol, BarKind kind) const {
+    return symbols_[symbol].bars[static_cast<size_t>(kind)];
+  }
+
+  uint64_t PublishedBars() const { return published_; }
+  uint64_t DroppedBars() const { return dropped_; }
+
+ private:
+  struct SymbolState {
+    BarSpec spec;
+    bool enabled = false;
+    std::array<Bar, kBarKindCount> bars;
+  };
+
+  static void Accumulate(Bar& bar, const NormalizedUpdate& trade) {
+    if (bar.trade_count == 0) {
+      bar.open = bar.high = bar.low = trade.price;
+    } else {
+      bar.high = std::max(bar.high, trade.price);
+      bar.low = std::min(bar.low, trade.price);
+    }
+    bar.close = trade.price;
+    bar.volume += trade.quantity;
+    bar.notional += trade.price * trade.quantity;
+    ++bar.trade_count;
+  }
+
+  // For event-driven bars the timestamps span the trades themselves.
+  static Bar& AccumulateOpen(Bar& bar, const NormalizedUpdate& trade) {
+    if (bar.trade_count == 0) {
+      bar.open_ts = trade.exchange_ts;
+    }
+    bar.close_ts = trade.exchange_ts;
+    Accumulate(bar, trade);
+    return bar;
+  }
+
+  void Emit(Bar& bar) {
+    if (output_.TryPush(bar)) {
+      ++published_;
+    } else {
+      ++dropped_;
+    }
+    const SymbolId symbol = bar.symbol;
+    const BarKind kind = bar.kind;
+    bar = Bar();
+    bar.symbol = symbol;
+    bar.kind = kind;
+  }
+
+  LockFreeRingBuffer<Bar, RingSize>& output_;
+  std::vector<SymbolState> symbols_;
+  uint64_t published_ = 0;
+  uint64_t dropped_ = 0;
+};
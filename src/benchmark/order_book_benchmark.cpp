@@ -0,0 +1,388 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../book/order_book.h"
+#include "../book/book_shards.h"
+
+namespace {
+
+const size_t kNumUpdates = 2'000'000;
+const int kRepetitions = 5;
+
+// Keeps the optimizer from discarding results we only compute for timing
+volatile double g_sink = 0.0;
+
+// Synthetic depth stream: a random-walk mid with most activity within a few
+// ticks of the touch, about a third of updates deleting a level, and the
+// book kept uncrossed the way the exchange would. far_fraction of updates
+// instead land 50-5050 ticks away, like the deep levels Binance diff
+// streams carry.
+std::vector<NormalizedUpdate> MakeUpdateStream(size_t count, double far_fraction = 0.0) {
+    std::mt19937_64 rng(7);
+    std::geometric_distribution<int> distance(0.15);
+    std::uniform_int_distribution<int> quantity(0, 20);
+    std::uniform_int_distribution<int> far_distance(50, 5050);
+    std::bernoulli_distribution far(far_fraction);
+
+    std::vector<NormalizedUpdate> updates;
+    updates.reserve(count + count / 4);
+    int64_t mid_ticks = 5'000'000;
+    uint64_t update_id = 1;
+    int64_t best_bid = mid_ticks - 1;
+    int64_t best_ask = mid_ticks + 1;
+
+    while (updates.size() < count) {
+        if (rng() % 64 == 0) {
+            mid_ticks += (rng() % 2 == 0) ? 1 : -1;
+        }
+        const bool bid = rng() % 2 == 0;
+        const int dist = far(rng) ? far_distance(rng) : distance(rng);
+        const int64_t ticks = bid ? mid_ticks - 1 - dist : mid_ticks + 1 + dist;
+        const int q = quantity(rng);
+        const double qty = q < 7 ? 0.0 : q * 0.125;
+        const double price = ticks * 0.01;
+
+        NormalizedUpdate update{update_id * 100, update_id * 100 + 50, "BTCUSDT",
+                                bid ? NormalizedUpdate::Type::BID : NormalizedUpdate::Type::ASK,
+                                price, qty, update_id, {}};
+        ++update_id;
+        updates.push_back(update);
+
+        if (qty > 0.0) {
+            // Clear the opposite side through this price
+            if (bid && ticks >= best_ask) {
+                for (int64_t t = best_ask; t <= ticks; ++t) {
+                    updates.push_back({update.exchange_ts, update.received_ts, update.symbol,
+                                       NormalizedUpdate::Type::ASK, t * 0.01, 0.0, update.update_id, {}});
+                }
+                best_ask = ticks + 1;
+            } else if (!bid && ticks <= best_bid) {
+                for (int64_t t = ticks; t <= best_bid; ++t) {
+                    updates.push_back({update.exchange_ts, update.received_ts, update.symbol,
+                                       NormalizedUpdate::Type::BID, t * 0.01, 0.0, update.update_id, {}});
+                }
+                best_bid = ticks - 1;
+            }
+            if (bid && ticks > best_bid) best_bid = ticks;
+            if (!bid && ticks < best_ask) best_ask = ticks;
+        }
+    }
+    return updates;
+}
+
+// What strategies do today: walk the book on every tick to derive signals
+double RecomputeSignals(const OrderBook& book, size_t k, double band_bps) {
+    if (!book.HasBid() || !book.HasAsk()) {
+        return 0.0;
+    }
+    const PriceLevel& bid = book.BestBid();
+    const PriceLevel& ask = book.BestAsk();
+    const double spread = ask.price - bid.price;
+    const double mid = 0.5 * (bid.price + ask.price);
+    const double micro = (bid.price * ask.quantity + ask.price * bid.quantity) /
+                         (bid.quantity + ask.quantity);
+    double bid_k = 0.0, ask_k = 0.0;
+    for (size_t i = 0; i < k && i < book.Bids().size(); ++i) bid_k += book.Bids()[i].quantity;
+    for (size_t i = 0; i < k && i < book.Asks().size(); ++i) ask_k += book.Asks()[i].quantity;
+    const double low = mid * (1.0 - band_bps / 10000.0);
+    const double high = mid * (1.0 + band_bps / 10000.0);
+    double bid_band = 0.0, ask_band = 0.0;
+    for (const PriceLevel& level : book.Bids()) {
+        if (level.price < low) break;
+        bid_band += level.quantity;
+    }
+    for (const PriceLevel& level : book.Asks()) {
+        if (level.price > high) break;
+        ask_band += level.quantity;
+    }
+    return spread + micro + (bid_k - ask_k) / (bid_k + ask_k) + bid_band + ask_band;
+}
+
+double ReadSignals(const OrderBook& book) {
+    const BookAnalytics& a = book.Analytics();
+    return a.Spread() + a.Microprice() + a.Imbalance() + a.BidDepthInBand() +
+           a.AskDepthInBand();
+}
+
+enum class Mode { BARE_BOOK, INCREMENTAL, RECOMPUTE_PER_TICK, INTEGRITY };
+
+double RunOnce(const std::vector<NormalizedUpdate>& updates, Mode mode) {
+    OrderBook::Config config;
+    config.analytics = mode == Mode::INCREMENTAL;
+    config.integrity = mode == Mode::INTEGRITY;
+    OrderBook book(config);
+    const BookAnalytics::Config& ac = config.analytics_config;
+
+    double acc = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (const NormalizedUpdate& update : updates) {
+        book.ProcessUpdate(update);
+        switch (mode) {
+            case Mode::BARE_BOOK:
+            case Mode::INTEGRITY:
+                break;
+            case Mode::INCREMENTAL:
+                acc += ReadSignals(book);
+                break;
+            case Mode::RECOMPUTE_PER_TICK:
+                acc += RecomputeSignals(book, ac.imbalance_levels, ac.depth_band_bps);
+                break;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    g_sink = acc;
+
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           static_cast<double>(updates.size());
+}
+
+// Best of several runs to filter out scheduling noise
+double Measure(const std::vector<NormalizedUpdate>& updates, Mode mode) {
+    double best = RunOnce(updates, mode);
+    for (int i = 1; i < kRepetitions; ++i) {
+        best = std::min(best, RunOnce(updates, mode));
+    }
+    return best;
+}
+
+void run_analytics_benchmark(const std::vector<NormalizedUpdate>& updates) {
+    std::cout << "=== Book Analytics ===" << std::endl;
+    const double bare = Measure(updates, Mode::BARE_BOOK);
+    const double incremental = Measure(updates, Mode::INCREMENTAL);
+    const double recompute = Measure(updates, Mode::RECOMPUTE_PER_TICK);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  Bare ProcessUpdate:                " << bare << " ns/update" << std::endl;
+    std::cout << "  ProcessUpdate + incremental reads: " << incremental << " ns/update"
+              << " (+" << incremental - bare << ")" << std::endl;
+    std::cout << "  ProcessUpdate + recompute/tick:    " << recompute << " ns/update"
+              << " (+" << recompute - bare << ")" << std::endl;
+    std::cout << std::endl;
+}
+
+// Every update in the synthetic stream has its own update_id, so this is
+// the worst case: the per-batch touch check runs on every update.
+void run_integrity_benchmark(const std::vector<NormalizedUpdate>& updates) {
+    std::cout << "=== Book Integrity ===" << std::endl;
+    const double bare = Measure(updates, Mode::BARE_BOOK);
+    const double checked = Measure(updates, Mode::INTEGRITY);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  Bare ProcessUpdate:                " << bare << " ns/update" << std::endl;
+    std::cout << "  ProcessUpdate + integrity checks:  " << checked << " ns/update"
+              << " (+" << checked - bare << ")" << std::endl;
+    std::cout << std::endl;
+}
+
+// Regroups the stream into depth events of batch_size updates sharing an
+// update_id, the way a busy diff stream delivers them.
+std::vector<NormalizedUpdate> Batched(std::vector<NormalizedUpdate> updates, size_t batch_size) {
+    for (size_t i = 0; i < updates.size(); ++i) {
+        updates[i].update_id = i / batch_size + 1;
+    }
+    return updates;
+}
+
+double RunDiffOnce(const std::vector<NormalizedUpdate>& updates, size_t depth,
+                   uint64_t* entries) {
+    OrderBook::Config config;
+    config.analytics = false;
+    config.integrity = false;
+    config.diff_depth = depth;
+    OrderBook book(config);
+
+    uint64_t emitted = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const NormalizedUpdate& update : updates) {
+        book.ProcessUpdate(update);
+        if (const BookDiff* diff = book.TakeDiff()) {
+            emitted += diff->entries.size();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    *entries = emitted;
+
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           static_cast<double>(updates.size());
+}
+
+void run_diff_benchmark(const std::vector<NormalizedUpdate>& raw) {
+    std::cout << "=== Top-N Diff Stream (N = 20) ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t batch_size : {1, 10, 50}) {
+        const std::vector<NormalizedUpdate> updates = Batched(raw, batch_size);
+        const double bare = Measure(updates, Mode::BARE_BOOK);
+        uint64_t entries = 0;
+        double with_diff = RunDiffOnce(updates, 20, &entries);
+        for (int i = 1; i < kRepetitions; ++i) {
+            with_diff = std::min(with_diff, RunDiffOnce(updates, 20, &entries));
+        }
+        std::cout << "  Batch of " << batch_size << ": " << with_diff << " ns/update (+"
+                  << with_diff - bare << "), " << entries << " diff entries for "
+                  << updates.size() << " raw updates ("
+                  << 100.0 * static_cast<double>(entries) / static_cast<double>(updates.size())
+                  << "%)" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+double RunBoundedOnce(const std::vector<NormalizedUpdate>& updates, OrderBook* book) {
+    auto start = std::chrono::steady_clock::now();
+    for (const NormalizedUpdate& update : updates) {
+        book->ProcessUpdate(update);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           static_cast<double>(updates.size());
+}
+
+// A deep book: a fifth of updates land thousands of ticks out, which a
+// bounded book keeps out of the hot arrays.
+void run_bounded_depth_benchmark() {
+    std::cout << "=== Bounded Depth (deep book) ===" << std::endl;
+    const std::vector<NormalizedUpdate> updates = MakeUpdateStream(kNumUpdates, 0.2);
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t max_depth : {0, 256, 64}) {
+        double best = 0.0;
+        size_t retained = 0, far = 0;
+        uint64_t evictions = 0, promotions = 0, far_updates = 0;
+        for (int i = 0; i < kRepetitions; ++i) {
+            OrderBook::Config config;
+            config.analytics = false;
+            config.integrity = false;
+            config.max_depth = max_depth;
+            OrderBook book(config);
+            const double ns = RunBoundedOnce(updates, &book);
+            best = i == 0 ? ns : std::min(best, ns);
+            retained = book.Bids().size() + book.Asks().size();
+            far = book.FarLevels(BookSide::BID) + book.FarLevels(BookSide::ASK);
+            evictions = book.Evictions();
+            promotions = book.Promotions();
+            far_updates = book.FarUpdates();
+        }
+        std::cout << "  max_depth " << std::setw(3) << max_depth << ": " << best
+                  << " ns/update, " << retained << " retained / " << far << " far levels, "
+                  << evictions << " evictions, " << promotions << " promotions, "
+                  << far_updates << " far updates" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Linear walk for one size, what execution logic did before the index
+double WalkCost(const std::vector<PriceLevel>& levels, double quantity) {
+    double remaining = quantity;
+    double notional = 0.0;
+    for (const PriceLevel& level : levels) {
+        const double take = std::min(remaining, level.quantity);
+        notional += take * level.price;
+        remaining -= take;
+        if (remaining <= 0.0) break;
+    }
+    return notional;
+}
+
+// Per tick: average fill price for four sizes on each side, plus quantity
+// within 10bps, the way execution logic polls it.
+void run_liquidity_benchmark(const std::vector<NormalizedUpdate>& updates) {
+    std::cout << "=== Liquidity Queries (4 sizes x 2 sides + 2 band queries per tick) ==="
+              << std::endl;
+    const double sizes[] = {0.5, 5.0, 25.0, 100.0};
+    double indexed = 0.0, walked = 0.0;
+    for (int rep = 0; rep < kRepetitions; ++rep) {
+        for (bool use_index : {true, false}) {
+            OrderBook::Config config;
+            config.analytics = false;
+            config.integrity = false;
+            OrderBook book(config);
+            double acc = 0.0;
+            auto start = std::chrono::steady_clock::now();
+            for (const NormalizedUpdate& update : updates) {
+                book.ProcessUpdate(update);
+                for (double size : sizes) {
+                    if (use_index) {
+                        acc += book.EstimateBuy(size).notional + book.EstimateSell(size).notional;
+                    } else {
+                        acc += WalkCost(book.Asks(), size) + WalkCost(book.Bids(), size);
+                    }
+                }
+                if (use_index) {
+                    acc += book.QuantityWithinBps(BookSide::BID, 10.0) +
+                           book.QuantityWithinBps(BookSide::ASK, 10.0);
+                } else if (book.HasBid() && book.HasAsk()) {
+                    const double mid = 0.5 * (book.BestBid().price + book.BestAsk().price);
+                    for (const PriceLevel& l : book.Bids()) {
+                        if (l.price < mid * (1.0 - 0.001)) break;
+                        acc += l.quantity;
+                    }
+                    for (const PriceLevel& l : book.Asks()) {
+                        if (l.price > mid * (1.0 + 0.001)) break;
+                        acc += l.quantity;
+                    }
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+            g_sink = acc;
+            const double ns = std::chrono::duration<double, std::nano>(end - start).count() /
+                              static_cast<double>(updates.size());
+            double& best = use_index ? indexed : walked;
+            best = rep == 0 ? ns : std::min(best, ns);
+        }
+    }
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  Fenwick index:    " << indexed << " ns/tick" << std::endl;
+    std::cout << "  Linear walks:     " << walked << " ns/tick" << std::endl;
+    std::cout << std::endl;
+}
+
+// One router thread feeding N pinned shards; the stream is spread over 64
+// symbols. Each shard gets its own core when there are enough (core 0 is
+// left to the router); on smaller machines shards share cores and the
+// numbers show contention rather than scaling.
+void run_shard_scaling_benchmark(const std::vector<NormalizedUpdate>& updates) {
+    std::cout << "=== Sharded Book Building (64 symbols) ===" << std::endl;
+    const size_t kSymbols = 64;
+    const int cores = ThreadUtils::CoreCount();
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t shard_count : {1, 2, 4}) {
+        ShardedBookStage<4096>::Config config;
+        config.shard_count = shard_count;
+        for (size_t i = 0; i < shard_count; ++i) {
+            const int core = static_cast<int>(i) + 1;
+            config.cores.push_back(core < cores ? core : -1);
+        }
+        ShardedBookStage<4096> stage(kSymbols, config);
+        stage.Start();
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < updates.size(); ++i) {
+            stage.Route(static_cast<SymbolId>(i % kSymbols), updates[i]);
+        }
+        stage.Drain();
+        const auto end = std::chrono::steady_clock::now();
+        stage.Stop();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << "  " << shard_count << " shard(s): " << updates.size() / seconds / 1e6
+                  << " M updates/s (router stalls: " << stage.Stalls() << ")" << std::endl;
+    }
+    std::cout << "  Cores available: " << cores << std::endl;
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Generating " << kNumUpdates << " synthetic depth updates..." << std::endl;
+    const std::vector<NormalizedUpdate> updates = MakeUpdateStream(kNumUpdates);
+    std::cout << "Stream has " << updates.size() << " updates" << std::endl << std::endl;
+
+    run_analytics_benchmark(updates);
+    run_integrity_benchmark(updates);
+    run_diff_benchmark(updates);
+    run_bounded_depth_benchmark();
+    run_liquidity_benchmark(updates);
+    run_shard_scaling_benchmark(updates);
+
+    return 0;
+}
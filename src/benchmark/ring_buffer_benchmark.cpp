@@ -0,0 +1,105 @@
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "../core/latency_tracker.h"
+#include "../core/load_generator.h"
+#include "../core/ring_buffer.h"
+#include "../core/thread_utils.h"
+
+namespace {
+
+const double kSeconds = 0.5;
+
+struct Message {
+    uint64_t send_ns;  // When the producer says it sent the message
+    uint64_t sequence;
+};
+
+struct Result {
+    LatencyTracker naive;      // Closed loop, stamped at actual send
+    LatencyTracker corrected;  // Same samples, with RecordLatencyCorrected
+    LatencyTracker intended;   // Open loop, measured from the intended send time
+    uint64_t late_sends = 0;
+};
+
+// One producer at a constant rate, one consumer, through the SPSC ring.
+// The closed-loop producer stamps messages when it actually gets to send
+// them, the way market_data_pipeline_test used to; the open-loop one stamps
+// when they were due.
+void Run(double rate, bool open_loop, Result& result) {
+    LockFreeRingBuffer<Message, 1024> ring;
+    const uint64_t count = static_cast<uint64_t>(rate * kSeconds);
+    const int64_t period = static_cast<int64_t>(1e9 / rate);
+    // Producer and consumer on separate physical cores sharing a cache; if
+    // the host can't spare two, the threads have to take turns
+    PlacementPlanner placement(ThreadUtils::Topology());
+    const size_t producer_stage = placement.AddStage("producer");
+    const size_t consumer_stage = placement.AddStage("consumer");
+    const bool yield = !placement.Plan();
+    std::atomic<bool> go{false};
+
+    std::thread consumer([&]() {
+        ThreadUtils::PinToCore(placement.Core(consumer_stage));
+        while (!go.load()) {}
+        Message message;
+        for (uint64_t received = 0; received < count;) {
+            if (!ring.TryPop(&message)) {
+                if (yield) std::this_thread::yield();
+                continue;
+            }
+            const int64_t latency = static_cast<int64_t>(TscClock::MonotonicNs() - message.send_ns);
+            if (open_loop) {
+                result.intended.RecordLatency(latency);
+            } else {
+                result.naive.RecordLatency(latency);
+                result.corrected.RecordLatencyCorrected(latency, period);
+            }
+            ++received;
+        }
+    });
+
+    ThreadUtils::PinToCore(placement.Core(producer_stage));
+    go.store(true);
+    ConstantRateSchedule schedule(rate);
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint64_t due = schedule.WaitFor(i, yield);
+        Message message{0, i};
+        while (true) {
+            message.send_ns = open_loop ? due : TscClock::MonotonicNs();
+            if (ring.TryPush(message)) break;
+            if (yield) std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    if (open_loop) {
+        result.late_sends = schedule.LateSends();
+    }
+}
+
+void Print(const char* name, const LatencyTracker& t) {
+    std::cout << "    " << std::left << std::setw(30) << name << std::right
+              << " p50 " << std::setw(9) << t.PercentileLatency(50)
+              << "  p99 " << std::setw(9) << t.PercentileLatency(99)
+              << "  p99.9 " << std::setw(9) << t.PercentileLatency(99.9)
+              << "  max " << std::setw(9) << t.MaxLatency() << " ns" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "=== LockFreeRingBuffer latency at constant offered rates ===" << std::endl;
+    std::cout << "Cores available: " << ThreadUtils::CoreCount() << std::endl;
+    for (double rate : {100'000.0, 1'000'000.0, 4'000'000.0}) {
+        Result result;
+        Run(rate, false, result);
+        Run(rate, true, result);
+        std::cout << "  " << rate / 1e6 << " M msgs/s (" << result.late_sends
+                  << " open-loop sends behind schedule)" << std::endl;
+        Print("closed loop, send-time stamps", result.naive);
+        Print("closed loop, CO-corrected", result.corrected);
+        Print("open loop, intended-time", result.intended);
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+// src/book/band_depth_view.h
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "book/order_book.h"
+#include "book/price_level.h"
+
+// Depth aggregated into fixed-width price bands, kept next to an OrderBook
+// and updated from the LevelChange each ProcessUpdate returns.
+//
+// Buckets cover a fixed window of bucket_count bands around the touch and
+// are stored as plain arrays indexed by band, lowest price first, shared by
+// both sides. A level change is one multiply and one add. Levels outside
+// the window aren't tracked; when the touch drifts within recenter_margin
+// bands of either edge the window is rebuilt from the book.
+class BandDepthView {
+ public:
+  enum class WidthMode {
+    PRICE,  // width is in price units, e.g. 10 * tick size
+    BPS,    // width is in basis points of mid, fixed at each recenter
+  };
+
+  struct Config {
+    WidthMode mode = WidthMode::PRICE;
+    double width = 1.0;
+    size_t bucket_count = 256;
+    size_t recenter_margin = 16;
+  };
+
+  static Config TickBands(double tick_size, uint32_t ticks_per_band,
+                          size_t bucket_count = 256) {
+    Config config;
+    config.mode = WidthMode::PRICE;
+    config.width = tick_size * ticks_per_band;
+    config.bucket_count = bucket_count;
+    return config;
+  }
+
+  static Config BpsBands(double bps, size_t bucket_count = 256) {
+    Config config;
+    config.mode = WidthMode::BPS;
+    config.width = bps;
+    config.bucket_count = bucket_count;
+    return config;
+  }
+
+  explicit BandDepthView(const Config& config)
+      : config_(config),
+        bid_qty_(config.bucket_count, 0.0),
+        ask_qty_(config.bucket_count, 0.0),
+        bid_levels_(config.bucket_count, 0),
+        ask_levels_(config.bucket_count, 0) {}
+
+  // Call with the book and the change it just applied.
+  void Apply(const OrderBook& book, const LevelChange& change) {
+    if (change.action == LevelAction::NONE) {
+      return;
+    }
+    if (!centered_ || (change.index == 0 && TouchNearEdge(book))) {
+      Recenter(book);
+      return;
+    }
+
+    const int64_t bucket = BucketOf(change.price);
+    if (bucket < 0 || bucket >= static_cast<int64_t>(config_.bucket_count)) {
+      return;
+    }
+    const bool bid = change.side == BookSide::BID;
+    double& qty = bid ? bid_qty_[bucket] : ask_qty_[bucket];
+    uint32_t& levels = bid ? bid_levels_[bucket] : ask_levels_[bucket];
+    switch (change.action) {
+      case LevelAction::INSERT:
+        ++levels;
+        qty += change.new_quantity;
+        break;
+      case LevelAction::UPDATE:
+        qty += change.new_quantity - change.old_quantity;
+        break;
+      case LevelAction::ERASE:
+        // An empty band is exactly zero, whatever rounding accumulated
+        qty = --levels == 0 ? 0.0 : qty - change.old_quantity;
+        break;
+      case LevelAction::NONE:
+        break;
+    }
+  }
+
+  // Re-anchors the window on the current touch and rebuilds every bucket
+  // from the book. O(levels); happens only when the market drifts.
+  void Recenter(const OrderBook& book) {
+    std::fill(bid_qty_.begin(), bid_qty_.end(), 0.0);
+    std::fill(ask_qty_.begin(), ask_qty_.end(), 0.0);
+    std::fill(bid_levels_.begin(), bid_levels_.end(), 0);
+    std::fill(ask_levels_.begin(), ask_levels_.end(), 0);
+
+    double center;
+    if (book.HasBid() && book.HasAsk()) {
+      center = 0.5 * (book.BestBid().price + book.BestAsk().price);
+    } else if (book.HasBid()) {
+      center = book.BestBid().price;
+    } else if (book.HasAsk()) {
+      center = book.BestAsk().price;
+    } else {
+      centered_ = false;
+      return;
+    }
+
+    width_ = config_.mode == WidthMode::PRICE ? config_.width
+                                              : center * config_.width / 10000.0;
+    inv_width_ = 1.0 / width_;
+    // Align edges to multiples of the width so tick bands line up with ticks
+    origin_ = (std::floor(center * inv_width_) -
+               static_cast<double>(config_.bucket_count / 2)) * width_;
+    centered_ = true;
+    ++recenters_;
+
+    Rebuild(book, BookSide::BID, bid_qty_, bid_levels_);
+    Rebuild(book, BookSide::ASK, ask_qty_, ask_levels_);
+  }
+
+  // Band index for a price; may be outside [0, BucketCount()).
+  int64_t BucketOf(double price) const {
+    // The small bias keeps prices that sit exactly on an edge from
+    // flipping to the lower band through rounding.
+    return static_cast<int64_t>(std::floor((price - origin_) * inv_width_ + 1e-9));
+  }
+
+  double BucketLowPrice(size_t bucket) const {
+    return origin_ + static_cast<double>(bucket) * width_;
+  }
+
+  size_t BucketCount() const { return config_.bucket_count; }
+  double BucketWidth() const { return width_; }
+  bool IsCentered() const { return centered_; }
+  uint64_t Recenters() const { return recenters_; }
+
+  std::span<const double> BidQuantities() const { return bid_qty_; }
+  std::span<const double> AskQuantities() const { return ask_qty_; }
+  std::span<const uint32_t> BidLevelCounts() const { return bid_levels_; }
+  std::span<const uint32_t> AskLevelCounts() const { return ask_levels_; }
+
+ private:
+  bool TouchNearEdge(const OrderBook& book) const {
+    const int64_t low = static_cast<int64_t>(config_.recenter_margin);
+    const int64_t high = static_cast<int64_t>(config_.bucket_count) - low;
+    if (book.HasBid()) {
+      const int64_t b = BucketOf(book.BestBid().price);
+      if (b < low || b >= high) {
+        return true;
+      }
+    }
+    if (book.HasAsk()) {
+      const int64_t b = BucketOf(book.BestAsk().price);
+      if (b < low || b >= high) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Walks the full book, including levels beyond a bounded book's retained
+  // depth, since changes to those are reported to Apply() too.
+  void Rebuild(const OrderBook& book, BookSide side, std::vector<double>& qty,
+               std::vector<uint32_t>& counts) {
+    const int64_t n = static_cast<int64_t>(config_.bucket_count);
+    book.ForEachLevel(side, [&](const PriceLevel& level) {
+      const int64_t bucket = BucketOf(level.price);
+      if (bucket >= 0 && bucket < n) {
+        qty[bucket] += level.quantity;
+        ++counts[bucket];
+      }
+    });
+  }
+
+  Config config_;
+  bool centered_ = false;
+  double origin_ = 0.0;
+  double width_ = 0.0;
+  double inv_width_ = 0.0;
+  uint64_t recenters_ = 0;
+
+  std::vector<double> bid_qty_;
+  std::vector<double> ask_qty_;
+  std::vector<uint32_t> bid_levels_;
+  std::vector<uint32_t> ask_levels_;
+};
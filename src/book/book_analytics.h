@@ -0,0 +1,216 @@
+// src/book/book_analytics.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "book/price_level.h"
+
+// Derived top-of-book signals maintained incrementally from level changes.
+// OrderBook calls OnLevelChange after every applied change, so reads are
+// plain field loads. Sums are adjusted by deltas and fully recomputed every
+// kRefreshInterval changes to bound floating-point drift.
+class BookAnalytics {
+ public:
+  struct Config {
+    size_t imbalance_levels = 5;   // K for top-K volume imbalance
+    double depth_band_bps = 10.0;  // X for cumulative depth within X bps of mid
+  };
+
+  static constexpr uint32_t kRefreshInterval = 4096;
+
+  BookAnalytics() : BookAnalytics(Config()) {}
+  explicit BookAnalytics(const Config& config)
+      : config_(config), band_fraction_(config.depth_band_bps / 10000.0) {}
+
+  // bids/asks: both sides after the change, best-first.
+  template <bool IsBid>
+  void OnLevelChange(const std::vector<PriceLevel>& bids,
+                     const std::vector<PriceLevel>& asks,
+                     const LevelChange& change) {
+    if (++changes_since_refresh_ >= kRefreshInterval) {
+      Refresh(bids, asks);
+      return;
+    }
+
+    const std::vector<PriceLevel>& levels = IsBid ? bids : asks;
+    SideState& side = IsBid ? bid_ : ask_;
+    const size_t index = change.index;
+    const double old_quantity = change.old_quantity;
+    const double new_quantity = change.new_quantity;
+
+    // Top-K volume
+    const size_t k = config_.imbalance_levels;
+    if (index < k) {
+      switch (change.action) {
+        case LevelAction::UPDATE:
+          side.top_k_qty += new_quantity - old_quantity;
+          break;
+        case LevelAction::INSERT:
+          side.top_k_qty += new_quantity;
+          if (levels.size() > k) {
+            side.top_k_qty -= levels[k].quantity;  // Pushed out of the top K
+          }
+          break;
+        case LevelAction::ERASE:
+          side.top_k_qty -= old_quantity;
+          if (levels.size() >= k) {
+            side.top_k_qty += levels[k - 1].quantity;  // Pulled into the top K
+          }
+          break;
+        case LevelAction::NONE:
+          return;
+      }
+    }
+
+    // Depth band: in-band levels are always a prefix of the side
+    switch (change.action) {
+      case LevelAction::UPDATE:
+        if (index < side.band_count) {
+          side.band_qty += new_quantity - old_quantity;
+        }
+        break;
+      case LevelAction::INSERT:
+        if (index < side.band_count ||
+            (index == side.band_count && InBand<IsBid>(change.price))) {
+          ++side.band_count;
+          side.band_qty += new_quantity;
+        }
+        break;
+      case LevelAction::ERASE:
+        if (index < side.band_count) {
+          --side.band_count;
+          side.band_qty -= old_quantity;
+        }
+        break;
+      case LevelAction::NONE:
+        return;
+    }
+
+    if (index == 0) {
+      // Touch moved: reprice and slide both band edges to the new mid.
+      UpdateTop(bids, asks);
+      FitBand<true>(bids);
+      FitBand<false>(asks);
+    }
+  }
+
+  // Recomputes everything from the levels. Used on refresh and after Clear.
+  void Refresh(const std::vector<PriceLevel>& bids,
+               const std::vector<PriceLevel>& asks) {
+    changes_since_refresh_ = 0;
+    RecomputeSide(bids, bid_);
+    RecomputeSide(asks, ask_);
+    UpdateTop(bids, asks);
+    bid_.band_count = 0;
+    bid_.band_qty = 0.0;
+    ask_.band_count = 0;
+    ask_.band_qty = 0.0;
+    FitBand<true>(bids);
+    FitBand<false>(asks);
+  }
+
+  bool HasTwoSidedQuote() const { return two_sided_; }
+
+  // Spread, mid and microprice are zero unless both sides are present.
+  double Spread() const { return spread_; }
+  double Mid() const { return mid_; }
+  // Size-weighted mid: leans toward the side with less resting quantity.
+  double Microprice() const { return microprice_; }
+
+  // (bid - ask) / (bid + ask) over the top K levels, in [-1, 1].
+  double Imbalance() const {
+    const double total = bid_.top_k_qty + ask_.top_k_qty;
+    return total > 0.0 ? (bid_.top_k_qty - ask_.top_k_qty) / total : 0.0;
+  }
+  double BidTopKQuantity() const { return bid_.top_k_qty; }
+  double AskTopKQuantity() const { return ask_.top_k_qty; }
+
+  // Resting quantity priced within depth_band_bps of mid.
+  double BidDepthInBand() const { return bid_.band_qty; }
+  double AskDepthInBand() const { return ask_.band_qty; }
+  size_t BidLevelsInBand() const { return bid_.band_count; }
+  size_t AskLevelsInBand() const { return ask_.band_count; }
+
+  const Config& GetConfig() const { return config_; }
+
+ private:
+  struct SideState {
+    double top_k_qty = 0.0;
+    double band_qty = 0.0;
+    size_t band_count = 0;
+  };
+
+  template <bool IsBid>
+  bool InBand(double price) const {
+    if (!two_sided_) {
+      return false;
+    }
+    if constexpr (IsBid) {
+      return price >= band_low_;
+    } else {
+      return price <= band_high_;
+    }
+  }
+
+  void UpdateTop(const std::vector<PriceLevel>& bids,
+                 const std::vector<PriceLevel>& asks) {
+    two_sided_ = !bids.empty() && !asks.empty();
+    if (!two_sided_) {
+      spread_ = mid_ = microprice_ = 0.0;
+      return;
+    }
+    const PriceLevel& bid = bids.front();
+    const PriceLevel& ask = asks.front();
+    spread_ = ask.price - bid.price;
+    mid_ = 0.5 * (bid.price + ask.price);
+    microprice_ = (bid.price * ask.quantity + ask.price * bid.quantity) /
+                  (bid.quantity + ask.quantity);
+    band_low_ = mid_ * (1.0 - band_fraction_);
+    band_high_ = mid_ * (1.0 + band_fraction_);
+  }
+
+  // Slides the band edge to match the current mid. Cost is the number of
+  // levels that crossed the edge, which is small for ordinary mid moves.
+  template <bool IsBid>
+  void FitBand(const std::vector<PriceLevel>& levels) {
+    SideState& side = IsBid ? bid_ : ask_;
+    while (side.band_count < levels.size() &&
+           InBand<IsBid>(levels[side.band_count].price)) {
+      side.band_qty += levels[side.band_count].quantity;
+      ++side.band_count;
+    }
+    while (side.band_count > 0 &&
+           !InBand<IsBid>(levels[side.band_count - 1].price)) {
+      --side.band_count;
+      side.band_qty -= levels[side.band_count].quantity;
+    }
+    if (side.band_count == 0) {
+      side.band_qty = 0.0;
+    }
+  }
+
+  void RecomputeSide(const std::vector<PriceLevel>& levels, SideState& side) {
+    side.top_k_qty = 0.0;
+    const size_t k = config_.imbalance_levels < levels.size()
+                         ? config_.imbalance_levels
+                         : levels.size();
+    for (size_t i = 0; i < k; ++i) {
+      side.top_k_qty += levels[i].quantity;
+    }
+  }
+
+  Config config_;
+  double band_fraction_;
+
+  bool two_sided_ = false;
+  double spread_ = 0.0;
+  double mid_ = 0.0;
+  double microprice_ = 0.0;
+  double band_low_ = 0.0;
+  double band_high_ = 0.0;
+  SideState bid_;
+  SideState ask_;
+  uint32_t changes_since_refresh_ = 0;
+};
@@ -0,0 +1,114 @@
+// src/book/book_diff.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "book/price_level.h"
+
+struct DiffEntry {
+  BookSide side;
+  double price;
+  double quantity;  // New quantity; zero means the level left the top N
+};
+
+// Net change to the top N levels of each side over one batch.
+struct BookDiff {
+  uint64_t update_id = 0;        // Last update id of the batch
+  uint64_t sequence = 0;         // Increases by one per emitted diff
+  std::vector<DiffEntry> entries;
+};
+
+// Turns a batch of level changes into the net top-N change set.
+//
+// Keeps a copy of the top N levels as of the last emitted diff and, at the
+// end of a batch that touched the top N, merge-walks it against the current
+// levels. Anything that churned and came back to the same quantity cancels
+// out; levels pushed below N by inserts are reported with quantity zero, so
+// a subscriber applying diffs holds exactly the top N. Cost is O(N) per
+// batch that touched the top N, and nothing for batches that didn't.
+class BookDiffTracker {
+ public:
+  explicit BookDiffTracker(size_t depth) : depth_(depth) {
+    prev_bids_.reserve(depth);
+    prev_asks_.reserve(depth);
+    // Worst case per side: every old level out, every new level in
+    diff_.entries.reserve(4 * depth);
+  }
+
+  // Called for every applied level change.
+  void OnLevelChange(const LevelChange& change) {
+    if (change.index < depth_) {
+      dirty_ = true;
+    }
+  }
+
+  // Marks the top N as changed without knowing where, e.g. after a reload.
+  void Invalidate() { dirty_ = true; }
+
+  // Closes a batch. Returns true if a non-empty diff was produced.
+  bool Finish(const std::vector<PriceLevel>& bids,
+              const std::vector<PriceLevel>& asks, uint64_t update_id) {
+    if (!dirty_) {
+      return false;
+    }
+    dirty_ = false;
+    diff_.entries.clear();
+    DiffSide<true>(prev_bids_, bids);
+    DiffSide<false>(prev_asks_, asks);
+    if (diff_.entries.empty()) {
+      // Everything that moved came back
+      ++cancelled_batches_;
+      return false;
+    }
+    diff_.update_id = update_id;
+    ++diff_.sequence;
+    entries_emitted_ += diff_.entries.size();
+    return true;
+  }
+
+  const BookDiff& Diff() const { return diff_; }
+  size_t Depth() const { return depth_; }
+  uint64_t EntriesEmitted() const { return entries_emitted_; }
+  uint64_t CancelledBatches() const { return cancelled_batches_; }
+
+ private:
+  template <bool IsBid>
+  static bool Better(double a, double b) {
+    return IsBid ? a > b : a < b;
+  }
+
+  template <bool IsBid>
+  void DiffSide(std::vector<PriceLevel>& prev, const std::vector<PriceLevel>& levels) {
+    const BookSide side = IsBid ? BookSide::BID : BookSide::ASK;
+    const size_t n = std::min(depth_, levels.size());
+    size_t i = 0;  // prev
+    size_t j = 0;  // current
+    while (i < prev.size() || j < n) {
+      if (j == n || (i < prev.size() && Better<IsBid>(prev[i].price, levels[j].price))) {
+        diff_.entries.push_back({side, prev[i].price, 0.0});
+        ++i;
+      } else if (i == prev.size() || Better<IsBid>(levels[j].price, prev[i].price)) {
+        diff_.entries.push_back({side, levels[j].price, levels[j].quantity});
+        ++j;
+      } else {
+        if (prev[i].quantity != levels[j].quantity) {
+          diff_.entries.push_back({side, levels[j].price, levels[j].quantity});
+        }
+        ++i;
+        ++j;
+      }
+    }
+    prev.assign(levels.begin(), levels.begin() + n);
+  }
+
+  size_t depth_;
+  bool dirty_ = false;
+  std::vector<PriceLevel> prev_bids_;
+  std::vector<PriceLevel> prev_asks_;
+  BookDiff diff_;
+  uint64_t entries_emitted_ = 0;
+  uint64_t cancelled_batches_ = 0;
+};
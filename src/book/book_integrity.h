@@ -0,0 +1,174 @@
+// src/book/book_integrity.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "book/price_level.h"
+
+// Reasons a book can no longer be trusted. Bit flags so several can be
+// pending on one resync signal.
+enum class IntegrityFault : uint32_t {
+  CROSSED = 1u << 0,            // Best bid above best ask after a batch
+  LOCKED = 1u << 1,             // Best bid equal to best ask after a batch
+  OUT_OF_ORDER = 1u << 2,       // update_id went backwards
+  BAD_QUANTITY = 1u << 3,       // Negative or NaN quantity on the wire
+  CHECKSUM_MISMATCH = 1u << 4,  // Top-N differs from a reference snapshot
+};
+
+inline constexpr size_t kIntegrityFaultCount = 5;
+
+inline constexpr uint32_t FaultBit(IntegrityFault fault) {
+  return static_cast<uint32_t>(fault);
+}
+
+// Full depth state from the exchange's REST snapshot endpoint, used both to
+// (re)build a book and as a reference to check it against.
+struct DepthSnapshot {
+  uint64_t update_id = 0;
+  std::vector<PriceLevel> bids;  // Best-first
+  std::vector<PriceLevel> asks;  // Best-first
+};
+
+// Per-symbol resync request. Raised by the book thread, consumed by whoever
+// owns the feed connection. Raising is a plain load when the reason is
+// already pending, so a book that stays crossed doesn't hammer the line.
+class alignas(64) ResyncSignal {
+ public:
+  void Raise(IntegrityFault fault) {
+    const uint32_t bit = FaultBit(fault);
+    if ((reasons_.load(std::memory_order_relaxed) & bit) == 0) {
+      reasons_.fetch_or(bit, std::memory_order_release);
+    }
+  }
+
+  bool Pending() const { return reasons_.load(std::memory_order_acquire) != 0; }
+  uint32_t Reasons() const { return reasons_.load(std::memory_order_acquire); }
+
+  // Returns the pending reasons and clears them.
+  uint32_t Take() { return reasons_.exchange(0, std::memory_order_acq_rel); }
+
+ private:
+  std::atomic<uint32_t> reasons_{0};
+};
+
+// FNV-1a over the bit patterns of the top `depth` levels on each side. Each
+// side is prefixed with its level count so a level can't migrate sides
+// without changing the result.
+inline uint64_t BookChecksum(const std::vector<PriceLevel>& bids,
+                             const std::vector<PriceLevel>& asks,
+                             size_t depth) {
+  uint64_t hash = 14695981039346656037ull;
+  auto mix = [&hash](uint64_t word) {
+    for (int i = 0; i < 8; ++i) {
+      hash ^= (word >> (i * 8)) & 0xff;
+      hash *= 1099511628211ull;
+    }
+  };
+  auto fold = [&](const std::vector<PriceLevel>& levels) {
+    const size_t n = levels.size() < depth ? levels.size() : depth;
+    mix(n);
+    for (size_t i = 0; i < n; ++i) {
+      mix(std::bit_cast<uint64_t>(levels[i].price));
+      mix(std::bit_cast<uint64_t>(levels[i].quantity));
+    }
+  };
+  fold(bids);
+  fold(asks);
+  return hash;
+}
+
+// Online integrity checks for one OrderBook. The per-update checks are a
+// couple of compares that OrderBook makes inline; the touch is checked once
+// per batch, because Binance depth events routinely cross the book halfway
+// through being applied (bids land before the asks that clear them).
+class BookIntegrity {
+ public:
+  struct Config {
+    size_t checksum_depth = 20;  // Levels per side compared against references
+  };
+
+  BookIntegrity() : BookIntegrity(Config()) {}
+  explicit BookIntegrity(const Config& config) : config_(config) {}
+
+  void Report(IntegrityFault fault) {
+    ++fault_counts_[std::countr_zero(FaultBit(fault))];
+    signal_.Raise(fault);
+  }
+
+  // Called at the end of each batch.
+  void CheckBatch(const std::vector<PriceLevel>& bids,
+                  const std::vector<PriceLevel>& asks, uint64_t update_id) {
+    ++batches_checked_;
+    if (!bids.empty() && !asks.empty()) {
+      const double bid = bids.front().price;
+      const double ask = asks.front().price;
+      if (bid > ask) {
+        Report(IntegrityFault::CROSSED);
+      } else if (bid == ask) {
+        Report(IntegrityFault::LOCKED);
+      }
+    }
+    CheckReference(bids, asks, update_id);
+  }
+
+  // Compares against the queued reference once the book has reached it.
+  void CheckReference(const std::vector<PriceLevel>& bids,
+                      const std::vector<PriceLevel>& asks, uint64_t update_id) {
+    if (has_reference_ && update_id >= reference_update_id_) {
+      if (update_id == reference_update_id_) {
+        ++references_checked_;
+        if (BookChecksum(bids, asks, config_.checksum_depth) != reference_checksum_) {
+          Report(IntegrityFault::CHECKSUM_MISMATCH);
+        }
+      } else {
+        // The book moved past the reference without landing on it exactly.
+        ++references_skipped_;
+      }
+      has_reference_ = false;
+    }
+  }
+
+  // Queues a reference snapshot to compare against once the book reaches
+  // its update_id. Only the checksum is kept, so the snapshot can be freed.
+  // A reference the book has already passed is counted as skipped.
+  void SetReference(const DepthSnapshot& reference, uint64_t current_update_id) {
+    if (reference.update_id < current_update_id) {
+      ++references_skipped_;
+      return;
+    }
+    reference_update_id_ = reference.update_id;
+    reference_checksum_ =
+        BookChecksum(reference.bids, reference.asks, config_.checksum_depth);
+    has_reference_ = true;
+  }
+
+  ResyncSignal& Signal() { return signal_; }
+  const ResyncSignal& Signal() const { return signal_; }
+
+  uint64_t FaultCount(IntegrityFault fault) const {
+    return fault_counts_[std::countr_zero(FaultBit(fault))];
+  }
+  uint64_t BatchesChecked() const { return batches_checked_; }
+  uint64_t ReferencesChecked() const { return references_checked_; }
+  uint64_t ReferencesSkipped() const { return references_skipped_; }
+  size_t ChecksumDepth() const { return config_.checksum_depth; }
+
+ private:
+  Config config_;
+  std::array<uint64_t, kIntegrityFaultCount> fault_counts_{};
+  uint64_t batches_checked_ = 0;
+  uint64_t references_checked_ = 0;
+  uint64_t references_skipped_ = 0;
+
+  bool has_reference_ = false;
+  uint64_t reference_update_id_ = 0;
+  uint64_t reference_checksum_ = 0;
+
+  // Read by the feed thread; kept off the counters' cache line.
+  ResyncSignal signal_;
+};
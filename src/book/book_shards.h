@@ -0,0 +1,400 @@
+// src/book/book_shards.h
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book/order_book.h"
+#include "core/flight_recorder.h"
+#include "core/perf_counters.h"
+#include "core/ring_buffer.h"
+#include "core/stage_trace.h"
+#include "core/thread_utils.h"
+#include "models/normalized_update.h"
+#include "models/symbol_table.h"
+
+struct ShardMessage {
+  SymbolId symbol = kInvalidSymbol;
+  NormalizedUpdate update;
+};
+
+// Spreads book building for many symbols over N processing threads.
+//
+// Each shard is a pinned thread with its own SPSC ring; a symbol's book is
+// only ever touched by the shard the routing table points it at. The router
+// is whichever single thread calls Route(), Move() and Rebalance() (in main,
+// the processing thread); the routing table and per-symbol load counts are
+// private to it, so the hot path on both sides shares nothing but the rings
+// and each shard's progress counter.
+//
+// Moving a symbol is safe once its old shard has consumed the last update
+// routed to it: the shard's release of its progress counter, the router's
+// acquire, and the next push to the new shard order every write to the book
+// before the new shard's first read. Symbols that are still in flight are
+// left for a later Rebalance().
+//
+// A book's ResyncSignal is moved by its shard into a per-symbol slot that
+// any thread can TakeResync() from, without touching the book; the taker
+// fetches a fresh depth snapshot and hands it back with Reload(). The
+// owning shard loads it before the symbol's next update and skips updates
+// the snapshot already covers.
+template <size_t RingSize = 4096>
+class ShardedBookStage {
+ public:
+  // Called on the owning shard after every update, e.g. to publish
+  // snapshots. Must not block.
+  using Listener = std::function<void(SymbolId, const OrderBook&, const LevelChange&)>;
+
+  struct Config {
+    size_t shard_count = 2;
+    // cores[i] is the CPU for shard i; shards without an entry, or with a
+    // negative one, are left unpinned.
+    std::vector<int> cores;
+    OrderBook::Config book_config;
+    // Rebalance while the busiest and idlest shard differ by more than this
+    // fraction of the mean load.
+    double imbalance_threshold = 0.2;
+    size_t max_moves = 8;  // Per Rebalance() call
+    // Nonzero: stamp BOOK_APPLIED on traced updates and record their
+    // per-hop latency on the shard, in intervals of this many TSC ticks.
+    uint64_t trace_interval = 0;
+    // Nonzero: count hardware events around each ProcessUpdate on the
+    // shard, in intervals of this many TSC ticks. Needs a PMU; shards
+    // whose counters won't open just record nothing.
+    uint64_t perf_interval = 0;
+    // Nonzero (TSC ticks): with tracing on, keep a flight recorder per shard
+    // and dump it when an update's wire-to-book latency reaches this.
+    uint64_t flight_threshold = 0;
+    size_t flight_events = 1024;  // Events per dump
+    // Runs on each shard's thread after pinning, before its first update,
+    // e.g. RuntimeSetup::PrepareThread.
+    std::function<void(size_t shard)> on_thread_start;
+  };
+
+  ShardedBookStage(size_t max_symbols, const Config& config, Listener listener = {})
+      : config_(config),
+        listener_(std::move(listener)),
+        books_(max_symbols),
+        resync_(max_symbols),
+        routes_(max_symbols),
+        last_push_(max_symbols, 0),
+        load_(max_symbols, 0),
+        pushed_(config.shard_count, 0),
+        shard_load_(config.shard_count, 0) {
+    for (size_t i = 0; i < config_.shard_count; ++i) {
+      shards_.push_back(std::make_unique<Shard>());
+      if (config_.trace_interval != 0) {
+        shards_.back()->trace = std::make_unique<StageTraceRecorder>(config_.trace_interval);
+      }
+      if (config_.trace_interval != 0 && config_.flight_threshold != 0) {
+        FlightRecorder::Config flight;
+        flight.name = "shard" + std::to_string(i);
+        flight.threshold_ticks = config_.flight_threshold;
+        flight.dump_events = config_.flight_events;
+        flight.cooldown_ticks = config_.trace_interval;  // At most one dump per interval
+        shards_.back()->flight = std::make_unique<FlightRecorder>(flight);
+      }
+      if (config_.perf_interval != 0) {
+        Shard& shard = *shards_.back();
+        shard.perf = std::make_unique<PerfStageRecorder>(&shard.counters, config_.perf_interval);
+      }
+    }
+    // Round-robin until there's load to balance on
+    for (size_t s = 0; s < max_symbols; ++s) {
+      routes_[s] = static_cast<uint16_t>(s % config_.shard_count);
+    }
+  }
+
+  ~ShardedBookStage() {
+    Stop();
+    for (SymbolResync& resync : resync_) {
+      delete resync.snapshot.load(std::memory_order_acquire);
+    }
+  }
+
+  ShardedBookStage(const ShardedBookStage&) = delete;
+  ShardedBookStage& operator=(const ShardedBookStage&) = delete;
+
+  void Start() {
+    if (running_.exchange(true)) {
+      return;
+    }
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      shards_[i]->thread = std::thread([this, i]() {
+        if (i < config_.cores.size() && config_.cores[i] >= 0) {
+          ThreadUtils::PinToCore(config_.cores[i]);
+        }
+        if (config_.on_thread_start) {
+          config_.on_thread_start(i);
+        }
+        Run(*shards_[i]);
+      });
+    }
+  }
+
+  // Shards finish what's queued, then exit. Router thread only.
+  void Stop() {
+    if (!running_.exchange(false)) {
+      return;
+    }
+    for (auto& shard : shards_) {
+      shard->thread.join();
+    }
+  }
+
+  // Hands an update to the symbol's shard. A full ring is backpressure: the
+  // router waits rather than drop a depth update and desync the book.
+  bool Route(SymbolId symbol, const NormalizedUpdate& update) {
+    if (symbol >= routes_.size()) {
+      return false;
+    }
+    const size_t s = routes_[symbol];
+    Shard& shard = *shards_[s];
+    message_.symbol = symbol;
+    message_.update = update;
+    while (!shard.ring.TryPush(message_)) {
+      stalls_.fetch_add(1, std::memory_order_relaxed);
+      std::this_thread::yield();
+    }
+    last_push_[symbol] = ++pushed_[s];
+    ++load_[symbol];
+    return true;
+  }
+
+  // Reassigns a symbol if its current shard has caught up with it.
+  bool Move(SymbolId symbol, size_t to) {
+    if (symbol >= routes_.size() || to >= shards_.size()) {
+      return false;
+    }
+    if (routes_[symbol] == to) {
+      return true;
+    }
+    if (!Quiet(symbol)) {
+      return false;
+    }
+    routes_[symbol] = static_cast<uint16_t>(to);
+    moves_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Greedy pass over the load counted since the last call: moves the
+  // hottest quiet symbol from the busiest shard to the idlest that still
+  // narrows the gap, up to max_moves times, then starts a new window.
+  // O(symbols) per move; call it from the router when the feed is quiet.
+  size_t Rebalance() {
+    std::fill(shard_load_.begin(), shard_load_.end(), 0);
+    uint64_t total = 0;
+    for (size_t s = 0; s < routes_.size(); ++s) {
+      shard_load_[routes_[s]] += load_[s];
+      total += load_[s];
+    }
+    const double slack = config_.imbalance_threshold * static_cast<double>(total) /
+                         static_cast<double>(shards_.size());
+
+    size_t moved = 0;
+    while (moved < config_.max_moves) {
+      const auto [lo, hi] = std::minmax_element(shard_load_.begin(), shard_load_.end());
+      const size_t idlest = lo - shard_load_.begin();
+      const size_t busiest = hi - shard_load_.begin();
+      const uint64_t gap = *hi - *lo;
+      if (static_cast<double>(gap) <= slack) {
+        break;
+      }
+
+      SymbolId pick = kInvalidSymbol;
+      for (size_t s = 0; s < routes_.size(); ++s) {
+        if (routes_[s] == busiest && load_[s] > 0 && load_[s] < gap &&
+            (pick == kInvalidSymbol || load_[s] > load_[pick]) &&
+            Quiet(static_cast<SymbolId>(s))) {
+          pick = static_cast<SymbolId>(s);
+        }
+      }
+      if (pick == kInvalidSymbol) {
+        break;
+      }
+      routes_[pick] = static_cast<uint16_t>(idlest);
+      shard_load_[busiest] -= load_[pick];
+      shard_load_[idlest] += load_[pick];
+      ++moved;
+    }
+    moves_.fetch_add(moved, std::memory_order_relaxed);
+    std::fill(load_.begin(), load_.end(), 0);
+    return moved;
+  }
+
+  // Waits until every shard has applied everything routed so far. Router
+  // thread only; after it returns, Book() is safe to read until the next
+  // Route().
+  void Drain() const {
+    for (size_t s = 0; s < shards_.size(); ++s) {
+      while (shards_[s]->processed.load(std::memory_order_acquire) < pushed_[s]) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  // IntegrityFault bits the symbol's book raised since the last call, or 0.
+  // Any thread; a set bit means the book is untrusted until Reload().
+  uint32_t TakeResync(SymbolId symbol) {
+    if (symbol >= resync_.size() ||
+        resync_[symbol].reasons.load(std::memory_order_relaxed) == 0) {
+      return 0;
+    }
+    return resync_[symbol].reasons.exchange(0, std::memory_order_acquire);
+  }
+
+  // Replaces the symbol's book with snapshot before its next update. Any
+  // thread; a snapshot not yet loaded is replaced by a newer one.
+  bool Reload(SymbolId symbol, DepthSnapshot snapshot) {
+    if (symbol >= resync_.size()) {
+      return false;
+    }
+    DepthSnapshot* fresh = new DepthSnapshot(std::move(snapshot));
+    delete resync_[symbol].snapshot.exchange(fresh, std::memory_order_acq_rel);
+    return true;
+  }
+
+  // Snapshots loaded into books, and updates skipped as older than them.
+  uint64_t Reloads() const { return reloads_.load(std::memory_order_relaxed); }
+  uint64_t SkippedUpdates() const { return skipped_.load(std::memory_order_relaxed); }
+
+  // nullptr until the symbol's first update. See Drain().
+  const OrderBook* Book(SymbolId symbol) const {
+    return symbol < books_.size() ? books_[symbol].get() : nullptr;
+  }
+
+  size_t ShardOf(SymbolId symbol) const { return routes_[symbol]; }
+  size_t ShardCount() const { return shards_.size(); }
+  uint64_t ShardUpdates(size_t shard) const {
+    return shards_[shard]->processed.load(std::memory_order_relaxed);
+  }
+  // Register with a StageTraceReporter; nullptr unless tracing is on.
+  StageTraceRecorder* TraceRecorder(size_t shard) { return shards_[shard]->trace.get(); }
+  // Register with a PerfReporter; nullptr unless perf_interval is set.
+  PerfStageRecorder* PerfRecorder(size_t shard) { return shards_[shard]->perf.get(); }
+  // Register with a FlightRecorderDumper; nullptr unless flight_threshold is set.
+  FlightRecorder* Flight(size_t shard) { return shards_[shard]->flight.get(); }
+  // Safe to read from any thread
+  uint64_t Moves() const { return moves_.load(std::memory_order_relaxed); }
+  uint64_t Stalls() const { return stalls_.load(std::memory_order_relaxed); }
+
+ private:
+  struct alignas(64) Shard {
+    LockFreeRingBuffer<ShardMessage, RingSize> ring;
+    // Written only by the shard; the router reads it to know what's applied
+    alignas(64) std::atomic<uint64_t> processed{0};
+    std::thread thread;
+    std::unique_ptr<StageTraceRecorder> trace;
+    PerfCounterGroup counters;  // Opened on the shard thread
+    std::unique_ptr<PerfStageRecorder> perf;
+    std::unique_ptr<FlightRecorder> flight;
+  };
+
+  // Written by whoever reloads and the owning shard, so one per line
+  struct alignas(64) SymbolResync {
+    std::atomic<uint32_t> reasons{0};
+    std::atomic<DepthSnapshot*> snapshot{nullptr};
+    uint64_t loaded_update_id = 0;  // Owning shard only
+  };
+
+  bool Quiet(SymbolId symbol) const {
+    const Shard& owner = *shards_[routes_[symbol]];
+    return owner.processed.load(std::memory_order_acquire) >= last_push_[symbol];
+  }
+
+  void Run(Shard& shard) {
+    ShardMessage message;
+    uint64_t processed = 0;
+    if (shard.perf) {
+      shard.counters.Open();
+    }
+    while (true) {
+      if (!shard.ring.TryPop(&message)) {
+        if (running_.load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+          continue;
+        }
+        // Everything pushed before Stop() is visible now
+        if (!shard.ring.TryPop(&message)) {
+          break;
+        }
+      }
+      const size_t depth = shard.ring.Occupancy();
+      std::unique_ptr<OrderBook>& book = books_[message.symbol];
+      if (!book) {
+        // Allocated by the owning thread, so the book lands on its node
+        book = std::make_unique<OrderBook>(config_.book_config);
+      }
+      SymbolResync& resync = resync_[message.symbol];
+      if (resync.snapshot.load(std::memory_order_relaxed) != nullptr) {
+        std::unique_ptr<DepthSnapshot> snapshot(
+            resync.snapshot.exchange(nullptr, std::memory_order_acquire));
+        book->LoadSnapshot(*snapshot);
+        book->Resync().Take();  // Whatever the old book raised is moot
+        resync.loaded_update_id = snapshot->update_id;
+        reloads_.fetch_add(1, std::memory_order_relaxed);
+      }
+      if (resync.loaded_update_id != 0) {
+        if (message.update.update_id <= resync.loaded_update_id) {
+          // Already in the snapshot
+          skipped_.fetch_add(1, std::memory_order_relaxed);
+          shard.processed.store(++processed, std::memory_order_release);
+          continue;
+        }
+        resync.loaded_update_id = 0;
+      }
+      if (shard.perf) {
+        shard.perf->Begin();
+      }
+      const LevelChange change = book->ProcessUpdate(message.update);
+      if (shard.perf) {
+        shard.perf->End(TscClock::Now());
+      }
+      if (book->Resync().Pending()) {
+        resync.reasons.fetch_or(book->Resync().Take(), std::memory_order_release);
+      }
+      if (shard.trace && message.update.trace.origin != 0) {
+        const uint64_t now = TscClock::NowOrdered();
+        message.update.trace.SetDepth(Stage::BOOK_APPLIED, depth);
+        message.update.trace.Stamp(Stage::BOOK_APPLIED, now);
+        shard.trace->Record(message.update.trace, now);
+        if (shard.flight) {
+          shard.flight->Record(message.update.trace, message.symbol,
+                               message.update.update_id, now);
+        }
+      }
+      if (listener_) {
+        listener_(message.symbol, *book, change);
+      }
+      shard.processed.store(++processed, std::memory_order_release);
+    }
+  }
+
+  Config config_;
+  Listener listener_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // Each slot belongs to whichever shard the symbol is routed to
+  std::vector<std::unique_ptr<OrderBook>> books_;
+  std::vector<SymbolResync> resync_;
+  alignas(64) std::atomic<bool> running_{false};
+  std::atomic<uint64_t> reloads_{0};
+  std::atomic<uint64_t> skipped_{0};
+
+  // Router-only state
+  alignas(64) std::vector<uint16_t> routes_;  // SymbolId -> shard
+  std::vector<uint64_t> last_push_;  // Owner's push count at the symbol's last update
+  std::vector<uint64_t> load_;       // Updates per symbol this window
+  std::vector<uint64_t> pushed_;     // Per shard
+  std::vector<uint64_t> shard_load_;
+  ShardMessage message_;
+  // Written only by the router, read by stats
+  std::atomic<uint64_t> moves_{0};
+  std::atomic<uint64_t> stalls_{0};
+};
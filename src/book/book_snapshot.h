@@ -0,0 +1,175 @@
+// src/book/book_snapshot.h
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "book/order_book.h"
+
+// Fixed-size top-N copy of an OrderBook. Plain data so a publish is a
+// bounded memcpy-sized write with no allocation.
+template <size_t Depth>
+struct BookSnapshot {
+  uint64_t sequence = 0;          // Publish counter, increases by one per publish
+  uint64_t update_id = 0;         // Book update id the snapshot reflects
+  uint64_t exchange_ts = 0;
+  size_t bid_count = 0;
+  size_t ask_count = 0;
+  std::array<PriceLevel, Depth> bids{};
+  std::array<PriceLevel, Depth> asks{};
+};
+
+// Single-writer, multi-reader publication of top-N book snapshots.
+//
+// The writer (the book processing thread) fills a slot that is neither
+// published nor held by a reader, then swaps it in with one atomic store.
+// Readers pin the published slot with a per-slot reference count and then
+// re-check that it is still the published one; a slot with a non-zero count
+// is never reused, so a pinned snapshot can't change under the reader. With
+// Slots >= 3 and one reader the writer always finds a free slot; with more
+// readers a publish is skipped rather than waited on.
+//
+// Publishing is separate from OrderBook::ProcessUpdate so the update path
+// itself carries no extra work; call MaybePublish() after each update.
+template <size_t Depth, size_t Slots = 3>
+class BookSnapshotPublisher {
+  static_assert(Slots >= 2, "Need at least one spare slot to write into");
+
+  struct alignas(64) Slot {
+    std::atomic<uint32_t> readers{0};
+    alignas(64) BookSnapshot<Depth> snapshot;
+  };
+
+ public:
+  // RAII pin on a published snapshot. Keep it short-lived: while it's held
+  // the writer has one slot fewer to rotate through.
+  class ReadGuard {
+   public:
+    ReadGuard() = default;
+    explicit ReadGuard(Slot* slot) : slot_(slot) {}
+    ReadGuard(ReadGuard&& other) noexcept : slot_(other.slot_) {
+      other.slot_ = nullptr;
+    }
+    ReadGuard& operator=(ReadGuard&& other) noexcept {
+      if (this != &other) {
+        Release();
+        slot_ = other.slot_;
+        other.slot_ = nullptr;
+      }
+      return *this;
+    }
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+    ~ReadGuard() { Release(); }
+
+    explicit operator bool() const { return slot_ != nullptr; }
+    const BookSnapshot<Depth>& operator*() const { return slot_->snapshot; }
+    const BookSnapshot<Depth>* operator->() const { return &slot_->snapshot; }
+
+   private:
+    void Release() {
+      if (slot_ != nullptr) {
+        slot_->readers.fetch_sub(1, std::memory_order_release);
+        slot_ = nullptr;
+      }
+    }
+
+    Slot* slot_ = nullptr;
+  };
+
+  // interval_updates: publish automatically every N calls to MaybePublish.
+  // Zero disables periodic publishing and leaves only on-demand requests.
+  explicit BookSnapshotPublisher(uint64_t interval_updates = 0)
+      : interval_updates_(interval_updates) {}
+
+  BookSnapshotPublisher(const BookSnapshotPublisher&) = delete;
+  BookSnapshotPublisher& operator=(const BookSnapshotPublisher&) = delete;
+
+  // ==================== Writer side ====================
+
+  // Call from the processing thread after ProcessUpdate. Cheap when nothing
+  // is due: one counter increment and one relaxed load.
+  bool MaybePublish(const OrderBook& book) {
+    const bool periodic =
+        interval_updates_ != 0 && ++updates_since_publish_ >= interval_updates_;
+    if (!periodic && !requested_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    return Publish(book);
+  }
+
+  // Copies the top Depth levels into a free slot and publishes it. Returns
+  // false if every spare slot is pinned by readers.
+  bool Publish(const OrderBook& book) {
+    Slot* current = published_.load(std::memory_order_relaxed);
+    Slot* target = nullptr;
+    for (Slot& slot : slots_) {
+      // seq_cst pairs with the reader's increment-then-recheck in Acquire():
+      // either we see its pin or it sees that the slot is no longer current.
+      if (&slot != current && slot.readers.load(std::memory_order_seq_cst) == 0) {
+        target = &slot;
+        break;
+      }
+    }
+    if (target == nullptr) {
+      ++skipped_publishes_;
+      return false;
+    }
+
+    // Clear before copying so a request that lands mid-copy gets a later
+    // publish rather than this one.
+    requested_.store(false, std::memory_order_relaxed);
+    updates_since_publish_ = 0;
+
+    BookSnapshot<Depth>& snap = target->snapshot;
+    snap.sequence = ++sequence_;
+    snap.update_id = book.LastUpdateId();
+    snap.exchange_ts = book.LastExchangeTs();
+    snap.bid_count = std::min(Depth, book.Bids().size());
+    snap.ask_count = std::min(Depth, book.Asks().size());
+    std::copy_n(book.Bids().begin(), snap.bid_count, snap.bids.begin());
+    std::copy_n(book.Asks().begin(), snap.ask_count, snap.asks.begin());
+
+    published_.store(target, std::memory_order_seq_cst);
+    return true;
+  }
+
+  uint64_t SkippedPublishes() const { return skipped_publishes_; }
+
+  // ==================== Reader side ====================
+
+  // Asks the writer to publish on its next MaybePublish call.
+  void RequestSnapshot() { requested_.store(true, std::memory_order_relaxed); }
+
+  // Pins the latest published snapshot. Returns an empty guard if nothing
+  // has been published yet.
+  ReadGuard Acquire() const {
+    while (true) {
+      Slot* slot = published_.load(std::memory_order_seq_cst);
+      if (slot == nullptr) {
+        return ReadGuard();
+      }
+      slot->readers.fetch_add(1, std::memory_order_seq_cst);
+      if (published_.load(std::memory_order_seq_cst) == slot) {
+        return ReadGuard(slot);
+      }
+      // The writer swapped in a newer slot between our load and our pin and
+      // may already be reusing this one. Drop it and retry.
+      slot->readers.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+ private:
+  std::array<Slot, Slots> slots_;
+  alignas(64) std::atomic<Slot*> published_{nullptr};
+  alignas(64) std::atomic<bool> requested_{false};
+
+  // Writer-only state
+  alignas(64) uint64_t interval_updates_;
+  uint64_t updates_since_publish_ = 0;
+  uint64_t sequence_ = 0;
+  uint64_t skipped_publishes_ = 0;
+};
@@ -0,0 +1,220 @@
+// src/book/liquidity_index.h
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "book/price_level.h"
+
+// Result of walking one side of the book for a given size.
+struct FillEstimate {
+  double filled_quantity = 0.0;  // Less than requested if the side ran out
+  double notional = 0.0;
+  double average_price = 0.0;
+  double worst_price = 0.0;      // Last level touched
+  double slippage_bps = 0.0;     // Cost of average_price vs the reference price
+  size_t levels = 0;             // Levels consumed, including a partial one
+  bool complete = false;
+};
+
+// Cumulative quantity and notional per side in a Fenwick tree over the
+// level positions, so book-walk queries are a tree descent rather than a
+// walk.
+//
+// OrderBook reports every change to the retained levels. A quantity change
+// at an existing level, the bulk of a live feed's updates and most of the
+// touch's, is an O(log n) point update and keeps the tree valid. An insert
+// or erase shifts the positions behind it, so it only marks the tree valid
+// up to its index; the next query re-sums the nodes past that, only as deep
+// as it needs. Re-summing eagerly on the update path instead more than
+// doubled the bare ProcessUpdate cost in order_book_benchmark, for no gain
+// on the queries. All queries in a tick share one extension, and on a
+// bounded book it is capped by max_depth.
+//
+// Queries write the tree, so const or not they are for the book's owning
+// thread only; concurrent readers need their own copy of the book.
+class LiquidityIndex {
+ public:
+  // levels sizes the trees up front so queries don't allocate; an unbounded
+  // book that outgrows it still grows them on the next query.
+  explicit LiquidityIndex(size_t levels = 0) {
+    Grow(bids_, levels);
+    Grow(asks_, levels);
+  }
+
+  void OnLevelChange(const LevelChange& change) {
+    SideTree& tree = change.side == BookSide::BID ? bids_ : asks_;
+    if (change.action == LevelAction::UPDATE) {
+      const double delta = change.new_quantity - change.old_quantity;
+      Add(tree, change.index, delta, delta * change.price);
+      // Deltas accumulate rounding; re-sum from the levels now and then
+      if (++tree.updates >= kResumEvery) {
+        tree.valid = 0;
+        tree.updates = 0;
+      }
+    } else if (change.action != LevelAction::NONE) {
+      tree.valid = std::min(tree.valid, change.index);
+    }
+  }
+
+  void Invalidate() {
+    bids_.valid = 0;
+    asks_.valid = 0;
+  }
+
+  // Walks `levels` (one side, best-first) for `quantity`. reference is the
+  // price slippage is measured against.
+  FillEstimate Estimate(BookSide side, const std::vector<PriceLevel>& levels,
+                        double quantity, double reference) const {
+    FillEstimate estimate;
+    if (levels.empty() || quantity <= 0.0) {
+      return estimate;
+    }
+    SideTree& tree = side == BookSide::BID ? bids_ : asks_;
+    const size_t n = levels.size();
+
+    // The most levels whose cumulative quantity is still short of the
+    // request; the level after them covers it
+    Descent d = Descend(tree, quantity);
+    if (d.j == tree.valid && d.j < n) {
+      // Short within the valid levels: extend past them, summing as we go
+      Grow(tree, n);
+      while (d.j < n) {
+        const PriceLevel& level = levels[d.j];
+        ExtendOne(tree, levels);
+        if (d.qty + level.quantity >= quantity) {
+          break;
+        }
+        d.qty += level.quantity;
+        d.notional += level.price * level.quantity;
+        ++d.j;
+      }
+    }
+
+    size_t j = d.j;
+    if (j == n) {
+      // Not enough resting liquidity: everything fills
+      j = n - 1;
+      estimate.filled_quantity = d.qty;
+      estimate.notional = d.notional;
+    } else {
+      estimate.filled_quantity = quantity;
+      estimate.notional = d.notional + (quantity - d.qty) * levels[j].price;
+      estimate.complete = true;
+    }
+    estimate.levels = j + 1;
+    estimate.worst_price = levels[j].price;
+    estimate.average_price = estimate.notional / estimate.filled_quantity;
+    if (reference > 0.0) {
+      // Positive means worse than the reference for the taker
+      const double diff = side == BookSide::ASK ? estimate.average_price - reference
+                                                : reference - estimate.average_price;
+      estimate.slippage_bps = diff / reference * 10000.0;
+    }
+    return estimate;
+  }
+
+  // Total quantity on levels priced at or better than limit.
+  double QuantityUpTo(BookSide side, const std::vector<PriceLevel>& levels,
+                      double limit) const {
+    // Levels are best-first, so the in-range ones are a prefix
+    const size_t n = side == BookSide::BID
+        ? std::partition_point(levels.begin(), levels.end(),
+                               [limit](const PriceLevel& l) { return l.price >= limit; }) -
+              levels.begin()
+        : std::partition_point(levels.begin(), levels.end(),
+                               [limit](const PriceLevel& l) { return l.price <= limit; }) -
+              levels.begin();
+    SideTree& tree = side == BookSide::BID ? bids_ : asks_;
+    ExtendTo(tree, levels, n);
+    return Prefix(tree.qty, n);
+  }
+
+ private:
+  // Point updates between full re-sums of a side
+  static constexpr uint32_t kResumEvery = 4096;
+
+  // Fenwick trees, 1-based: node i sums levels (i - lowbit(i), i]. Nodes
+  // up to valid are current; each only covers positions up to itself, so
+  // they are a complete tree over the first valid levels.
+  struct SideTree {
+    std::vector<double> qty{0.0};
+    std::vector<double> notional{0.0};
+    size_t valid = 0;
+    uint32_t updates = 0;  // Point updates since the last full re-sum
+  };
+
+  // Levels before position j, and their sums.
+  struct Descent {
+    size_t j = 0;
+    double qty = 0.0;
+    double notional = 0.0;
+  };
+
+  static void Grow(SideTree& tree, size_t levels) {
+    if (tree.qty.size() < levels + 1) {
+      tree.qty.resize(levels + 1);
+      tree.notional.resize(levels + 1);
+    }
+  }
+
+  static double Prefix(const std::vector<double>& tree, size_t count) {
+    double sum = 0.0;
+    for (size_t i = count; i != 0; i &= i - 1) {
+      sum += tree[i];
+    }
+    return sum;
+  }
+
+  // Past valid the nodes are re-summed on extension anyway
+  static void Add(SideTree& tree, size_t index, double qty, double notional) {
+    for (size_t i = index + 1; i <= tree.valid; i += i & -i) {
+      tree.qty[i] += qty;
+      tree.notional[i] += notional;
+    }
+  }
+
+  // Within the valid nodes: the most levels whose total is short of target.
+  static Descent Descend(const SideTree& tree, double target) {
+    Descent d;
+    for (size_t step = std::bit_floor(tree.valid); step != 0; step >>= 1) {
+      if (d.j + step <= tree.valid && d.qty + tree.qty[d.j + step] < target) {
+        d.j += step;
+        d.qty += tree.qty[d.j];
+        d.notional += tree.notional[d.j];
+      }
+    }
+    return d;
+  }
+
+  // Each new node is its level plus the child nodes below it, all valid.
+  static void ExtendOne(SideTree& tree, const std::vector<PriceLevel>& levels) {
+    const size_t i = ++tree.valid;
+    const PriceLevel& level = levels[i - 1];
+    double qty = level.quantity;
+    double notional = level.price * level.quantity;
+    for (size_t child = 1; child < (i & -i); child <<= 1) {
+      qty += tree.qty[i - child];
+      notional += tree.notional[i - child];
+    }
+    tree.qty[i] = qty;
+    tree.notional[i] = notional;
+  }
+
+  static void ExtendTo(SideTree& tree, const std::vector<PriceLevel>& levels, size_t count) {
+    if (tree.valid >= count) {
+      return;
+    }
+    Grow(tree, levels.size());
+    while (tree.valid < count) {
+      ExtendOne(tree, levels);
+    }
+  }
+
+  // A cache over the book's levels; queries are logically const.
+  mutable SideTree bids_;
+  mutable SideTree asks_;
+};
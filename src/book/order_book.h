@@ -0,0 +1,464 @@
+// src/book/order_book.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "book/book_analytics.h"
+#include "book/book_diff.h"
+#include "book/book_integrity.h"
+#include "book/liquidity_index.h"
+#include "book/price_level.h"
+#include "models/normalized_update.h"
+
+// Price-level book for a single symbol. Each side is a contiguous array
+// sorted best-first, so the top of book is always index 0 and top-N reads
+// are a straight copy.
+//
+// With max_depth set, each side's array holds at most the best max_depth
+// levels and stays small enough to live in L1/L2. Levels beyond it are
+// evicted to a cold ordered map per side, which is only touched when an
+// update lands past the retained depth or a retained level is removed and
+// the best far level is promoted back. Bids()/Asks(), analytics, diffs and
+// snapshots see the retained levels; ForEachLevel walks the full book.
+class OrderBook {
+ public:
+  using Side = BookSide;
+
+  struct Config {
+    size_t reserve_levels = 1024;
+    // Levels retained per side in the hot arrays. Zero keeps every level
+    // in the arrays. Analytics only see retained levels, so keep this above
+    // the imbalance depth and the levels a depth band can span.
+    size_t max_depth = 0;
+    // Maintain BookAnalytics on every update. Off only for benchmarking the
+    // bare book.
+    bool analytics = true;
+    BookAnalytics::Config analytics_config;
+    // Run the online integrity checks. Off only for benchmarking. The
+    // checksum depth is clamped to max_depth: levels past it aren't in
+    // the arrays the checksum reads.
+    bool integrity = true;
+    BookIntegrity::Config integrity_config;
+    // Emit a net top-N change set per batch (see TakeDiff). Zero disables.
+    size_t diff_depth = 0;
+  };
+
+  OrderBook() : OrderBook(Config()) {}
+  explicit OrderBook(const Config& config)
+      : analytics_enabled_(config.analytics),
+        integrity_enabled_(config.integrity),
+        diff_enabled_(config.diff_depth != 0),
+        analytics_(config.analytics_config),
+        integrity_(ClampedIntegrity(config)),
+        diff_(config.diff_depth),
+        liquidity_(ReservedLevels(config)),
+        max_depth_(config.max_depth) {
+    const size_t reserve = ReservedLevels(config);
+    bids_.reserve(reserve);
+    asks_.reserve(reserve);
+  }
+
+  // Applies a single depth update. Binance depth updates carry the absolute
+  // quantity at a price; zero removes the level. Trades don't touch the book.
+  //
+  // Updates sharing an update_id form one batch (one depth event). A new
+  // update_id closes the previous batch; callers that know where a batch
+  // ends can call FinishBatch() to close it without waiting for the next.
+  //
+  // Returns what happened to the level; action is NONE for trades, dropped
+  // updates and removals of levels we don't have. For a level beyond the
+  // retained depth, index is max_depth. Evictions and promotions between
+  // the hot arrays and the far levels are internal and not reported.
+  LevelChange ProcessUpdate(const NormalizedUpdate& update) {
+    if (update.type == NormalizedUpdate::Type::TRADE) {
+      return LevelChange();
+    }
+    if (integrity_enabled_) {
+      // Stale or malformed input is dropped rather than applied.
+      if (update.update_id < last_update_id_) {
+        integrity_.Report(IntegrityFault::OUT_OF_ORDER);
+        return LevelChange();
+      }
+      if (!(update.quantity >= 0.0)) {
+        integrity_.Report(IntegrityFault::BAD_QUANTITY);
+        return LevelChange();
+      }
+    }
+    if (update.update_id != last_update_id_) {
+      FinishBatch();
+    }
+
+    LevelChange change;
+    if (update.type == NormalizedUpdate::Type::BID) {
+      change = ApplyLevel<Side::BID>(update.price, update.quantity);
+    } else {
+      change = ApplyLevel<Side::ASK>(update.price, update.quantity);
+    }
+    last_update_id_ = update.update_id;
+    last_exchange_ts_ = update.exchange_ts;
+    batch_open_ = true;
+    return change;
+  }
+
+  // Closes the current batch, runs the once-per-batch integrity checks and
+  // builds the batch's top-N diff. No-op if no update has been applied since
+  // the last call.
+  void FinishBatch() {
+    if (!batch_open_) {
+      return;
+    }
+    batch_open_ = false;
+    if (integrity_enabled_) {
+      integrity_.CheckBatch(bids_, asks_, last_update_id_);
+    }
+    FinishDiff();
+  }
+
+  // The net top-N change set of the most recently closed batch, once.
+  // Returns nullptr if diffs are disabled, nothing in the top N changed, or
+  // it was already taken. Batches close inside ProcessUpdate when the
+  // update_id moves on, so check after every ProcessUpdate and FinishBatch.
+  // The pointer is valid until the next batch closes.
+  const BookDiff* TakeDiff() {
+    if (!diff_pending_) {
+      return nullptr;
+    }
+    diff_pending_ = false;
+    return &diff_.Diff();
+  }
+
+  const BookDiffTracker& DiffTracker() const { return diff_; }
+
+  void Clear() {
+    bids_.clear();
+    asks_.clear();
+    far_bids_.clear();
+    far_asks_.clear();
+    last_update_id_ = 0;
+    last_exchange_ts_ = 0;
+    batch_open_ = false;
+    analytics_.Refresh(bids_, asks_);
+    diff_.Invalidate();
+    liquidity_.Invalidate();
+  }
+
+  // Replaces the book with a REST depth snapshot, e.g. after a resync.
+  // Levels must be best-first; empty levels are skipped.
+  void LoadSnapshot(const DepthSnapshot& snapshot) {
+    Clear();
+    for (const PriceLevel& level : snapshot.bids) {
+      if (level.quantity <= 0.0) {
+        continue;
+      }
+      if (max_depth_ == 0 || bids_.size() < max_depth_) {
+        bids_.push_back(level);
+      } else {
+        far_bids_.emplace(level.price, level.quantity);
+      }
+    }
+    for (const PriceLevel& level : snapshot.asks) {
+      if (level.quantity <= 0.0) {
+        continue;
+      }
+      if (max_depth_ == 0 || asks_.size() < max_depth_) {
+        asks_.push_back(level);
+      } else {
+        far_asks_.emplace(level.price, level.quantity);
+      }
+    }
+    last_update_id_ = snapshot.update_id;
+    analytics_.Refresh(bids_, asks_);
+    // Subscribers get the move from their old view to the snapshot at once
+    FinishDiff();
+  }
+
+  // Checks the top levels against a reference snapshot, now if the book is
+  // at the reference's update_id, otherwise when a batch lands on it.
+  void VerifyAgainst(const DepthSnapshot& reference) {
+    integrity_.SetReference(reference, last_update_id_);
+    if (!batch_open_) {
+      integrity_.CheckReference(bids_, asks_, last_update_id_);
+    }
+  }
+
+  const std::vector<PriceLevel>& Bids() const { return bids_; }
+  const std::vector<PriceLevel>& Asks() const { return asks_; }
+  const std::vector<PriceLevel>& Levels(Side side) const {
+    return side == Side::BID ? bids_ : asks_;
+  }
+
+  // Visits every level on a side best-first: retained levels, then far ones.
+  template <typename Fn>
+  void ForEachLevel(Side side, Fn&& fn) const {
+    for (const PriceLevel& level : Levels(side)) {
+      fn(level);
+    }
+    if (side == Side::BID) {
+      for (auto it = far_bids_.rbegin(); it != far_bids_.rend(); ++it) {
+        fn(PriceLevel{it->first, it->second});
+      }
+    } else {
+      for (const auto& [price, quantity] : far_asks_) {
+        fn(PriceLevel{price, quantity});
+      }
+    }
+  }
+
+  size_t MaxDepth() const { return max_depth_; }
+  size_t FarLevels(Side side) const {
+    return side == Side::BID ? far_bids_.size() : far_asks_.size();
+  }
+  // Levels moved out of / back into the retained depth, and updates that
+  // landed past it.
+  uint64_t Evictions() const { return evictions_; }
+  uint64_t Promotions() const { return promotions_; }
+  uint64_t FarUpdates() const { return far_updates_; }
+
+  bool HasBid() const { return !bids_.empty(); }
+  bool HasAsk() const { return !asks_.empty(); }
+  // Callers must check HasBid()/HasAsk() first.
+  const PriceLevel& BestBid() const { return bids_.front(); }
+  const PriceLevel& BestAsk() const { return asks_.front(); }
+
+  uint64_t LastUpdateId() const { return last_update_id_; }
+  uint64_t LastExchangeTs() const { return last_exchange_ts_; }
+
+  // Cost of taking `quantity` now: buying lifts the asks, selling hits the
+  // bids. Slippage is against mid (the touch if the book is one-sided).
+  // Only retained levels count, so on a bounded book a large size can come
+  // back incomplete before the real book runs out. These and
+  // QuantityWithinBps update a cache: owning thread only.
+  FillEstimate EstimateBuy(double quantity) const {
+    return liquidity_.Estimate(Side::ASK, asks_, quantity, ReferencePrice());
+  }
+  FillEstimate EstimateSell(double quantity) const {
+    return liquidity_.Estimate(Side::BID, bids_, quantity, ReferencePrice());
+  }
+
+  // Resting quantity on one side priced within bps of mid (or the touch if
+  // one-sided).
+  double QuantityWithinBps(Side side, double bps) const {
+    const double reference = ReferencePrice();
+    if (reference <= 0.0) {
+      return 0.0;
+    }
+    const double offset = reference * bps / 10000.0;
+    return side == Side::BID
+        ? liquidity_.QuantityUpTo(side, bids_, reference - offset)
+        : liquidity_.QuantityUpTo(side, asks_, reference + offset);
+  }
+
+  // Spread, mid, microprice, imbalance and band depth; every read is O(1).
+  const BookAnalytics& Analytics() const { return analytics_; }
+
+  const BookIntegrity& Integrity() const { return integrity_; }
+  // Raised when the book needs rebuilding from a fresh snapshot. Safe to
+  // poll and Take() from another thread.
+  ResyncSignal& Resync() { return integrity_.Signal(); }
+
+ private:
+  // One spare slot for the insert that precedes an eviction
+  static size_t ReservedLevels(const Config& config) {
+    return config.max_depth != 0 ? config.max_depth + 1 : config.reserve_levels;
+  }
+
+  static BookIntegrity::Config ClampedIntegrity(const Config& config) {
+    BookIntegrity::Config integrity = config.integrity_config;
+    if (config.max_depth != 0) {
+      integrity.checksum_depth = std::min(integrity.checksum_depth, config.max_depth);
+    }
+    return integrity;
+  }
+
+  double ReferencePrice() const {
+    if (!bids_.empty() && !asks_.empty()) {
+      return 0.5 * (bids_.front().price + asks_.front().price);
+    }
+    if (!bids_.empty()) {
+      return bids_.front().price;
+    }
+    return asks_.empty() ? 0.0 : asks_.front().price;
+  }
+
+  // True if price a sits closer to the touch than price b on this side.
+  template <Side S>
+  static bool Better(double a, double b) {
+    if constexpr (S == Side::BID) {
+      return a > b;
+    } else {
+      return a < b;
+    }
+  }
+
+  template <Side S>
+  LevelChange ApplyLevel(double price, double quantity) {
+    std::vector<PriceLevel>& levels = S == Side::BID ? bids_ : asks_;
+
+    // Activity clusters at the touch, so a forward scan beats a binary
+    // search for the depths we keep.
+    size_t i = 0;
+    const size_t n = levels.size();
+    while (i < n && Better<S>(levels[i].price, price)) {
+      ++i;
+    }
+
+    // Far levels only exist while the retained depth is full
+    if (i == max_depth_ && max_depth_ != 0) {
+      return ApplyFarLevel<S>(price, quantity);
+    }
+
+    const bool found = i < n && levels[i].price == price;
+    LevelChange change;
+    change.side = S;
+    change.index = i;
+    change.price = price;
+    if (quantity <= 0.0) {
+      if (!found) {
+        return change;
+      }
+      change.action = LevelAction::ERASE;
+      change.old_quantity = levels[i].quantity;
+      levels.erase(levels.begin() + i);
+    } else if (found) {
+      change.action = LevelAction::UPDATE;
+      change.old_quantity = levels[i].quantity;
+      change.new_quantity = quantity;
+      levels[i].quantity = quantity;
+    } else {
+      change.action = LevelAction::INSERT;
+      change.new_quantity = quantity;
+      levels.insert(levels.begin() + i, PriceLevel{price, quantity});
+    }
+    NotifyRetained<S>(change);
+
+    if (max_depth_ != 0) {
+      if (levels.size() > max_depth_) {
+        Evict<S>();
+      } else if (change.action == LevelAction::ERASE) {
+        Promote<S>();
+      }
+    }
+    return change;
+  }
+
+  // Tells the per-update trackers about a change to the retained levels.
+  template <Side S>
+  void NotifyRetained(const LevelChange& change) {
+    if (analytics_enabled_) {
+      analytics_.OnLevelChange<S == Side::BID>(bids_, asks_, change);
+    }
+    if (diff_enabled_) {
+      diff_.OnLevelChange(change);
+    }
+    liquidity_.OnLevelChange(change);
+  }
+
+  template <Side S>
+  std::map<double, double>& FarLevelsOf() {
+    return S == Side::BID ? far_bids_ : far_asks_;
+  }
+
+  // Cold path: an update beyond the retained depth.
+  template <Side S>
+  LevelChange ApplyFarLevel(double price, double quantity) {
+    std::map<double, double>& far = FarLevelsOf<S>();
+    LevelChange change;
+    change.side = S;
+    change.index = max_depth_;
+    change.price = price;
+    ++far_updates_;
+
+    auto it = far.find(price);
+    if (quantity <= 0.0) {
+      if (it == far.end()) {
+        return change;
+      }
+      change.action = LevelAction::ERASE;
+      change.old_quantity = it->second;
+      far.erase(it);
+    } else if (it != far.end()) {
+      change.action = LevelAction::UPDATE;
+      change.old_quantity = it->second;
+      change.new_quantity = quantity;
+      it->second = quantity;
+    } else {
+      change.action = LevelAction::INSERT;
+      change.new_quantity = quantity;
+      far.emplace(price, quantity);
+    }
+    return change;
+  }
+
+  // Moves the worst retained level out to the far levels.
+  template <Side S>
+  void Evict() {
+    std::vector<PriceLevel>& levels = S == Side::BID ? bids_ : asks_;
+    const PriceLevel worst = levels.back();
+    levels.pop_back();
+    FarLevelsOf<S>().emplace(worst.price, worst.quantity);
+    ++evictions_;
+
+    LevelChange change;
+    change.side = S;
+    change.action = LevelAction::ERASE;
+    change.index = levels.size();
+    change.price = worst.price;
+    change.old_quantity = worst.quantity;
+    NotifyRetained<S>(change);
+  }
+
+  // Refills the retained depth with the best far level after a removal.
+  template <Side S>
+  void Promote() {
+    std::map<double, double>& far = FarLevelsOf<S>();
+    if (far.empty()) {
+      return;
+    }
+    auto best = S == Side::BID ? std::prev(far.end()) : far.begin();
+    std::vector<PriceLevel>& levels = S == Side::BID ? bids_ : asks_;
+    levels.push_back(PriceLevel{best->first, best->second});
+    far.erase(best);
+    ++promotions_;
+
+    LevelChange change;
+    change.side = S;
+    change.action = LevelAction::INSERT;
+    change.index = levels.size() - 1;
+    change.price = levels.back().price;
+    change.new_quantity = levels.back().quantity;
+    NotifyRetained<S>(change);
+  }
+
+  void FinishDiff() {
+    if (diff_enabled_ && diff_.Finish(bids_, asks_, last_update_id_)) {
+      diff_pending_ = true;
+    }
+  }
+
+  std::vector<PriceLevel> bids_;  // Descending by price
+  std::vector<PriceLevel> asks_;  // Ascending by price
+  uint64_t last_update_id_ = 0;
+  uint64_t last_exchange_ts_ = 0;
+  bool batch_open_ = false;
+  bool analytics_enabled_;
+  bool integrity_enabled_;
+  bool diff_enabled_;
+  bool diff_pending_ = false;
+  BookAnalytics analytics_;
+  BookIntegrity integrity_;
+  BookDiffTracker diff_;
+  LiquidityIndex liquidity_;
+
+  // Levels beyond max_depth, keyed by price ascending on both sides
+  size_t max_depth_;
+  std::map<double, double> far_bids_;
+  std::map<double, double> far_asks_;
+  uint64_t evictions_ = 0;
+  uint64_t promotions_ = 0;
+  uint64_t far_updates_ = 0;
+};
@@ -0,0 +1,25 @@
+// src/book/price_level.h
+#pragma once
+
+#include <cstddef>
+
+struct PriceLevel {
+  double price;
+  double quantity;
+};
+
+enum class BookSide { BID, ASK };
+
+// What a single depth update did to one side of the book.
+enum class LevelAction { NONE, INSERT, UPDATE, ERASE };
+
+// Reported by OrderBook::ProcessUpdate for every applied update, so views
+// kept next to the book can update from the delta without a lookup.
+struct LevelChange {
+  BookSide side = BookSide::BID;
+  LevelAction action = LevelAction::NONE;
+  size_t index = 0;           // Position best-first; for ERASE, where it was
+  double price = 0.0;
+  double old_quantity = 0.0;  // Zero for INSERT
+  double new_quantity = 0.0;  // Zero for ERASE
+};
@@ -0,0 +1,250 @@
+// src/book/queue_position.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "book/order_book.h"
+#include "book/price_level.h"
+#include "models/normalized_update.h"
+
+// One of our own resting orders, real or hypothetical, with its estimated
+// place in the price level's FIFO queue.
+struct OwnOrder {
+  BookSide side = BookSide::BID;
+  double price = 0.0;
+  double quantity = 0.0;
+  double filled = 0.0;          // Estimated, from trade prints reaching us
+  double queue_ahead = 0.0;     // Resting quantity estimated in front of us
+  double initial_ahead = 0.0;   // queue_ahead when the order joined
+  double level_quantity = 0.0;  // Last seen total at our price
+  double traded_at_price = 0.0; // Trade volume printed at our price since joining
+  bool active = false;
+
+  double Remaining() const { return quantity - filled; }
+
+  // 0 when we joined, 1 at the front of the queue.
+  double QueueProgress() const {
+    return initial_ahead > 0.0 ? 1.0 - queue_ahead / initial_ahead : 1.0;
+  }
+};
+
+// Estimates queue position for our orders from the level changes OrderBook
+// reports and from trade prints.
+//
+// Depth updates only carry a level's total, so when it shrinks we don't know
+// whose quantity left. Trade prints at our price come off the front of the
+// queue and are remembered so the depth decrease that follows isn't counted
+// twice. Whatever decrease is left is a cancel, split between ahead of and
+// behind us by the configured model. Increases always join behind us.
+//
+// Orders are indexed by (side, price), so each level change or trade costs
+// one hash lookup plus the orders we have at that price.
+class QueuePositionEstimator {
+ public:
+  using OrderId = uint32_t;
+  static constexpr OrderId kInvalidOrder = 0xffffffff;
+
+  enum class CancelModel {
+    PESSIMISTIC,   // Cancels come from behind us; only trades move us up
+    OPTIMISTIC,    // Cancels come from in front of us
+    PROPORTIONAL,  // Split by how much quantity is ahead vs behind
+  };
+
+  struct Config {
+    CancelModel model = CancelModel::PROPORTIONAL;
+    // Real orders are part of the level quantity the book reports;
+    // hypothetical ones are not.
+    bool orders_in_book = false;
+    size_t capacity = 256;
+  };
+
+  QueuePositionEstimator() : QueuePositionEstimator(Config()) {}
+  explicit QueuePositionEstimator(const Config& config) : config_(config) {
+    orders_.reserve(config.capacity);
+    slots_.reserve(config.capacity);
+    bids_.reserve(config.capacity);
+    asks_.reserve(config.capacity);
+  }
+
+  // Places an order at the back of the queue at its price. With
+  // orders_in_book, call it once the book's level includes the order: its
+  // own quantity isn't counted as ahead of it.
+  OrderId AddOrder(const OrderBook& book, BookSide side, double price, double quantity) {
+    OrderId id;
+    if (!free_.empty()) {
+      id = free_.back();
+      free_.pop_back();
+    } else {
+      id = static_cast<OrderId>(orders_.size());
+      orders_.emplace_back();
+      slots_.emplace_back();
+    }
+
+    OwnOrder& order = orders_[id];
+    order = OwnOrder();
+    order.side = side;
+    order.price = price;
+    order.quantity = quantity;
+    order.level_quantity = LevelQuantity(book, side, price);
+    const double own = config_.orders_in_book ? order.Remaining() : 0.0;
+    order.queue_ahead = std::max(0.0, order.level_quantity - own);
+    order.initial_ahead = order.queue_ahead;
+    order.active = true;
+
+    // Link at the head of the price's list
+    Slot& slot = slots_[id];
+    auto& index = IndexFor(side);
+    auto [it, inserted] = index.try_emplace(price, id);
+    slot.next = inserted ? kInvalidOrder : it->second;
+    slot.pending_trade = 0.0;
+    it->second = id;
+    return id;
+  }
+
+  void RemoveOrder(OrderId id) {
+    if (id >= orders_.size() || !orders_[id].active) {
+      return;
+    }
+    OwnOrder& order = orders_[id];
+    auto& index = IndexFor(order.side);
+    auto it = index.find(order.price);
+    if (it != index.end()) {
+      if (it->second == id) {
+        if (slots_[id].next == kInvalidOrder) {
+          index.erase(it);
+        } else {
+          it->second = slots_[id].next;
+        }
+      } else {
+        for (OrderId prev = it->second; prev != kInvalidOrder; prev = slots_[prev].next) {
+          if (slots_[prev].next == id) {
+            slots_[prev].next = slots_[id].next;
+            break;
+          }
+        }
+      }
+    }
+    order.active = false;
+    free_.push_back(id);
+  }
+
+  // Feed every LevelChange OrderBook::ProcessUpdate returns.
+  void OnLevelChange(const LevelChange& change) {
+    if (change.action == LevelAction::NONE) {
+      return;
+    }
+    auto& index = IndexFor(change.side);
+    auto it = index.find(change.price);
+    if (it == index.end()) {
+      return;
+    }
+    for (OrderId id = it->second; id != kInvalidOrder; id = slots_[id].next) {
+      ApplyLevelChange(orders_[id], slots_[id], change.new_quantity);
+    }
+  }
+
+  // Feed TRADE updates. Binance trade prints don't say which side rested,
+  // so a print at our price counts against orders on either side there.
+  void OnTrade(const NormalizedUpdate& trade) {
+    if (trade.type != NormalizedUpdate::Type::TRADE) {
+      return;
+    }
+    for (auto* index : {&bids_, &asks_}) {
+      auto it = index->find(trade.price);
+      if (it == index->end()) {
+        continue;
+      }
+      for (OrderId id = it->second; id != kInvalidOrder; id = slots_[id].next) {
+        OwnOrder& order = orders_[id];
+        const double from_ahead = std::min(trade.quantity, order.queue_ahead);
+        order.queue_ahead -= from_ahead;
+        order.filled = std::min(order.quantity,
+                                order.filled + (trade.quantity - from_ahead));
+        order.traded_at_price += trade.quantity;
+        slots_[id].pending_trade += trade.quantity;
+      }
+    }
+  }
+
+  // nullptr for unknown or removed orders.
+  const OwnOrder* Find(OrderId id) const {
+    return id < orders_.size() && orders_[id].active ? &orders_[id] : nullptr;
+  }
+
+  const Config& GetConfig() const { return config_; }
+
+ private:
+  struct Slot {
+    OrderId next = kInvalidOrder;  // Next order at the same side and price
+    double pending_trade = 0.0;    // Printed volume not yet seen in depth
+  };
+
+  std::unordered_map<double, OrderId>& IndexFor(BookSide side) {
+    return side == BookSide::BID ? bids_ : asks_;
+  }
+
+  static double LevelQuantity(const OrderBook& book, BookSide side, double price) {
+    double quantity = 0.0;
+    book.ForEachLevel(side, [&](const PriceLevel& level) {
+      if (level.price == price) {
+        quantity = level.quantity;
+      }
+    });
+    return quantity;
+  }
+
+  void ApplyLevelChange(OwnOrder& order, Slot& slot, double new_level) {
+    const double old_level = order.level_quantity;
+    order.level_quantity = new_level;
+    const double own = config_.orders_in_book ? order.Remaining() : 0.0;
+
+    if (new_level <= own) {
+      // Everyone else at the price is gone
+      order.queue_ahead = 0.0;
+      slot.pending_trade = 0.0;
+      return;
+    }
+    if (new_level >= old_level) {
+      // Growth joins the back of the queue
+      return;
+    }
+
+    // Decreases already explained by trade prints were taken off the front
+    // when the print arrived.
+    double decrease = old_level - new_level;
+    const double traded = std::min(decrease, slot.pending_trade);
+    slot.pending_trade -= traded;
+    decrease -= traded;
+
+    if (decrease > 0.0) {
+      double from_ahead = 0.0;
+      switch (config_.model) {
+        case CancelModel::PESSIMISTIC:
+          break;
+        case CancelModel::OPTIMISTIC:
+          from_ahead = decrease;
+          break;
+        case CancelModel::PROPORTIONAL: {
+          const double behind = std::max(0.0, old_level - order.queue_ahead - own);
+          const double others = order.queue_ahead + behind;
+          from_ahead = others > 0.0 ? decrease * order.queue_ahead / others : 0.0;
+          break;
+        }
+      }
+      order.queue_ahead = std::max(0.0, order.queue_ahead - from_ahead);
+    }
+    // Can't have more ahead of us than the level holds
+    order.queue_ahead = std::min(order.queue_ahead, new_level - own);
+  }
+
+  Config config_;
+  std::vector<OwnOrder> orders_;
+  std::vector<Slot> slots_;
+  std::vector<OrderId> free_;
+  std::unordered_map<double, OrderId> bids_;  // Price -> first order there
+  std::unordered_map<double, OrderId> asks_;
+};
@@ -0,0 +1,314 @@
+// src/core/cpu_topology.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Where one logical CPU sits. Ids other than cpu and node are dense indices
+// into the topology, not kernel numbers; -1 where sysfs didn't say.
+struct CpuInfo {
+  int cpu = -1;      // Kernel CPU number, as PinToCore() takes it
+  int package = -1;  // Socket
+  int node = -1;     // Kernel NUMA node number, as mbind takes it
+  int core = -1;     // Physical core; SMT siblings share it
+  int l2 = -1;       // L2 domain
+  int l3 = -1;       // Last-level cache domain
+};
+
+// Online CPUs and what they share, read from sysfs: sockets, NUMA nodes,
+// physical cores (SMT siblings), L2 and L3 domains. Discovery is a few
+// hundred small file reads, so do it once at startup.
+class CpuTopology {
+ public:
+  // root is /sys/devices/system normally; tests point it at a fake tree.
+  // Empty if root has no cpu/online.
+  static CpuTopology Discover(const std::string& root = "/sys/devices/system") {
+    CpuTopology topology;
+    std::vector<int> online;
+    if (!ParseList(ReadLine(root + "/cpu/online"), &online)) {
+      return topology;
+    }
+    std::map<int, int> node_of;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(root + "/node", error)) {
+      const std::string name = entry.path().filename().string();
+      std::vector<int> cpus;
+      if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+          name.find_first_not_of("0123456789", 4) != std::string::npos ||
+          !ParseList(ReadLine(entry.path().string() + "/cpulist"), &cpus)) {
+        continue;
+      }
+      for (int cpu : cpus) {
+        node_of[cpu] = std::stoi(name.substr(4));
+      }
+    }
+
+    // Shared things are keyed by their lowest member, then made dense
+    std::map<std::pair<int, int>, int> cores;
+    std::map<int, int> packages, nodes, l2s, l3s;
+    auto dense = [](auto& ids, const auto& key) {
+      return ids.emplace(key, static_cast<int>(ids.size())).first->second;
+    };
+    for (int cpu : online) {
+      const std::string dir = root + "/cpu/cpu" + std::to_string(cpu);
+      CpuInfo info;
+      info.cpu = cpu;
+      const int package = ReadInt(dir + "/topology/physical_package_id", 0);
+      info.package = dense(packages, package);
+      info.core = dense(cores, std::make_pair(package, ReadInt(dir + "/topology/core_id", cpu)));
+      const auto node = node_of.find(cpu);
+      info.node = node == node_of.end() ? 0 : node->second;
+      dense(nodes, info.node);
+      for (int index = 0;; ++index) {
+        const std::string cache = dir + "/cache/index" + std::to_string(index);
+        const int level = ReadInt(cache + "/level", -1);
+        if (level < 0) {
+          break;
+        }
+        std::vector<int> shared;
+        if (ReadLine(cache + "/type") == "Instruction" ||
+            !ParseList(ReadLine(cache + "/shared_cpu_list"), &shared)) {
+          continue;
+        }
+        if (level == 2) {
+          info.l2 = dense(l2s, shared.front());
+        } else if (level == 3) {
+          info.l3 = dense(l3s, shared.front());
+        }
+      }
+      topology.cpus_.push_back(info);
+    }
+    topology.packages_ = packages.size();
+    topology.nodes_ = nodes.size();
+    topology.cores_ = cores.size();
+    topology.l3s_ = l3s.size();
+    return topology;
+  }
+
+  // Kernel CPU list format: "0-3,8,10-11". False if malformed or empty.
+  static bool ParseList(const std::string& text, std::vector<int>* out) {
+    out->clear();
+    std::stringstream ranges(text);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+      int first = 0;
+      int last = 0;
+      char dash = 0;
+      std::stringstream parse(range);
+      if (!(parse >> first)) {
+        return false;
+      }
+      last = first;
+      if (parse >> dash && (dash != '-' || !(parse >> last) || last < first)) {
+        return false;
+      }
+      for (int cpu = first; cpu <= last; ++cpu) {
+        out->push_back(cpu);
+      }
+    }
+    return !out->empty();
+  }
+
+  bool Empty() const { return cpus_.empty(); }
+  const std::vector<CpuInfo>& Cpus() const { return cpus_; }
+  size_t PackageCount() const { return packages_; }
+  size_t NodeCount() const { return nodes_; }
+  size_t CoreCount() const { return cores_; }
+  size_t L3Count() const { return l3s_; }
+
+  // nullptr if the CPU isn't online.
+  const CpuInfo* Find(int cpu) const {
+    for (const CpuInfo& info : cpus_) {
+      if (info.cpu == cpu) {
+        return &info;
+      }
+    }
+    return nullptr;
+  }
+
+  // Other logical CPUs on the same physical core.
+  std::vector<int> Siblings(int cpu) const {
+    std::vector<int> out;
+    const CpuInfo* self = Find(cpu);
+    for (const CpuInfo& info : cpus_) {
+      if (self != nullptr && info.core == self->core && info.cpu != cpu) {
+        out.push_back(info.cpu);
+      }
+    }
+    return out;
+  }
+
+  // "2 packages, 2 nodes, 8 cores, 16 cpus, 2 L3"
+  std::string Describe() const {
+    return std::to_string(packages_) + " packages, " + std::to_string(nodes_) + " nodes, " +
+           std::to_string(cores_) + " cores, " + std::to_string(cpus_.size()) + " cpus, " +
+           std::to_string(l3s_) + " L3";
+  }
+
+ private:
+  static std::string ReadLine(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+  }
+
+  static int ReadInt(const std::string& path, int fallback) {
+    const std::string line = ReadLine(path);
+    try {
+      return line.empty() ? fallback : std::stoi(line);
+    } catch (const std::exception&) {
+      return fallback;
+    }
+  }
+
+  std::vector<CpuInfo> cpus_;
+  size_t packages_ = 0;
+  size_t nodes_ = 0;
+  size_t cores_ = 0;
+  size_t l3s_ = 0;
+};
+
+// Assigns a pipeline's threads to CPUs. Stages are added in pipeline order,
+// each talking to the one before it, and are placed along that chain:
+// - one thread per physical core, never two pipeline threads on SMT
+//   siblings, and never next to a housekeeping CPU;
+// - the whole chain in one L3 domain if it fits, starting with the
+//   domain with the most free cores, and spilling to the domains of the
+//   same NUMA node before crossing to another;
+// - within a domain, cores sharing an L2 next to each other, so adjacent
+//   stages share one where the hardware has it.
+// Plan() fails rather than doubling up; run unpinned in that case.
+class PlacementPlanner {
+ public:
+  struct Config {
+    // CPUs left for the OS, the stats thread and exporters. Their SMT
+    // siblings are left alone too.
+    std::vector<int> housekeeping = {0};
+  };
+
+  PlacementPlanner(const CpuTopology& topology, const Config& config)
+      : topology_(topology), config_(config) {}
+  explicit PlacementPlanner(const CpuTopology& topology)
+      : PlacementPlanner(topology, Config()) {}
+
+  // Returns the stage index for Core().
+  size_t AddStage(const std::string& name, size_t threads = 1) {
+    stages_.push_back({name, threads, {}});
+    return stages_.size() - 1;
+  }
+
+  // False, with nothing assigned, if there aren't enough free cores.
+  bool Plan() {
+    for (Stage& stage : stages_) {
+      stage.cpus.clear();
+    }
+    size_t needed = 0;
+    for (const Stage& stage : stages_) {
+      needed += stage.threads;
+    }
+
+    // One candidate CPU per free physical core: its lowest sibling
+    std::vector<int> busy_cores;
+    for (int cpu : config_.housekeeping) {
+      if (const CpuInfo* info = topology_.Find(cpu)) {
+        busy_cores.push_back(info->core);
+      }
+    }
+    std::map<int, const CpuInfo*> by_core;
+    for (const CpuInfo& info : topology_.Cpus()) {
+      if (std::find(busy_cores.begin(), busy_cores.end(), info.core) == busy_cores.end() &&
+          by_core.find(info.core) == by_core.end()) {
+        by_core[info.core] = &info;
+      }
+    }
+    if (needed == 0) {
+      return true;
+    }
+    if (by_core.size() < needed) {
+      error_ = "need " + std::to_string(needed) + " free cores, have " +
+               std::to_string(by_core.size()) + " (" + topology_.Describe() + ")";
+      return false;
+    }
+
+    std::map<int, std::vector<const CpuInfo*>> domains;  // By L3
+    for (const auto& [core, info] : by_core) {
+      domains[info->l3].push_back(info);
+    }
+    std::vector<std::vector<const CpuInfo*>*> order;
+    for (auto& [l3, cpus] : domains) {
+      std::sort(cpus.begin(), cpus.end(), [](const CpuInfo* a, const CpuInfo* b) {
+        return std::make_pair(a->l2, a->cpu) < std::make_pair(b->l2, b->cpu);
+      });
+      order.push_back(&cpus);
+    }
+    // Largest domain first (lowest numbered on a tie), then the rest of
+    // its node, largest first
+    std::stable_sort(order.begin(), order.end(), [](const auto* a, const auto* b) {
+      return a->size() > b->size();
+    });
+    const int home_node = order.front()->front()->node;
+    std::stable_sort(order.begin(), order.end(), [home_node](const auto* a, const auto* b) {
+      return (a->front()->node == home_node) > (b->front()->node == home_node);
+    });
+
+    std::vector<int> chain;
+    for (const auto* cpus : order) {
+      for (const CpuInfo* info : *cpus) {
+        chain.push_back(info->cpu);
+      }
+    }
+    size_t next = 0;
+    for (Stage& stage : stages_) {
+      for (size_t i = 0; i < stage.threads; ++i) {
+        stage.cpus.push_back(chain[next++]);
+      }
+    }
+    error_.clear();
+    return true;
+  }
+
+  // The CPU for a stage's thread, or -1 before a successful Plan().
+  int Core(size_t stage, size_t thread = 0) const {
+    const std::vector<int>& cpus = stages_[stage].cpus;
+    return thread < cpus.size() ? cpus[thread] : -1;
+  }
+
+  const std::vector<int>& Cores(size_t stage) const { return stages_[stage].cpus; }
+  const std::vector<int>& Housekeeping() const { return config_.housekeeping; }
+  const std::string& Error() const { return error_; }
+
+  // One line per stage: "normalize: 4", "book: 5,6,7,8".
+  std::string Describe() const {
+    std::string out;
+    for (const Stage& stage : stages_) {
+      out += stage.name + ":";
+      for (size_t i = 0; i < stage.cpus.size(); ++i) {
+        out += i == 0 ? " " : ",";
+        out += std::to_string(stage.cpus[i]);
+      }
+      out += "\n";
+    }
+    return out;
+  }
+
+ private:
+  struct Stage {
+    std::string name;
+    size_t threads;
+    std::vector<int> cpus;
+  };
+
+  const CpuTopology& topology_;
+  Config config_;
+  std::vector<Stage> stages_;
+  std::string error_;
+};
@@ -0,0 +1,276 @@
+// src/core/flight_recorder.h
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "core/stage_trace.h"
+#include "core/thread_utils.h"
+#include "core/tsc_clock.h"
+
+// One traced message as the flight recorder keeps it.
+struct FlightEvent {
+  StageTrace trace;
+  uint64_t update_id = 0;
+  uint32_t symbol = 0;
+};
+
+// Always-on ring of the last few thousand traced messages on one thread,
+// dumped to a file when one of them is an outlier.
+//
+// Record() is an 80-byte copy into the ring and a compare: no allocation, no
+// I/O, nothing shared with other writers. When a message's end-to-end
+// latency reaches the threshold the recorder only notes the ring position;
+// a FlightRecorderDumper thread copies the events before it and writes them
+// out. The ring holds twice the dump size, so the writer can run on for
+// dump_events more messages before it overwrites what is being copied;
+// events it did overwrite by then are left out of the dump rather than
+// written torn. Slots are written and read a word at a time through
+// atomic_ref, seqlock-style: the writer claims a slot by advancing head
+// before touching it, and the dumper checks head after copying. Further
+// outliers during a dump or the cooldown after it are counted, not dumped.
+class FlightRecorder {
+ public:
+  struct Config {
+    std::string name = "flight";  // File name prefix
+    uint64_t threshold_ticks = 0;  // End-to-end latency that triggers a dump
+    size_t dump_events = 1024;     // Events before and including the outlier
+    uint64_t cooldown_ticks = 0;   // Minimum gap between dumps
+  };
+
+  explicit FlightRecorder(const Config& config)
+      : config_(config),
+        capacity_(std::bit_ceil(std::max<size_t>(2 * config.dump_events, 2))),
+        slots_(capacity_) {}
+
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  // Writer thread. Traces without RECEIVE stamped are ignored.
+  void Record(const StageTrace& trace, uint32_t symbol, uint64_t update_id, uint64_t now) {
+    if (trace.origin == 0) {
+      return;
+    }
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    // Claim the slot before overwriting it: a dumper that reads any of the
+    // new words also sees the new head, and drops the old event
+    head_.store(head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    FlightEvent event;
+    event.trace = trace;
+    event.symbol = symbol;
+    event.update_id = update_id;
+    Store(slots_[head & (capacity_ - 1)], event);
+
+    if (config_.threshold_ticks == 0 || now - trace.origin < config_.threshold_ticks) {
+      return;
+    }
+    const uint64_t requested = requested_.load(std::memory_order_relaxed);
+    if (done_.load(std::memory_order_acquire) != requested || now < next_dump_at_) {
+      ++suppressed_;
+      return;
+    }
+    trigger_head_ = head + 1;
+    trigger_ticks_ = now;
+    next_dump_at_ = now + config_.cooldown_ticks;
+    requested_.store(requested + 1, std::memory_order_release);
+  }
+
+  // Dumper thread: copies the events before a pending trigger into out,
+  // oldest first. False if nothing is pending.
+  bool TakeDump(std::vector<FlightEvent>* out, uint64_t* trigger_ticks) {
+    const uint64_t requested = requested_.load(std::memory_order_acquire);
+    if (requested == done_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    const uint64_t end = trigger_head_;
+    const uint64_t begin = end - std::min<uint64_t>(end, config_.dump_events);
+    *trigger_ticks = trigger_ticks_;
+    out->clear();
+    for (uint64_t i = begin; i < end; ++i) {
+      out->push_back(Load(slots_[i & (capacity_ - 1)]));
+    }
+    // Anything the writer has claimed a slot over since may have changed
+    // mid-copy: event i is gone once event i + capacity was claimed
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    const uint64_t first_intact = head >= capacity_ ? head - capacity_ : 0;
+    if (first_intact > begin) {
+      out->erase(out->begin(), out->begin() + static_cast<ptrdiff_t>(
+                                                   std::min(first_intact, end) - begin));
+    }
+    done_.store(requested, std::memory_order_release);
+    return true;
+  }
+
+  const Config& GetConfig() const { return config_; }
+  uint64_t Recorded() const { return head_.load(std::memory_order_relaxed); }
+  // Writer-side count of outliers that didn't get their own dump.
+  uint64_t Suppressed() const { return suppressed_; }
+
+ private:
+  static_assert(std::is_trivially_copyable_v<FlightEvent>);
+  static constexpr size_t kSlotWords = (sizeof(FlightEvent) + 7) / 8;
+  struct Slot {
+    uint64_t words[kSlotWords];
+  };
+
+  static void Store(Slot& slot, const FlightEvent& event) {
+    uint64_t words[kSlotWords] = {};
+    std::memcpy(words, &event, sizeof(event));
+    for (size_t i = 0; i < kSlotWords; ++i) {
+      std::atomic_ref<uint64_t>(slot.words[i]).store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  static FlightEvent Load(Slot& slot) {
+    uint64_t words[kSlotWords];
+    for (size_t i = 0; i < kSlotWords; ++i) {
+      words[i] = std::atomic_ref<uint64_t>(slot.words[i]).load(std::memory_order_relaxed);
+    }
+    FlightEvent event;
+    std::memcpy(&event, words, sizeof(event));
+    return event;
+  }
+
+  const Config config_;
+  const size_t capacity_;
+  std::vector<Slot> slots_;
+
+  // Writer-only, apart from the trigger fields the dumper reads after
+  // acquiring requested_
+  alignas(64) std::atomic<uint64_t> head_{0};
+  uint64_t trigger_head_ = 0;
+  uint64_t trigger_ticks_ = 0;
+  uint64_t next_dump_at_ = 0;
+  uint64_t suppressed_ = 0;
+  std::atomic<uint64_t> requested_{0};
+
+  // Dumper-only
+  alignas(64) std::atomic<uint64_t> done_{0};
+};
+
+// Background thread that writes triggered FlightRecorder dumps as CSV, one
+// file per outlier: <directory>/<name>_<trigger ns>.csv, one row per event
+// with per-stage offsets in ns, queue depths and cores. Polls, so the
+// recorders never make a syscall; pin it to a housekeeping core.
+class FlightRecorderDumper {
+ public:
+  struct Config {
+    std::string directory = ".";
+    int core = -1;
+    std::chrono::milliseconds poll_interval{10};
+  };
+
+  FlightRecorderDumper(const TscClock& clock, const Config& config)
+      : clock_(clock), config_(config) {}
+  explicit FlightRecorderDumper(const TscClock& clock)
+      : FlightRecorderDumper(clock, Config()) {}
+  ~FlightRecorderDumper() { Stop(); }
+
+  FlightRecorderDumper(const FlightRecorderDumper&) = delete;
+  FlightRecorderDumper& operator=(const FlightRecorderDumper&) = delete;
+
+  // Before Start().
+  void Add(FlightRecorder* recorder) { recorders_.push_back(recorder); }
+
+  void Start() {
+    if (running_.exchange(true)) {
+      return;
+    }
+    thread_ = std::thread([this]() {
+      if (config_.core >= 0) {
+        ThreadUtils::PinToCore(config_.core);
+      }
+      while (running_.load(std::memory_order_relaxed)) {
+        Poll();
+        std::this_thread::sleep_for(config_.poll_interval);
+      }
+      Poll();
+    });
+  }
+
+  void Stop() {
+    if (running_.exchange(false)) {
+      thread_.join();
+    }
+  }
+
+  // Writes any pending dumps now; returns how many. Start() calls this
+  // from its thread; call it directly only when not started.
+  size_t Poll() {
+    size_t written = 0;
+    uint64_t trigger = 0;
+    for (FlightRecorder* recorder : recorders_) {
+      if (recorder->TakeDump(&events_, &trigger)) {
+        written += Write(*recorder, trigger) ? 1 : 0;
+      }
+    }
+    dumps_.fetch_add(written, std::memory_order_relaxed);
+    return written;
+  }
+
+  uint64_t Dumps() const { return dumps_.load(std::memory_order_relaxed); }
+  const std::string& LastFile() const { return last_file_; }
+
+ private:
+  bool Write(const FlightRecorder& recorder, uint64_t trigger) {
+    const std::string path = config_.directory + "/" + recorder.GetConfig().name + "_" +
+                             std::to_string(clock_.ToMonotonicNs(trigger)) + ".csv";
+    std::ofstream out(path);
+    if (!out) {
+      return false;
+    }
+    out << "receive_ns,symbol,update_id";
+    for (size_t s = 1; s < kStageCount; ++s) {
+      out << "," << StageName(static_cast<Stage>(s)) << "_ns";
+    }
+    for (size_t s = 0; s < kStageCount; ++s) {
+      out << "," << StageName(static_cast<Stage>(s)) << "_depth";
+    }
+    for (size_t s = 0; s < kStageCount; ++s) {
+      out << "," << StageName(static_cast<Stage>(s)) << "_cpu";
+    }
+    out << "\n";
+    for (const FlightEvent& event : events_) {
+      const StageTrace& t = event.trace;
+      out << clock_.ToMonotonicNs(t.origin) << "," << event.symbol << "," << event.update_id;
+      for (size_t s = 1; s < kStageCount; ++s) {
+        const Stage stage = static_cast<Stage>(s);
+        out << ",";
+        if (t.Has(stage)) {
+          out << static_cast<uint64_t>(clock_.ToNanos(static_cast<uint64_t>(t.Offset(stage))));
+        }
+      }
+      for (size_t s = 0; s < kStageCount; ++s) {
+        out << "," << t.Depth(static_cast<Stage>(s));
+      }
+      for (size_t s = 0; s < kStageCount; ++s) {
+        out << "," << t.Cpu(static_cast<Stage>(s));
+      }
+      out << "\n";
+    }
+    last_file_ = path;
+    return static_cast<bool>(out);
+  }
+
+  const TscClock& clock_;
+  Config config_;
+  std::vector<FlightRecorder*> recorders_;
+  std::vector<FlightEvent> events_;
+  std::string last_file_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> dumps_{0};
+};
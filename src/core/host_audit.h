@@ -0,0 +1,294 @@
+// src/core/host_audit.h
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/cpu_topology.h"
+
+enum class AuditStatus : uint8_t {
+  OK,
+  WARN,  // Costs latency; see the finding's want
+  SKIP,  // Couldn't tell from this host
+};
+
+inline const char* AuditStatusName(AuditStatus status) {
+  switch (status) {
+    case AuditStatus::OK: return "ok";
+    case AuditStatus::WARN: return "warn";
+    case AuditStatus::SKIP: return "skip";
+  }
+  return "unknown";
+}
+
+struct AuditFinding {
+  std::string check;    // "isolcpus", "governor", ...
+  std::string subject;  // "cpu2", "eth0", "irq45" or "host"
+  AuditStatus status = AuditStatus::SKIP;
+  std::string value;    // What the host has
+  std::string want;     // What it should have
+};
+
+// Startup check of the host settings that most often explain a latency
+// regression, against the cores the pipeline is pinned to and the NIC it
+// reads from. Read-only: it reports, it doesn't fix. Checks:
+// - isolcpus, nohz_full and rcu_nocbs on the kernel command line cover
+//   every pinned core;
+// - no NIC queue IRQ is allowed on a pinned core;
+// - the cpufreq governor of each pinned core is performance;
+// - no pinned core has an online SMT sibling;
+// - THP is not in always mode, for allocation or defrag;
+// - the NIC is on the same NUMA node as the pinned cores.
+//
+// Report() is one line per finding in logfmt, for grep and log shippers:
+//   audit check=governor subject=cpu2 status=warn value=powersave want=performance
+class HostAudit {
+ public:
+  struct Config {
+    std::vector<int> cores;  // Pinned pipeline cores
+    std::string interface;   // Empty: the default route's interface
+    // Tests point these at fake trees
+    std::string proc_root = "/proc";
+    std::string sys_root = "/sys";
+  };
+
+  explicit HostAudit(const Config& config) : config_(config) {}
+
+  // Runs every check; returns the number of warnings.
+  size_t Run() {
+    findings_.clear();
+    const CpuTopology topology = CpuTopology::Discover(config_.sys_root + "/devices/system");
+    const std::string interface =
+        config_.interface.empty() ? DefaultInterface() : config_.interface;
+    CheckCmdline();
+    CheckIrqs(interface);
+    CheckGovernors();
+    CheckSmt(topology);
+    CheckThp();
+    CheckNicNode(interface, topology);
+    return Warnings();
+  }
+
+  const std::vector<AuditFinding>& Findings() const { return findings_; }
+
+  size_t Warnings() const {
+    return static_cast<size_t>(std::count_if(
+        findings_.begin(), findings_.end(),
+        [](const AuditFinding& f) { return f.status == AuditStatus::WARN; }));
+  }
+
+  std::string Report() const {
+    std::string out;
+    for (const AuditFinding& f : findings_) {
+      out += "audit check=" + f.check + " subject=" + Quote(f.subject) +
+             " status=" + AuditStatusName(f.status) + " value=" + Quote(f.value) +
+             " want=" + Quote(f.want) + "\n";
+    }
+    return out;
+  }
+
+ private:
+  void Add(const std::string& check, const std::string& subject, AuditStatus status,
+           const std::string& value, const std::string& want) {
+    findings_.push_back({check, subject, status, value, want});
+  }
+
+  static std::string Cpu(int core) { return "cpu" + std::to_string(core); }
+
+  static bool Contains(const std::vector<int>& cpus, int cpu) {
+    return std::find(cpus.begin(), cpus.end(), cpu) != cpus.end();
+  }
+
+  void CheckCmdline() {
+    std::vector<std::string> words;
+    std::stringstream cmdline(ReadLine(config_.proc_root + "/cmdline"));
+    for (std::string word; cmdline >> word;) {
+      words.push_back(word);
+    }
+    for (const char* name : {"isolcpus", "nohz_full", "rcu_nocbs"}) {
+      const std::string param = name;
+      std::string value;
+      for (const std::string& word : words) {
+        if (word.rfind(param + "=", 0) == 0) {
+          value = word.substr(param.size() + 1);
+        }
+      }
+      // isolcpus may lead with flags: isolcpus=domain,managed_irq,2-5
+      std::string list;
+      std::stringstream parts(value);
+      for (std::string part; std::getline(parts, part, ',');) {
+        if (!part.empty() && std::isdigit(static_cast<unsigned char>(part[0]))) {
+          list += list.empty() ? "" : ",";
+          list += part;
+        }
+      }
+      std::vector<int> cpus;
+      CpuTopology::ParseList(list, &cpus);
+      for (int core : config_.cores) {
+        Add(param, Cpu(core), Contains(cpus, core) ? AuditStatus::OK : AuditStatus::WARN,
+            value.empty() ? "unset" : value, "includes " + std::to_string(core));
+      }
+    }
+  }
+
+  void CheckIrqs(const std::string& interface) {
+    if (interface.empty()) {
+      Add("nic_irq_affinity", "host", AuditStatus::SKIP, "no interface", "");
+      return;
+    }
+    // The device's MSI vectors, whatever the driver names them in
+    // /proc/interrupts; a virtio NIC's are on its PCI function, one up
+    const std::string device = config_.sys_root + "/class/net/" + interface + "/device";
+    std::vector<int> irqs;
+    for (const std::string& dir : {device + "/msi_irqs", device + "/../msi_irqs"}) {
+      std::error_code error;
+      for (const auto& entry : std::filesystem::directory_iterator(dir, error)) {
+        const std::string name = entry.path().filename().string();
+        if (!name.empty() && name.find_first_not_of("0123456789") == std::string::npos) {
+          irqs.push_back(std::stoi(name));
+        }
+      }
+      if (!irqs.empty()) {
+        break;
+      }
+    }
+    std::sort(irqs.begin(), irqs.end());
+    for (int number : irqs) {
+      const std::string irq = std::to_string(number);
+      const std::string affinity =
+          ReadLine(config_.proc_root + "/irq/" + irq + "/smp_affinity_list");
+      std::vector<int> cpus;
+      if (!CpuTopology::ParseList(affinity, &cpus)) {
+        Add("nic_irq_affinity", "irq" + irq, AuditStatus::SKIP, "unreadable", "");
+        continue;
+      }
+      const bool clear = std::none_of(config_.cores.begin(), config_.cores.end(),
+                                      [&](int core) { return Contains(cpus, core); });
+      Add("nic_irq_affinity", "irq" + irq, clear ? AuditStatus::OK : AuditStatus::WARN,
+          interface + " on " + affinity, "no pinned cores");
+    }
+    if (irqs.empty()) {
+      Add("nic_irq_affinity", interface, AuditStatus::SKIP, "no MSI IRQs", "");
+    }
+  }
+
+  void CheckGovernors() {
+    for (int core : config_.cores) {
+      const std::string governor = ReadLine(config_.sys_root + "/devices/system/cpu/cpu" +
+                                            std::to_string(core) + "/cpufreq/scaling_governor");
+      if (governor.empty()) {
+        Add("governor", Cpu(core), AuditStatus::SKIP, "no cpufreq", "performance");
+      } else {
+        Add("governor", Cpu(core),
+            governor == "performance" ? AuditStatus::OK : AuditStatus::WARN, governor,
+            "performance");
+      }
+    }
+  }
+
+  void CheckSmt(const CpuTopology& topology) {
+    const std::string control = ReadLine(config_.sys_root + "/devices/system/cpu/smt/control");
+    if (control.empty()) {
+      Add("smt", "host", AuditStatus::SKIP, "unknown", "off or notsupported");
+    } else {
+      Add("smt", "host", control == "on" ? AuditStatus::WARN : AuditStatus::OK, control,
+          "off or notsupported");
+    }
+    for (int core : config_.cores) {
+      const std::vector<int> siblings = topology.Siblings(core);
+      std::string value;
+      for (int sibling : siblings) {
+        value += value.empty() ? "" : ",";
+        value += std::to_string(sibling);
+      }
+      Add("smt_sibling", Cpu(core), siblings.empty() ? AuditStatus::OK : AuditStatus::WARN,
+          value.empty() ? "none" : value, "none online");
+    }
+  }
+
+  void CheckThp() {
+    for (const char* name : {"enabled", "defrag"}) {
+      const std::string setting = name;
+      const std::string line =
+          ReadLine(config_.sys_root + "/kernel/mm/transparent_hugepage/" + setting);
+      // The active mode is bracketed: "always [madvise] never"
+      const size_t open = line.find('[');
+      const size_t close = line.find(']', open);
+      if (open == std::string::npos || close == std::string::npos) {
+        Add("thp_" + setting, "host", AuditStatus::SKIP, "unknown", "madvise or never");
+        continue;
+      }
+      const std::string mode = line.substr(open + 1, close - open - 1);
+      Add("thp_" + setting, "host", mode == "always" ? AuditStatus::WARN : AuditStatus::OK, mode,
+          "madvise or never");
+    }
+  }
+
+  void CheckNicNode(const std::string& interface, const CpuTopology& topology) {
+    if (interface.empty()) {
+      Add("nic_numa", "host", AuditStatus::SKIP, "no interface", "");
+      return;
+    }
+    const std::string node =
+        ReadLine(config_.sys_root + "/class/net/" + interface + "/device/numa_node");
+    // -1 (or no device, e.g. a virtual NIC) means the kernel doesn't know
+    if (node.empty() || node == "-1") {
+      Add("nic_numa", interface, AuditStatus::SKIP, node.empty() ? "unknown" : node, "");
+      return;
+    }
+    for (int core : config_.cores) {
+      const CpuInfo* info = topology.Find(core);
+      if (info == nullptr) {
+        Add("nic_numa", Cpu(core), AuditStatus::SKIP, "cpu offline", "same node");
+        continue;
+      }
+      Add("nic_numa", Cpu(core),
+          std::to_string(info->node) == node ? AuditStatus::OK : AuditStatus::WARN,
+          interface + " on node " + node, "same node");
+    }
+  }
+
+  // The interface of the first default route in /proc/net/route.
+  std::string DefaultInterface() const {
+    std::ifstream routes(config_.proc_root + "/net/route");
+    std::string line;
+    std::getline(routes, line);  // Header
+    while (std::getline(routes, line)) {
+      std::stringstream fields(line);
+      std::string interface;
+      std::string destination;
+      if (fields >> interface >> destination && destination == "00000000") {
+        return interface;
+      }
+    }
+    return "";
+  }
+
+  static std::string ReadLine(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+  }
+
+  static std::string Quote(const std::string& value) {
+    if (!value.empty() && value.find_first_of(" \"=") == std::string::npos) {
+      return value;
+    }
+    std::string out = "\"";
+    for (char c : value) {
+      out += c == '"' ? "\\\"" : std::string(1, c);
+    }
+    return out + "\"";
+  }
+
+  Config config_;
+  std::vector<AuditFinding> findings_;
+};
@@ -0,0 +1,329 @@
+// src/core/huge_page_arena.h
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// What an arena's memory ended up on.
+enum class PageBacking : uint8_t {
+  HUGETLB_1G,  // Reserved huge pages (vm.nr_hugepages), 1GB
+  HUGETLB_2M,  // Reserved huge pages, 2MB
+  THP,         // Normal pages, madvised for transparent huge pages
+  SMALL,       // Normal 4K pages
+};
+
+inline const char* PageBackingName(PageBacking backing) {
+  switch (backing) {
+    case PageBacking::HUGETLB_1G: return "hugetlb_1g";
+    case PageBacking::HUGETLB_2M: return "hugetlb_2m";
+    case PageBacking::THP: return "thp";
+    case PageBacking::SMALL: return "small";
+  }
+  return "unknown";
+}
+
+struct ArenaStats {
+  PageBacking backing = PageBacking::SMALL;
+  size_t page_size = 0;       // Of the backing
+  size_t reserved_bytes = 0;  // Mapped, a whole number of pages
+  size_t used_bytes = 0;      // Handed out, alignment padding included
+  size_t pages = 0;           // reserved_bytes / page_size
+  size_t resident_bytes = 0;  // Faulted in
+  size_t huge_bytes = 0;      // Actually on huge pages: all of a hugetlb
+                              // arena, whatever THP managed otherwise
+  uint64_t allocations = 0;
+  uint64_t failures = 0;      // Allocate() calls that didn't fit
+  int node = -1;              // Where the first page is; -1 if unknown
+  int bind_error = 0;         // errno if binding to Config::node failed
+};
+
+// One mapping on huge pages that long-lived hot structures are carved out
+// of, so rings, books, symbol tables and pools together span a handful of
+// TLB entries instead of thousands.
+//
+// Tries reserved 1GB pages (for arenas of 1GB or more), then reserved 2MB
+// pages, then normal pages madvised for THP, then plain small pages;
+// Stats() says which it got. Reserve hugetlb pages (vm.nr_hugepages) on
+// production hosts: THP is best effort and may fall back page by page.
+//
+// A bump allocator: Allocate() is a CAS on one offset, lock-free from any
+// thread, and nothing is freed until the arena goes. Meant for what is
+// sized at startup and lives for the process; pools that recycle take
+// their slab from here once and recycle inside it. Objects made with
+// Create() must be Destroy()ed before the arena if their destructors
+// matter.
+//
+// With a node, the mapping is bound there before it is faulted in
+// (preferred rather than bound for hugetlb, where an empty pool on the
+// node would otherwise be a SIGBUS). Without, first touch decides, so
+// create the arena on the thread that will use it. A failed bind leaves
+// the arena on first touch and is reported in Stats().bind_error.
+class HugePageArena {
+ public:
+  struct Config {
+    size_t bytes = 64 << 20;
+    int node = -1;                  // NUMA node to bind to; -1 for first touch
+    bool prefault = true;           // Fault every page in now
+    bool allow_small_pages = true;  // Else Ok() is false without huge pages
+  };
+
+  explicit HugePageArena(const Config& config) : config_(config) { Map(); }
+  HugePageArena() : HugePageArena(Config()) {}
+  ~HugePageArena() {
+#if defined(__linux__)
+    if (base_ != nullptr) {
+      munmap(base_, size_);
+    }
+#endif
+  }
+
+  HugePageArena(const HugePageArena&) = delete;
+  HugePageArena& operator=(const HugePageArena&) = delete;
+
+  bool Ok() const { return base_ != nullptr; }
+  PageBacking Backing() const { return backing_; }
+
+  // nullptr when the arena is full or wasn't mapped. alignment must be a
+  // power of two.
+  void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+    if (base_ == nullptr) {
+      failures_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    size_t offset = offset_.load(std::memory_order_relaxed);
+    size_t start = 0;
+    do {
+      start = (offset + alignment - 1) & ~(alignment - 1);
+      if (start > size_ || bytes > size_ - start) {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+    } while (!offset_.compare_exchange_weak(offset, start + bytes, std::memory_order_relaxed));
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<char*>(base_) + start;
+  }
+
+  // Constructs a T in the arena; nullptr if it doesn't fit.
+  template <typename T, typename... Args>
+  T* Create(Args&&... args) {
+    void* memory = Allocate(sizeof(T), alignof(T));
+    return memory == nullptr ? nullptr : new (memory) T(std::forward<Args>(args)...);
+  }
+
+  template <typename T>
+  void Destroy(T* object) {
+    if (object != nullptr) {
+      object->~T();
+    }
+  }
+
+  bool Owns(const void* p) const {
+    const char* c = static_cast<const char*>(p);
+    return base_ != nullptr && c >= static_cast<const char*>(base_) &&
+           c < static_cast<const char*>(base_) + size_;
+  }
+
+  // Page-level view: mincore for residency, smaps for THP, the kernel's
+  // policy for the node. A few syscalls and a file read; not for hot paths.
+  ArenaStats Stats() const {
+    ArenaStats stats;
+    stats.backing = backing_;
+    stats.page_size = page_size_;
+    stats.reserved_bytes = size_;
+    stats.used_bytes = std::min(offset_.load(std::memory_order_relaxed), size_);
+    stats.pages = page_size_ == 0 ? 0 : size_ / page_size_;
+    stats.allocations = allocations_.load(std::memory_order_relaxed);
+    stats.failures = failures_.load(std::memory_order_relaxed);
+    stats.bind_error = bind_error_;
+#if defined(__linux__)
+    if (base_ == nullptr) {
+      return stats;
+    }
+    const size_t small = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    std::vector<unsigned char> resident(size_ / small);
+    if (mincore(base_, size_, resident.data()) == 0) {
+      for (unsigned char r : resident) {
+        stats.resident_bytes += (r & 1) * small;
+      }
+    }
+    if (backing_ == PageBacking::THP) {
+      stats.huge_bytes = ThpBytes();
+    } else if (backing_ != PageBacking::SMALL) {
+      stats.huge_bytes = size_;
+    }
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, base_, MPOL_F_NODE | MPOL_F_ADDR) == 0) {
+      stats.node = node;
+    }
+#endif
+    return stats;
+  }
+
+ private:
+  static constexpr size_t k2M = size_t{2} << 20;
+  static constexpr size_t k1G = size_t{1} << 30;
+
+  static size_t RoundUp(size_t bytes, size_t page) { return (bytes + page - 1) & ~(page - 1); }
+
+  void Map() {
+#if defined(__linux__)
+    const size_t bytes = std::max<size_t>(config_.bytes, 1);
+    // MAP_HUGE_* encode log2 of the page size above MAP_HUGE_SHIFT
+    if (bytes >= k1G && TryMap(RoundUp(bytes, k1G), MAP_HUGETLB | (30 << MAP_HUGE_SHIFT))) {
+      Finish(PageBacking::HUGETLB_1G, k1G);
+    } else if (TryMap(RoundUp(bytes, k2M), MAP_HUGETLB | (21 << MAP_HUGE_SHIFT))) {
+      Finish(PageBacking::HUGETLB_2M, k2M);
+    } else if (config_.allow_small_pages && MapAligned(RoundUp(bytes, k2M))) {
+      // THP needs 2MB-aligned extents to back them with huge pages
+      const bool thp = madvise(base_, size_, MADV_HUGEPAGE) == 0;
+      Finish(thp ? PageBacking::THP : PageBacking::SMALL,
+             thp ? k2M : static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+    }
+#endif
+  }
+
+#if defined(__linux__)
+  bool TryMap(size_t size, int flags) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    if (p == MAP_FAILED) {
+      return false;
+    }
+    base_ = p;
+    size_ = size;
+    return true;
+  }
+
+  // Normal pages on a 2MB boundary: map 2MB more and trim the ends.
+  bool MapAligned(size_t size) {
+    if (!TryMap(size + k2M, 0)) {
+      return false;
+    }
+    char* raw = static_cast<char*>(base_);
+    char* aligned = reinterpret_cast<char*>(RoundUp(reinterpret_cast<uintptr_t>(raw), k2M));
+    if (aligned > raw) {
+      munmap(raw, static_cast<size_t>(aligned - raw));
+    }
+    const size_t tail = static_cast<size_t>(raw + size + k2M - (aligned + size));
+    if (tail > 0) {
+      munmap(aligned + size, tail);
+    }
+    base_ = aligned;
+    size_ = size;
+    return true;
+  }
+
+  void Finish(PageBacking backing, size_t page_size) {
+    backing_ = backing;
+    page_size_ = page_size;
+    if (config_.node >= 0) {
+      // Bound before any page is touched, so every page lands there
+      constexpr size_t kBits = 8 * sizeof(unsigned long);
+      std::vector<unsigned long> mask(static_cast<size_t>(config_.node) / kBits + 1, 0);
+      mask[static_cast<size_t>(config_.node) / kBits] |= 1UL << (config_.node % kBits);
+      const int mode = backing == PageBacking::HUGETLB_1G || backing == PageBacking::HUGETLB_2M
+                           ? MPOL_PREFERRED
+                           : MPOL_BIND;
+      if (syscall(SYS_mbind, base_, size_, mode, mask.data(), mask.size() * kBits + 1, 0) != 0) {
+        bind_error_ = errno;
+      }
+    }
+    if (config_.prefault) {
+      // Every small page unless reserved: THP may not have taken
+      const bool hugetlb = backing == PageBacking::HUGETLB_1G || backing == PageBacking::HUGETLB_2M;
+      const size_t step = hugetlb ? page_size : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+      volatile char* p = static_cast<char*>(base_);
+      for (size_t i = 0; i < size_; i += step) {
+        p[i] = 0;
+      }
+    }
+  }
+
+  // AnonHugePages of our mapping, from /proc/self/smaps.
+  size_t ThpBytes() const {
+    std::ifstream smaps("/proc/self/smaps");
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(base_);
+    const uintptr_t end = begin + size_;
+    bool ours = false;
+    size_t total = 0;
+    for (std::string line; std::getline(smaps, line);) {
+      uintptr_t start = 0;
+      uintptr_t stop = 0;
+      char dash = 0;
+      std::stringstream range(line);
+      if (range >> std::hex >> start >> dash >> stop && dash == '-') {
+        ours = start >= begin && stop <= end;
+      } else if (ours && line.rfind("AnonHugePages:", 0) == 0) {
+        std::stringstream value(line.substr(14));
+        size_t kb = 0;
+        value >> kb;
+        total += kb << 10;
+      }
+    }
+    return total;
+  }
+#endif
+
+  const Config config_;
+  void* base_ = nullptr;
+  size_t size_ = 0;
+  size_t page_size_ = 0;
+  PageBacking backing_ = PageBacking::SMALL;
+  int bind_error_ = 0;
+  alignas(64) std::atomic<size_t> offset_{0};
+  std::atomic<uint64_t> allocations_{0};
+  std::atomic<uint64_t> failures_{0};
+};
+
+// std allocator over a HugePageArena, for containers whose storage should
+// be on huge pages: std::vector<Level, ArenaAllocator<Level>>. deallocate()
+// gives nothing back, so use it for containers that are reserved once and
+// then reused, not for ones that churn. Throws std::bad_alloc when the
+// arena is full, as allocators must.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(HugePageArena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.Arena()) {}
+
+  T* allocate(size_t n) {
+    if (n > static_cast<size_t>(-1) / sizeof(T)) {
+      throw std::bad_alloc();
+    }
+    void* memory = arena_->Allocate(n * sizeof(T), alignof(T));
+    if (memory == nullptr) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T*>(memory);
+  }
+
+  void deallocate(T*, size_t) {}
+
+  HugePageArena* Arena() const { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.Arena(); }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.Arena(); }
+
+ private:
+  HugePageArena* arena_;
+};
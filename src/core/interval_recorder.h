@@ -0,0 +1,181 @@
+// src/core/interval_recorder.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "core/latency_tracker.h"
+
+// Per-thread accumulator handing completed intervals to a reporter thread,
+// shared by IntervalRecorder and PerfStageRecorder. T is what an interval
+// accumulates; it needs Reset().
+//
+// Timestamps are in whatever monotonic unit the caller uses (TSC ticks in
+// the pipeline, nanoseconds in tests); interval_ticks is in the same unit
+// and every recorder a reporter collects from must share it.
+//
+// The worker accumulates into one of two Ts and flips to the other when its
+// own timestamps cross an interval boundary (boundaries are multiples of
+// interval_ticks, so handoffs on different threads line up). The completed T
+// is published through a counter only the worker writes; the reporter
+// merges and resets it, then acknowledges through a counter only the
+// reporter writes. Active() touches nothing but the active T, and the
+// reporter's counter is read once per flip. If the reporter hasn't
+// collected the previous interval yet, the worker keeps accumulating into
+// the current one and the interval runs long rather than block.
+template <typename T>
+class IntervalHandoff {
+ public:
+  // args construct each of the two Ts.
+  template <typename... Args>
+  explicit IntervalHandoff(uint64_t interval_ticks, const Args&... args)
+      : interval_ticks_(interval_ticks), buffers_{Buffer(args...), Buffer(args...)} {}
+
+  IntervalHandoff(const IntervalHandoff&) = delete;
+  IntervalHandoff& operator=(const IntervalHandoff&) = delete;
+
+  // Worker thread: what the open interval accumulates into. Call Tick()
+  // first with the sample's timestamp.
+  T& Active() { return buffers_[active_].value; }
+
+  // Worker thread: closes the interval if now_ticks has passed its end.
+  void Tick(uint64_t now_ticks) {
+    if (now_ticks < roll_at_) {
+      return;
+    }
+    if (roll_at_ == 0) {
+      // First sample: just align the first interval
+      Open(now_ticks);
+      return;
+    }
+    const uint64_t published = published_.load(std::memory_order_relaxed);
+    if (collected_.load(std::memory_order_acquire) != published) {
+      // Reporter still holds the other buffer
+      ++extended_intervals_;
+      roll_at_ = now_ticks - now_ticks % interval_ticks_ + interval_ticks_;
+      return;
+    }
+    buffers_[active_].end_ticks = now_ticks - now_ticks % interval_ticks_;
+    published_.store(published + 1, std::memory_order_release);
+    active_ ^= 1;
+    Open(now_ticks);
+  }
+
+  // Reporter thread. Calls merge(value, start_ticks, end_ticks) on the last
+  // completed interval, then resets it for the worker. False if nothing
+  // new was published.
+  template <typename Merge>
+  bool Collect(Merge&& merge) {
+    const uint64_t published = published_.load(std::memory_order_acquire);
+    if (published == collected_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    Buffer& done = buffers_[(published - 1) & 1];
+    merge(static_cast<const T&>(done.value), done.start_ticks, done.end_ticks);
+    done.value.Reset();
+    collected_.store(published, std::memory_order_release);
+    return true;
+  }
+
+  // Worker-side count of flips deferred because the reporter lagged.
+  uint64_t ExtendedIntervals() const { return extended_intervals_; }
+
+ private:
+  struct alignas(64) Buffer {
+    template <typename... Args>
+    explicit Buffer(const Args&... args) : value(args...) {}
+    T value;
+    uint64_t start_ticks = 0;
+    uint64_t end_ticks = 0;
+  };
+
+  void Open(uint64_t now_ticks) {
+    const uint64_t start = now_ticks - now_ticks % interval_ticks_;
+    buffers_[active_].start_ticks = start;
+    roll_at_ = start + interval_ticks_;
+  }
+
+  const uint64_t interval_ticks_;
+  Buffer buffers_[2];
+
+  // Worker-only
+  alignas(64) uint64_t roll_at_ = 0;
+  uint32_t active_ = 0;
+  uint64_t extended_intervals_ = 0;
+  std::atomic<uint64_t> published_{0};  // Intervals completed
+
+  // Reporter-only
+  alignas(64) std::atomic<uint64_t> collected_{0};  // Intervals merged and reset
+};
+
+// Per-thread latency recorder handing completed intervals to a reporter
+// through an IntervalHandoff: Record() touches nothing but the active
+// tracker and never waits for the reporter.
+//
+// An idle worker's open interval is published by its next Record() or
+// Tick(), so call Tick() from idle loops that already have a timestamp.
+class IntervalRecorder {
+ public:
+  explicit IntervalRecorder(uint64_t interval_ticks,
+                            const LatencyTracker::Config& config = LatencyTracker::Config())
+      : handoff_(interval_ticks, config) {}
+
+  IntervalRecorder(const IntervalRecorder&) = delete;
+  IntervalRecorder& operator=(const IntervalRecorder&) = delete;
+
+  // Worker thread. latency and now_ticks are on the interval's clock;
+  // now_ticks is typically the end timestamp the latency was measured with.
+  void Record(int64_t latency, uint64_t now_ticks) {
+    handoff_.Tick(now_ticks);
+    handoff_.Active().RecordLatency(latency);
+  }
+
+  // Worker thread: closes the interval if now_ticks has passed its end.
+  void Tick(uint64_t now_ticks) { handoff_.Tick(now_ticks); }
+
+  // Reporter thread. Merges the last completed interval into out and
+  // resets it for the worker. False if nothing new was published.
+  bool Collect(LatencyTracker& out, uint64_t* start_ticks = nullptr, uint64_t* end_ticks = nullptr) {
+    return handoff_.Collect([&](const LatencyTracker& done, uint64_t start, uint64_t end) {
+      out.Merge(done);
+      if (start_ticks != nullptr) *start_ticks = start;
+      if (end_ticks != nullptr) *end_ticks = end;
+    });
+  }
+
+  // Worker-side count of flips deferred because the reporter lagged.
+  uint64_t ExtendedIntervals() const { return handoff_.ExtendedIntervals(); }
+
+ private:
+  IntervalHandoff<LatencyTracker> handoff_;
+};
+
+// Reporter-side view over a set of recorders: the latest interval merged
+// across threads, and everything since start.
+class LatencyReporter {
+ public:
+  explicit LatencyReporter(const LatencyTracker::Config& config = LatencyTracker::Config())
+      : interval_(config), cumulative_(config) {}
+
+  void Add(IntervalRecorder* recorder) { recorders_.push_back(recorder); }
+
+  // Call once per interval. Returns how many recorders had a new interval.
+  size_t Collect() {
+    interval_.Reset();
+    size_t collected = 0;
+    for (IntervalRecorder* recorder : recorders_) {
+      collected += recorder->Collect(interval_) ? 1 : 0;
+    }
+    cumulative_.Merge(interval_);
+    return collected;
+  }
+
+  const LatencyTracker& Interval() const { return interval_; }
+  const LatencyTracker& Cumulative() const { return cumulative_; }
+
+ private:
+  std::vector<IntervalRecorder*> recorders_;
+  LatencyTracker interval_;
+  LatencyTracker cumulative_;
+};
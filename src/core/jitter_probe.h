@@ -0,0 +1,256 @@
+// src/core/jitter_probe.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "core/interval_recorder.h"
+#include "core/ring_buffer.h"
+#include "core/thread_utils.h"
+#include "core/tsc_clock.h"
+
+// What took the core away, as far as the probe can tell afterwards.
+enum class HiccupCause : uint8_t {
+  INTERRUPT,   // No context switch: an IRQ (timer, NIC, IPI) ran on the core
+  SMI,         // System management interrupt, from MSR_SMI_COUNT
+  PREEMPTION,  // The thread was switched out
+  MIGRATION,   // The thread came back on another core
+};
+
+inline constexpr size_t kHiccupCauseCount = 4;
+
+inline const char* HiccupCauseName(HiccupCause cause) {
+  static constexpr const char* kNames[kHiccupCauseCount] = {
+      "interrupt", "smi", "preemption", "migration"};
+  return kNames[static_cast<size_t>(cause)];
+}
+
+struct Hiccup {
+  uint64_t start_ticks = 0;     // Last sample before the gap (TSC)
+  uint64_t duration_ticks = 0;
+  int32_t core = -1;
+  HiccupCause cause = HiccupCause::INTERRUPT;
+};
+
+// Finds the gaps in a stream of back-to-back timestamps from one thread:
+// any gap above the threshold is time the core spent on something else.
+// Each gap is classified, recorded into a per-cause IntervalRecorder and
+// queued with its timestamp for the reporter, so spikes in the pipeline's
+// latency can be lined up with platform noise.
+//
+// Sample() is a subtract and a compare. Classifying a hiccup takes a few
+// syscalls, so this is meant for probe threads rather than the pipeline.
+class HiccupDetector {
+ public:
+  struct Config {
+    uint64_t threshold_ticks = 0;
+    uint64_t interval_ticks = 0;  // IntervalRecorder interval
+  };
+
+  HiccupDetector(int core, const Config& config) : core_(core), config_(config) {
+    for (auto& recorder : recorders_) {
+      recorder = std::make_unique<IntervalRecorder>(config.interval_ticks);
+    }
+  }
+
+  ~HiccupDetector() {
+#if defined(__linux__)
+    if (msr_fd_ >= 0) {
+      close(msr_fd_);
+    }
+#endif
+  }
+
+  HiccupDetector(const HiccupDetector&) = delete;
+  HiccupDetector& operator=(const HiccupDetector&) = delete;
+
+  // Probe thread, once before the first Sample(): snapshots the context
+  // switch and SMI counts later hiccups are compared against.
+  void Begin() {
+    switches_ = ContextSwitches();
+    smis_ = SmiCount();
+    last_ = TscClock::Now();
+  }
+
+  // Probe thread, as often as it can.
+  void Sample(uint64_t now) {
+    const uint64_t gap = now - last_;
+    if (gap >= config_.threshold_ticks) {
+      OnHiccup(last_, gap);
+      // Don't count our own classification as the next gap
+      now = TscClock::Now();
+    } else if ((++samples_ & 0xffff) == 0) {
+      for (auto& recorder : recorders_) {
+        recorder->Tick(now);
+      }
+    }
+    last_ = now;
+  }
+
+  // Hiccup durations in ticks, for a LatencyReporter.
+  IntervalRecorder* Histogram(HiccupCause cause) {
+    return recorders_[static_cast<size_t>(cause)].get();
+  }
+
+  // Reporter thread: the next queued hiccup, oldest first.
+  bool PopHiccup(Hiccup* out) { return events_.TryPop(out); }
+
+  int Core() const { return core_; }
+  uint64_t Hiccups() const { return hiccups_.load(std::memory_order_relaxed); }
+  // Queued events lost because the reporter didn't drain them in time; the
+  // histograms still count them.
+  uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  void OnHiccup(uint64_t start, uint64_t gap) {
+    HiccupCause cause = HiccupCause::INTERRUPT;
+    const uint64_t switches = ContextSwitches();
+    const uint64_t smis = SmiCount();
+    if (OffCore()) {
+      cause = HiccupCause::MIGRATION;
+    } else if (switches != switches_) {
+      cause = HiccupCause::PREEMPTION;
+    } else if (smis != smis_) {
+      cause = HiccupCause::SMI;
+    }
+    switches_ = switches;
+    smis_ = smis;
+
+    const uint64_t end = start + gap;
+    recorders_[static_cast<size_t>(cause)]->Record(static_cast<int64_t>(gap), end);
+    hiccups_.fetch_add(1, std::memory_order_relaxed);
+    if (!events_.TryPush(Hiccup{start, gap, core_, cause})) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  bool OffCore() const {
+#if defined(__linux__)
+    return core_ >= 0 && sched_getcpu() != core_;
+#else
+    return false;
+#endif
+  }
+
+  static uint64_t ContextSwitches() {
+#if defined(__linux__)
+    rusage usage{};
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+      return static_cast<uint64_t>(usage.ru_nvcsw + usage.ru_nivcsw);
+    }
+#endif
+    return 0;
+  }
+
+  // MSR 0x34 (Intel). Needs the msr module and root; 0 everywhere else, in
+  // which case SMIs are reported as interrupts.
+  uint64_t SmiCount() {
+#if defined(__linux__)
+    if (msr_fd_ == -2) {
+      const std::string path = "/dev/cpu/" + std::to_string(core_) + "/msr";
+      msr_fd_ = core_ >= 0 ? open(path.c_str(), O_RDONLY | O_CLOEXEC) : -1;
+    }
+    uint64_t count = 0;
+    if (msr_fd_ >= 0 && pread(msr_fd_, &count, sizeof(count), 0x34) == sizeof(count)) {
+      return count;
+    }
+#endif
+    return 0;
+  }
+
+  const int core_;
+  const Config config_;
+  std::array<std::unique_ptr<IntervalRecorder>, kHiccupCauseCount> recorders_;
+  LockFreeRingBuffer<Hiccup, 1024> events_;
+
+  // Probe-only
+  uint64_t last_ = 0;
+  uint64_t samples_ = 0;
+  uint64_t switches_ = 0;
+  uint64_t smis_ = 0;
+  int msr_fd_ = -2;  // -2: not opened yet
+  std::atomic<uint64_t> hiccups_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+// One low-priority probe thread per core, each spinning on the TSC through
+// a HiccupDetector. By default it covers every core the pipeline pinned
+// with ThreadUtils::PinToCore, so start it after the pipeline threads.
+//
+// Off unless Config::enabled is set. Only meaningful on cores whose
+// pipeline thread blocks or that have none: SCHED_IDLE still gets a small
+// fair-scheduler share, so next to a busy-spinning thread the probe takes
+// time slices from it and brings the scheduler tick back on nohz_full
+// cores. There it adds the jitter it measures, and what it sees is mostly
+// that thread taking the core back (reported as preemption).
+class JitterProbe {
+ public:
+  struct Config {
+    bool enabled = false;    // Start() does nothing unless set
+    std::vector<int> cores;  // Empty: ThreadUtils::PinnedCores() at Start()
+    uint64_t threshold_ticks = 0;
+    uint64_t interval_ticks = 0;
+  };
+
+  explicit JitterProbe(const Config& config) : config_(config) {}
+  ~JitterProbe() { Stop(); }
+
+  JitterProbe(const JitterProbe&) = delete;
+  JitterProbe& operator=(const JitterProbe&) = delete;
+
+  // Creates the detectors and starts the probes, if enabled. Register the
+  // detectors with reporters after this.
+  void Start() {
+    if (!config_.enabled || running_.exchange(true)) {
+      return;
+    }
+    const std::vector<int> cores =
+        config_.cores.empty() ? ThreadUtils::PinnedCores() : config_.cores;
+    for (int core : cores) {
+      detectors_.push_back(std::make_unique<HiccupDetector>(
+          core, HiccupDetector::Config{config_.threshold_ticks, config_.interval_ticks}));
+    }
+    for (auto& detector : detectors_) {
+      threads_.emplace_back([this, d = detector.get()]() {
+        ThreadUtils::PinToCore(d->Core());
+        ThreadUtils::SetIdlePriority();
+        d->Begin();
+        while (running_.load(std::memory_order_relaxed)) {
+          d->Sample(TscClock::Now());
+        }
+      });
+    }
+  }
+
+  void Stop() {
+    if (!running_.exchange(false)) {
+      return;
+    }
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+    threads_.clear();
+  }
+
+  size_t Size() const { return detectors_.size(); }
+  HiccupDetector& Detector(size_t i) { return *detectors_[i]; }
+
+ private:
+  Config config_;
+  std::vector<std::unique_ptr<HiccupDetector>> detectors_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> running_{false};
+};
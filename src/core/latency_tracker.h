@@ -0,0 +1,235 @@
+// src/core/latency_tracker.h
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Latency histogram with HDR-style log-linear buckets.
+//
+// Values below 2^precision_bits are counted exactly. Above that, each
+// power-of-two range is split into 2^(precision_bits - 1) equal buckets, so
+// every recorded value is known to within a relative error of
+// 2^-(precision_bits - 1), at any magnitude. Memory is fixed at construction
+// by max_value and the precision; values above max_value are clamped into
+// the top bucket (MaxLatency() still reports the true maximum).
+//
+// RecordLatency is a count-leading-zeros, a shift and an increment, with no
+// allocation. Percentile queries walk the buckets, which is meant for the
+// reporting side. Not thread-safe; give each writer its own tracker and
+// Merge() them.
+class LatencyTracker {
+ public:
+  struct Config {
+    // 8 bits: values within 0.8% (1/128)
+    uint32_t precision_bits = 8;
+    // Largest value tracked at full precision; one minute in ns
+    int64_t max_value = 60'000'000'000;
+  };
+
+  LatencyTracker() : LatencyTracker(Config()) {}
+  explicit LatencyTracker(const Config& config)
+      : config_(Sanitize(config)),
+        sub_bucket_count_(uint64_t{1} << config_.precision_bits),
+        half_count_(sub_bucket_count_ / 2),
+        counts_(BucketIndex(static_cast<uint64_t>(config_.max_value)) + 1, 0) {}
+
+  void RecordLatency(int64_t latency_ns) { RecordLatency(latency_ns, 1); }
+
+  // Records count occurrences of one value, e.g. when replaying a summary.
+  void RecordLatency(int64_t latency_ns, uint64_t count) {
+    const uint64_t value = latency_ns > 0 ? static_cast<uint64_t>(latency_ns) : 0;
+    const size_t index = std::min(BucketIndex(value), counts_.size() - 1);
+    counts_[index] += count;
+    total_count_ += count;
+    sum_ += static_cast<double>(value) * static_cast<double>(count);
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  // For samples from a closed-loop tester that sends every
+  // expected_interval_ns but waits while the system stalls: the sends that
+  // should have happened during a long sample would have seen
+  // latency - interval, latency - 2 * interval, ..., so those are recorded
+  // too. Prefer measuring from intended send times (ConstantRateSchedule)
+  // where the tester can be changed.
+  //
+  // The implied samples are added a bucket at a time, so a long stall costs
+  // O(buckets it spans) rather than O(latency / interval).
+  void RecordLatencyCorrected(int64_t latency_ns, int64_t expected_interval_ns) {
+    RecordLatency(latency_ns);
+    if (expected_interval_ns <= 0 || latency_ns < 2 * expected_interval_ns) {
+      return;
+    }
+    const uint64_t interval = static_cast<uint64_t>(expected_interval_ns);
+    uint64_t value = static_cast<uint64_t>(latency_ns) - interval;
+    while (value >= interval) {
+      const size_t index = std::min(BucketIndex(value), counts_.size() - 1);
+      // Every term value, value - interval, ... that lands in this bucket
+      const uint64_t low = std::max(BucketLow(index), interval);
+      const uint64_t n = (value - low) / interval + 1;
+      const uint64_t last = value - (n - 1) * interval;
+      counts_[index] += n;
+      total_count_ += n;
+      sum_ += (static_cast<double>(value) + static_cast<double>(last)) * 0.5 *
+              static_cast<double>(n);
+      min_ = std::min(min_, last);
+      if (last < 2 * interval) {
+        break;
+      }
+      value = last - interval;
+    }
+  }
+
+  // Adds another tracker's samples. Trackers with the same config add
+  // bucket by bucket; otherwise each bucket is re-recorded at its midpoint.
+  void Merge(const LatencyTracker& other) {
+    if (other.total_count_ == 0) {
+      return;
+    }
+    if (other.counts_.size() == counts_.size() &&
+        other.config_.precision_bits == config_.precision_bits) {
+      for (size_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+      }
+      total_count_ += other.total_count_;
+      sum_ += other.sum_;
+    } else {
+      const double sum = sum_ + other.sum_;
+      for (size_t i = 0; i < other.counts_.size(); ++i) {
+        if (other.counts_[i] != 0) {
+          const uint64_t mid = (other.BucketLow(i) + other.BucketHigh(i)) / 2;
+          RecordLatency(static_cast<int64_t>(mid), other.counts_[i]);
+        }
+      }
+      sum_ = sum;  // Keep the exact mean rather than the midpoints'
+    }
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  // Replaces the contents with buckets exported from a tracker with the same
+  // config. False, leaving the tracker as it was, if the sizes differ.
+  bool Load(const uint64_t* counts, size_t count, double sum, int64_t min, int64_t max) {
+    if (count != counts_.size()) {
+      return false;
+    }
+    std::copy_n(counts, count, counts_.begin());
+    total_count_ = 0;
+    for (uint64_t c : counts_) {
+      total_count_ += c;
+    }
+    sum_ = sum;
+    min_ = total_count_ == 0 ? std::numeric_limits<uint64_t>::max() : static_cast<uint64_t>(min);
+    max_ = static_cast<uint64_t>(max);
+    return true;
+  }
+
+  void Reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_count_ = 0;
+    sum_ = 0.0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+  }
+
+  int64_t MinLatency() const {
+    return total_count_ == 0 ? 0 : static_cast<int64_t>(min_);
+  }
+  int64_t MaxLatency() const { return static_cast<int64_t>(max_); }
+  double AvgLatency() const {
+    return total_count_ == 0 ? 0.0 : sum_ / static_cast<double>(total_count_);
+  }
+
+  // Smallest recorded value such that percentile% of samples are at or
+  // below it, reported as the top of its bucket (capped at the max), e.g.
+  // PercentileLatency(99.99).
+  int64_t PercentileLatency(double percentile) const {
+    if (total_count_ == 0) {
+      return 0;
+    }
+    const double p = std::clamp(percentile, 0.0, 100.0);
+    const uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total_count_))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return static_cast<int64_t>(std::clamp(BucketHigh(i), min_, max_));
+      }
+    }
+    return static_cast<int64_t>(max_);
+  }
+
+  // Samples in buckets that lie wholly at or below value, e.g. for
+  // Prometheus buckets; undercounts by at most one bucket's width.
+  uint64_t CountAtOrBelow(int64_t value) const {
+    if (value < 0) {
+      return 0;
+    }
+    const uint64_t v = static_cast<uint64_t>(value);
+    uint64_t count = 0;
+    for (size_t i = 0; i < counts_.size() && BucketHigh(i) <= v; ++i) {
+      count += counts_[i];
+    }
+    return count;
+  }
+
+  uint64_t Count() const { return total_count_; }
+  double Sum() const { return sum_; }
+  size_t BucketCount() const { return counts_.size(); }
+  // Raw per-bucket counts, for exporting the histogram as it is.
+  const std::vector<uint64_t>& Buckets() const { return counts_; }
+  double RelativeError() const { return 1.0 / static_cast<double>(half_count_); }
+  const Config& GetConfig() const { return config_; }
+
+ private:
+  static Config Sanitize(Config config) {
+    config.precision_bits = std::clamp<uint32_t>(config.precision_bits, 2, 16);
+    config.max_value = std::max<int64_t>(config.max_value, 1);
+    return config;
+  }
+
+  // Values below sub_bucket_count_ map to themselves. Above, the top
+  // precision_bits bits of the value pick the bucket within its power of two.
+  size_t BucketIndex(uint64_t value) const {
+    if (value < sub_bucket_count_) {
+      return static_cast<size_t>(value);
+    }
+    const uint32_t shift = static_cast<uint32_t>(std::bit_width(value)) -
+                           config_.precision_bits;
+    const uint64_t sub = value >> shift;  // In [half_count_, sub_bucket_count_)
+    return static_cast<size_t>(sub_bucket_count_ + (shift - 1) * half_count_ +
+                               (sub - half_count_));
+  }
+
+  uint64_t BucketLow(size_t index) const {
+    if (index < sub_bucket_count_) {
+      return index;
+    }
+    const uint64_t shift = (index - sub_bucket_count_) / half_count_ + 1;
+    const uint64_t sub = (index - sub_bucket_count_) % half_count_ + half_count_;
+    return sub << shift;
+  }
+
+  uint64_t BucketHigh(size_t index) const {
+    if (index < sub_bucket_count_) {
+      return index;
+    }
+    const uint64_t shift = (index - sub_bucket_count_) / half_count_ + 1;
+    return BucketLow(index) + (uint64_t{1} << shift) - 1;
+  }
+
+  Config config_;
+  uint64_t sub_bucket_count_;
+  uint64_t half_count_;
+  std::vector<uint64_t> counts_;
+  uint64_t total_count_ = 0;
+  double sum_ = 0.0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+};
@@ -0,0 +1,62 @@
+// src/core/load_generator.h
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+#include "core/tsc_clock.h"
+
+// Open-loop send schedule for latency tests.
+//
+// A producer that sleeps or waits for the consumer only sends when the
+// system is keeping up, so stalls delay the samples instead of showing up in
+// them (coordinated omission). Here message i is due at start + i * period
+// whatever happened before it, and latency is measured from that intended
+// time: if the producer falls behind, every message sent late carries the
+// delay. Times are CLOCK_MONOTONIC ns.
+class ConstantRateSchedule {
+ public:
+  explicit ConstantRateSchedule(double rate_per_second,
+                                uint64_t start_ns = TscClock::MonotonicNs())
+      : start_ns_(start_ns),
+        period_ns_(std::max(1.0, 1e9 / rate_per_second)) {}
+
+  // When message i should be sent.
+  uint64_t IntendedTime(uint64_t i) const {
+    return start_ns_ + static_cast<uint64_t>(static_cast<double>(i) * period_ns_);
+  }
+
+  // Waits until message i is due and returns its intended time; returns at
+  // once if it's already overdue. yield lets a consumer sharing the core
+  // run while we wait.
+  uint64_t WaitFor(uint64_t i, bool yield = false) {
+    const uint64_t due = IntendedTime(i);
+    uint64_t now = TscClock::MonotonicNs();
+    if (now > due) {
+      ++late_sends_;
+      max_lag_ns_ = std::max(max_lag_ns_, now - due);
+      return due;
+    }
+    while (now < due) {
+      if (yield) {
+        std::this_thread::yield();
+      }
+      now = TscClock::MonotonicNs();
+    }
+    return due;
+  }
+
+  double PeriodNs() const { return period_ns_; }
+  uint64_t StartNs() const { return start_ns_; }
+  // Messages that were already overdue when their turn came, i.e. the
+  // producer itself couldn't hold the rate.
+  uint64_t LateSends() const { return late_sends_; }
+  uint64_t MaxLagNs() const { return max_lag_ns_; }
+
+ private:
+  uint64_t start_ns_;
+  double period_ns_;
+  uint64_t late_sends_ = 0;
+  uint64_t max_lag_ns_ = 0;
+};
@@ -0,0 +1,234 @@
+// src/core/metrics_server.h
+#pragma once
+
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "core/stats_segment.h"
+#include "core/thread_utils.h"
+
+// Prometheus/OpenMetrics scrape endpoint over a stats segment.
+//
+// The server reads the shared-memory segment through its own
+// StatsSegmentReader, the same lock-free path stats_viewer uses, so it never
+// touches the pipeline's threads or their cache lines; pin it to a
+// housekeeping core. One connection at a time, GET /metrics only, closed
+// after each response: enough for a scraper on the same host, not a web
+// server. Binds to loopback unless told otherwise.
+class MetricsServer {
+ public:
+  struct Config {
+    std::string segment = kDefaultStatsSegment;
+    std::string address = "127.0.0.1";
+    uint16_t port = 9464;  // 0 picks a free port; see Port()
+    int core = -1;         // Pin the server thread here if >= 0
+    std::string prefix = "low_latency_";
+  };
+
+  MetricsServer() : MetricsServer(Config()) {}
+  explicit MetricsServer(const Config& config) : config_(config) {}
+  ~MetricsServer() { Stop(); }
+
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer& operator=(const MetricsServer&) = delete;
+
+  // Binds and starts serving. False if the address can't be bound.
+  bool Start() {
+    if (running_.load()) {
+      return true;
+    }
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+      return false;
+    }
+    const int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config_.port);
+    socklen_t len = sizeof(addr);
+    if (inet_pton(AF_INET, config_.address.c_str(), &addr.sin_addr) != 1 ||
+        bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 8) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+      close(listen_fd_);
+      listen_fd_ = -1;
+      return false;
+    }
+    port_ = ntohs(addr.sin_port);
+    running_.store(true);
+    thread_ = std::thread([this]() { Run(); });
+    return true;
+  }
+
+  void Stop() {
+    if (!running_.exchange(false)) {
+      return;
+    }
+    thread_.join();
+    close(listen_fd_);
+    listen_fd_ = -1;
+  }
+
+  uint16_t Port() const { return port_; }
+  uint64_t Scrapes() const { return scrapes_.load(std::memory_order_relaxed); }
+
+  // The exposition for everything in the segment. Counters become
+  // <name>_total, gauges are as they are, histograms are in seconds with
+  // a fixed 1-2-5 ladder of buckets from 100ns to 50s. Interval
+  // histograms, which restart every stats interval, are gaugehistograms.
+  static std::string Render(const StatsSegmentReader& reader, const std::string& prefix) {
+    std::string out;
+    StatsSegmentReader::Value value;
+    for (size_t i = 0; i < reader.SlotCount(); ++i) {
+      if (!reader.Read(i, &value)) {
+        continue;
+      }
+      const std::string name = prefix + Sanitize(value.name);
+      switch (value.kind) {
+        case StatKind::COUNTER:
+          out += "# TYPE " + name + " counter\n";
+          out += name + "_total " + std::to_string(value.counter) + "\n";
+          break;
+        case StatKind::GAUGE:
+          out += "# TYPE " + name + " gauge\n";
+          out += name + " " + Number(value.gauge) + "\n";
+          break;
+        case StatKind::HISTOGRAM:
+        case StatKind::INTERVAL_HISTOGRAM:
+          RenderHistogram(name + "_seconds", value, &out);
+          break;
+      }
+    }
+    out += "# EOF\n";
+    return out;
+  }
+
+ private:
+  static std::string Sanitize(const std::string& name) {
+    std::string out = name;
+    for (char& c : out) {
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != ':') {
+        c = '_';
+      }
+    }
+    return out;
+  }
+
+  // OpenMetrics spells the non-finite values NaN, +Inf and -Inf; printf's
+  // nan/inf would fail the whole scrape.
+  static std::string Number(double value) {
+    if (std::isnan(value)) {
+      return "NaN";
+    }
+    if (std::isinf(value)) {
+      return value > 0 ? "+Inf" : "-Inf";
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+  }
+
+  static void RenderHistogram(const std::string& name, const StatsSegmentReader::Value& value,
+                              std::string* out) {
+    const bool interval = value.kind == StatKind::INTERVAL_HISTOGRAM;
+    const LatencyTracker& t = value.histogram;
+    *out += "# TYPE " + name + (interval ? " gaugehistogram\n" : " histogram\n");
+    *out += "# UNIT " + name + " seconds\n";
+    for (double le_ns = 100; le_ns <= 1e10; le_ns *= 10) {
+      for (double step : {1.0, 2.0, 5.0}) {
+        const double bound_ns = le_ns * step;
+        const auto units = static_cast<int64_t>(bound_ns / value.unit_ns);
+        *out += name + "_bucket{le=\"" + Number(bound_ns / 1e9) + "\"} " +
+                std::to_string(t.CountAtOrBelow(units)) + "\n";
+      }
+    }
+    *out += name + "_bucket{le=\"+Inf\"} " + std::to_string(t.Count()) + "\n";
+    *out += name + (interval ? "_gcount " : "_count ") + std::to_string(t.Count()) + "\n";
+    *out += name + (interval ? "_gsum " : "_sum ") + Number(t.Sum() * value.unit_ns / 1e9) + "\n";
+  }
+
+  void Run() {
+    if (config_.core >= 0) {
+      ThreadUtils::PinToCore(config_.core);
+    }
+    StatsSegmentReader reader;
+    while (running_.load(std::memory_order_relaxed)) {
+      // Wake up now and then to notice Stop()
+      pollfd pfd{listen_fd_, POLLIN, 0};
+      if (poll(&pfd, 1, 100) <= 0) {
+        continue;
+      }
+      const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd < 0) {
+        continue;
+      }
+      Serve(fd, reader);
+      close(fd);
+    }
+  }
+
+  void Serve(int fd, StatsSegmentReader& reader) {
+    // The request line is all we look at; give a slow client 1s for it
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+      pollfd pfd{fd, POLLIN, 0};
+      if (poll(&pfd, 1, 1000) <= 0) {
+        return;
+      }
+      const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) {
+        return;
+      }
+      request.append(buffer, static_cast<size_t>(n));
+    }
+
+    std::string status = "200 OK";
+    std::string body;
+    if (request.rfind("GET /metrics ", 0) != 0 && request.rfind("GET /metrics?", 0) != 0) {
+      status = "404 Not Found";
+      body = "Not found\n";
+    } else {
+      // Attach per scrape so a restarted pipeline's new segment is picked up
+      if (!reader.Attach(config_.segment)) {
+        status = "503 Service Unavailable";
+        body = reader.Error() + "\n";
+      } else {
+        body = Render(reader, config_.prefix);
+        scrapes_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    const std::string response =
+        "HTTP/1.1 " + status +
+        "\r\nContent-Type: application/openmetrics-text; version=1.0.0; charset=utf-8"
+        "\r\nContent-Length: " + std::to_string(body.size()) +
+        "\r\nConnection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+      const ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0) {
+        return;
+      }
+      sent += static_cast<size_t>(n);
+    }
+  }
+
+  Config config_;
+  int listen_fd_ = -1;
+  uint16_t port_ = 0;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> scrapes_{0};
+};
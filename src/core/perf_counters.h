@@ -0,0 +1,392 @@
+// src/core/perf_counters.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/interval_recorder.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PERF_COUNTERS_LINUX 1
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Hardware events counted around pipeline stages.
+enum class PerfEvent : uint8_t {
+  CYCLES,
+  INSTRUCTIONS,
+  L1D_MISSES,     // L1 data cache read misses
+  LLC_MISSES,     // Last-level cache misses
+  BRANCH_MISSES,
+};
+
+inline constexpr size_t kPerfEventCount = 5;
+
+inline const char* PerfEventName(PerfEvent event) {
+  static constexpr const char* kNames[kPerfEventCount] = {
+      "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+  return kNames[static_cast<size_t>(event)];
+}
+
+// One reading of every event, or a difference between two.
+struct PerfCounts {
+  std::array<uint64_t, kPerfEventCount> values{};
+
+  uint64_t operator[](PerfEvent event) const { return values[static_cast<size_t>(event)]; }
+
+  PerfCounts operator-(const PerfCounts& earlier) const {
+    PerfCounts delta;
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+      delta.values[i] = values[i] - earlier.values[i];
+    }
+    return delta;
+  }
+
+  PerfCounts& operator+=(const PerfCounts& other) {
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+      values[i] += other.values[i];
+    }
+    return *this;
+  }
+};
+
+// The calling thread's hardware counters, opened as one perf_event group so
+// every event covers the same instructions.
+//
+// Read() uses rdpmc from the counters' mmap pages when the kernel allows it
+// (a few dozen cycles per event, no syscall) and falls back to one read() of
+// the whole group otherwise. Counts are user-space only by default, which
+// is what rdpmc needs under perf_event_paranoid=2; time spent in the kernel
+// still shows up in the latency histograms. Read the group only from the
+// thread that opened it.
+//
+// Open() fails without a PMU (most VMs and containers) or permission; events
+// the CPU lacks are skipped and read as 0, see Available().
+class PerfCounterGroup {
+ public:
+  PerfCounterGroup() = default;
+  ~PerfCounterGroup() { Close(); }
+
+  PerfCounterGroup(const PerfCounterGroup&) = delete;
+  PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+  // Opens the events for the calling thread. False if not even the cycles
+  // counter, which leads the group, could be opened.
+  bool Open(bool user_only = true) {
+#ifdef PERF_COUNTERS_LINUX
+    Close();
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      SetEvent(static_cast<PerfEvent>(i), &attr);
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+      attr.exclude_kernel = user_only ? 1 : 0;
+      attr.exclude_hv = 1;
+      attr.disabled = i == 0 ? 1 : 0;  // The leader starts the group
+      const int fd = static_cast<int>(
+          syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0));
+      if (fd < 0) {
+        if (i == 0) {
+          return false;
+        }
+        continue;
+      }
+      fds_[i] = fd;
+      ioctl(fd, PERF_EVENT_IOC_ID, &ids_[i]);
+      // One page of metadata is enough for rdpmc
+      void* page = mmap(nullptr, static_cast<size_t>(sysconf(_SC_PAGESIZE)), PROT_READ,
+                        MAP_SHARED, fd, 0);
+      pages_[i] = page == MAP_FAILED ? nullptr : static_cast<perf_event_mmap_page*>(page);
+    }
+    ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    rdpmc_ = true;
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+      if (fds_[i] >= 0 && (pages_[i] == nullptr || !pages_[i]->cap_user_rdpmc)) {
+        rdpmc_ = false;
+      }
+    }
+#if !defined(__x86_64__) && !defined(__i386__)
+    rdpmc_ = false;
+#endif
+    return true;
+#else
+    (void)user_only;
+    return false;
+#endif
+  }
+
+  void Close() {
+#ifdef PERF_COUNTERS_LINUX
+    // Members before the leader
+    for (size_t i = kPerfEventCount; i-- > 0;) {
+      if (pages_[i] != nullptr) {
+        munmap(pages_[i], static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+        pages_[i] = nullptr;
+      }
+      if (fds_[i] >= 0) {
+        close(fds_[i]);
+        fds_[i] = -1;
+      }
+    }
+#endif
+    rdpmc_ = false;
+  }
+
+  // Current totals since Open(). False if the group isn't open, or a
+  // counter was off the PMU (multiplexed out) and the fallback read failed.
+  bool Read(PerfCounts* out) const {
+#ifdef PERF_COUNTERS_LINUX
+    if (fds_[0] < 0) {
+      return false;
+    }
+    if (rdpmc_) {
+      bool ok = true;
+      for (size_t i = 0; i < kPerfEventCount && ok; ++i) {
+        out->values[i] = fds_[i] >= 0 ? ReadMapped(pages_[i], &ok) : 0;
+      }
+      if (ok) {
+        return true;
+      }
+    }
+    return ReadGroup(out);
+#else
+    (void)out;
+    return false;
+#endif
+  }
+
+  bool IsOpen() const { return fds_[0] >= 0; }
+  bool Available(PerfEvent event) const { return fds_[static_cast<size_t>(event)] >= 0; }
+  bool UsesRdpmc() const { return rdpmc_; }
+
+ private:
+#ifdef PERF_COUNTERS_LINUX
+  static void SetEvent(PerfEvent event, perf_event_attr* attr) {
+    attr->type = PERF_TYPE_HARDWARE;
+    switch (event) {
+      case PerfEvent::CYCLES:
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case PerfEvent::INSTRUCTIONS:
+        attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case PerfEvent::L1D_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+      case PerfEvent::LLC_MISSES:
+        attr->config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+      case PerfEvent::BRANCH_MISSES:
+        attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+  }
+
+  // The self-monitoring sequence from linux/perf_event.h: retry until the
+  // kernel didn't update the page underneath us.
+  static uint64_t ReadMapped(const perf_event_mmap_page* page, bool* ok) {
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t seq = 0;
+    uint64_t count = 0;
+    uint32_t index = 0;
+    do {
+      seq = page->lock;
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+      index = page->index;
+      count = static_cast<uint64_t>(page->offset);
+      if (index != 0) {
+        const uint16_t width = page->pmc_width;
+        int64_t pmc = static_cast<int64_t>(__rdpmc(static_cast<int>(index - 1)));
+        pmc = static_cast<int64_t>(static_cast<uint64_t>(pmc) << (64 - width)) >> (64 - width);
+        count += static_cast<uint64_t>(pmc);
+      }
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+    } while (page->lock != seq);
+    if (index == 0) {
+      *ok = false;  // Not on the PMU right now
+    }
+    return count;
+#else
+    (void)page;
+    *ok = false;
+    return 0;
+#endif
+  }
+
+  bool ReadGroup(PerfCounts* out) const {
+    // PERF_FORMAT_GROUP | PERF_FORMAT_ID: nr, then {value, id} per event
+    uint64_t buffer[1 + 2 * kPerfEventCount] = {};
+    if (read(fds_[0], buffer, sizeof(buffer)) <= 0) {
+      return false;
+    }
+    out->values.fill(0);
+    for (uint64_t n = 0; n < buffer[0] && n < kPerfEventCount; ++n) {
+      const uint64_t value = buffer[1 + 2 * n];
+      const uint64_t id = buffer[2 + 2 * n];
+      for (size_t i = 0; i < kPerfEventCount; ++i) {
+        if (fds_[i] >= 0 && ids_[i] == id) {
+          out->values[i] = value;
+        }
+      }
+    }
+    return true;
+  }
+
+  perf_event_mmap_page* pages_[kPerfEventCount] = {};
+#endif
+  int fds_[kPerfEventCount] = {-1, -1, -1, -1, -1};
+  uint64_t ids_[kPerfEventCount] = {};
+  bool rdpmc_ = false;
+};
+
+// Counter totals for one stage over an interval: sums of per-message
+// deltas, and how many messages they cover.
+struct PerfStageTotals {
+  PerfCounts sum;
+  uint64_t samples = 0;
+
+  void Add(const PerfCounts& delta) {
+    sum += delta;
+    ++samples;
+  }
+
+  void Merge(const PerfStageTotals& other) {
+    sum += other.sum;
+    samples += other.samples;
+  }
+
+  void Reset() { *this = PerfStageTotals(); }
+
+  double PerSample(PerfEvent event) const {
+    return samples == 0 ? 0.0 : static_cast<double>(sum[event]) / static_cast<double>(samples);
+  }
+  double Ipc() const {
+    const uint64_t cycles = sum[PerfEvent::CYCLES];
+    return cycles == 0 ? 0.0
+                       : static_cast<double>(sum[PerfEvent::INSTRUCTIONS]) /
+                             static_cast<double>(cycles);
+  }
+};
+
+// Per-thread, per-stage counter deltas, handed to the reporter in intervals
+// through the same IntervalHandoff IntervalRecorder uses: the worker flips
+// between two buffers on an interval boundary and never waits for the
+// reporter.
+//
+// Begin() and End() bracket the stage on the thread that opened group. With
+// sample_every > 1 only every nth message is read, which bounds the cost
+// (two group reads) on stages that are only a few hundred cycles long.
+class PerfStageRecorder {
+ public:
+  PerfStageRecorder(const PerfCounterGroup* group, uint64_t interval_ticks,
+                    uint32_t sample_every = 1)
+      : group_(group),
+        sample_every_(sample_every == 0 ? 1 : sample_every),
+        handoff_(interval_ticks) {}
+
+  PerfStageRecorder(const PerfStageRecorder&) = delete;
+  PerfStageRecorder& operator=(const PerfStageRecorder&) = delete;
+
+  // Worker thread.
+  void Begin() {
+    sampled_ = ++calls_ % sample_every_ == 0 && group_ != nullptr && group_->Read(&begin_);
+  }
+
+  void End(uint64_t now_ticks) {
+    if (!sampled_) {
+      Tick(now_ticks);
+      return;
+    }
+    sampled_ = false;
+    PerfCounts end;
+    if (group_->Read(&end)) {
+      Record(end - begin_, now_ticks);
+    }
+  }
+
+  // Worker thread: adds one stage's counter delta, for callers that read
+  // the counters themselves.
+  void Record(const PerfCounts& delta, uint64_t now_ticks) {
+    handoff_.Tick(now_ticks);
+    handoff_.Active().Add(delta);
+  }
+
+  // Worker thread: closes the interval if now_ticks has passed its end.
+  void Tick(uint64_t now_ticks) { handoff_.Tick(now_ticks); }
+
+  // Reporter thread. Adds the last completed interval to out; false if
+  // nothing new was published.
+  bool Collect(PerfStageTotals& out) {
+    return handoff_.Collect(
+        [&](const PerfStageTotals& done, uint64_t, uint64_t) { out.Merge(done); });
+  }
+
+  // Worker-side count of flips deferred because the reporter lagged.
+  uint64_t ExtendedIntervals() const { return handoff_.ExtendedIntervals(); }
+
+ private:
+  const PerfCounterGroup* group_;
+  const uint32_t sample_every_;
+
+  // Worker-only
+  uint32_t calls_ = 0;
+  bool sampled_ = false;
+  PerfCounts begin_;
+
+  IntervalHandoff<PerfStageTotals> handoff_;
+};
+
+// Reporter side: named stages, each the sum of its recorders across threads.
+class PerfReporter {
+ public:
+  size_t AddStage(std::string name) {
+    stages_.push_back(Stage{std::move(name), {}, {}, {}});
+    return stages_.size() - 1;
+  }
+
+  void Add(size_t stage, PerfStageRecorder* recorder) {
+    stages_[stage].recorders.push_back(recorder);
+  }
+
+  // Call once per interval, alongside LatencyReporter::Collect().
+  void Collect() {
+    for (Stage& stage : stages_) {
+      stage.interval.Reset();
+      for (PerfStageRecorder* recorder : stage.recorders) {
+        recorder->Collect(stage.interval);
+      }
+      stage.cumulative.Merge(stage.interval);
+    }
+  }
+
+  size_t StageCount() const { return stages_.size(); }
+  const std::string& Name(size_t stage) const { return stages_[stage].name; }
+  const PerfStageTotals& Interval(size_t stage) const { return stages_[stage].interval; }
+  const PerfStageTotals& Cumulative(size_t stage) const { return stages_[stage].cumulative; }
+
+ private:
+  struct Stage {
+    std::string name;
+    std::vector<PerfStageRecorder*> recorders;
+    PerfStageTotals interval;
+    PerfStageTotals cumulative;
+  };
+
+  std::vector<Stage> stages_;
+};
@@ -32,6 +32,16 @@ class LockFreeRingBuffer {
     return true;
   }
   
+  // Items queued, for monitoring from a third thread. Reads both indices
+  // relaxed, so it's only approximate while either side is moving.
+  size_t Occupancy() const {
+    const size_t write = write_idx_.load(std::memory_order_relaxed);
+    const size_t read = read_idx_.load(std::memory_order_relaxed);
+    return (write + Size - read) % Size;
+  }
+  
+  static constexpr size_t Capacity() { return Size - 1; }
+  
  private:
   alignas(64) std::atomic<size_t> write_idx_{0};  // Cache line alignment
   alignas(64) std::atomic<size_t> read_idx_{0};
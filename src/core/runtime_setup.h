@@ -0,0 +1,197 @@
+// src/core/runtime_setup.h
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+// Linux 6.18; older headers lack it, older kernels reject it with EINVAL
+#ifndef PR_THP_DISABLE_EXCEPT_ADVISED
+#define PR_THP_DISABLE_EXCEPT_ADVISED (1 << 1)
+#endif
+#endif
+
+#include "core/thread_utils.h"
+
+// Process-wide hardening run once at startup, before the pipeline threads,
+// plus a per-thread step each pipeline thread runs first thing. Takes the
+// first-message and idle-wakeup spikes out of the latency profile:
+// - mlockall, so nothing we touch is paged out or faulted in lazily;
+// - malloc told to keep what is freed mapped: no mmap for large blocks,
+//   no trimming of the heap top. Process-wide, and what makes heap
+//   prefaulting stick;
+// - heap and stack prefaulting, so the first messages don't pay for
+//   page faults;
+// - /dev/cpu_dma_latency held at 0us, so idle cores stay out of deep
+//   C-states for as long as this object lives;
+// - THP off for this process except in ranges madvised for it, so no
+//   allocation stalls in compaction, while a HugePageArena keeps its huge
+//   pages. Needs Linux 6.18; older kernels fail the step and leave THP as
+//   the host has it. Explicit huge pages (MAP_HUGETLB) are unaffected.
+// Optionally, SCHED_FIFO per stage: only on isolated cores, as a
+// busy-spinning FIFO thread starves anything else scheduled there.
+//
+// Every step is recorded with whether it worked; most need root or
+// CAP_IPC_LOCK/CAP_SYS_NICE, and a failed step is a warning, not an error.
+class RuntimeSetup {
+ public:
+  struct Config {
+    bool lock_memory = true;
+    bool retain_heap = true;                      // mallopt, in Apply()
+    size_t prefault_heap_bytes = 64 << 20;        // Main arena, in Apply()
+    size_t prefault_thread_heap_bytes = 8 << 20;  // Each thread's arena
+    size_t prefault_stack_bytes = 256 << 10;      // Each thread
+    bool hold_dma_latency = true;
+    bool disable_thp = true;
+  };
+
+  struct Step {
+    std::string name;
+    bool ok = false;
+    std::string detail;
+  };
+
+  RuntimeSetup() : RuntimeSetup(Config()) {}
+  explicit RuntimeSetup(const Config& config) : config_(config) {}
+  ~RuntimeSetup() {
+#if defined(__linux__)
+    // Closing it lets the cores sleep again
+    if (dma_latency_fd_ >= 0) {
+      close(dma_latency_fd_);
+    }
+#endif
+  }
+
+  RuntimeSetup(const RuntimeSetup&) = delete;
+  RuntimeSetup& operator=(const RuntimeSetup&) = delete;
+
+  // Main thread, before starting any other. True if every step worked.
+  bool Apply() {
+    bool ok = true;
+#if defined(__linux__)
+    if (config_.disable_thp) {
+      // Never process-wide: that would also take THP from madvised arenas
+      ok &= Record("thp",
+                   prctl(PR_SET_THP_DISABLE, 1, PR_THP_DISABLE_EXCEPT_ADVISED, 0, 0) == 0,
+                   "disabled except madvised");
+    }
+    if (config_.lock_memory) {
+      // MCL_FUTURE also populates every later mapping, thread stacks included
+      ok &= Record("mlockall", mlockall(MCL_CURRENT | MCL_FUTURE) == 0, "current and future");
+    }
+    if (config_.retain_heap) {
+      ok &= Record("retain_heap", RetainHeap(), "no mmap, no trim");
+    }
+    if (config_.prefault_heap_bytes > 0) {
+      ok &= Record("prefault_heap", PrefaultHeap(config_.prefault_heap_bytes),
+                   std::to_string(config_.prefault_heap_bytes >> 20) + "MB");
+    }
+    if (config_.hold_dma_latency) {
+      ok &= Record("dma_latency", HoldDmaLatency(), "0us");
+    }
+#else
+    ok = Record("runtime_setup", false, "not supported on this platform");
+#endif
+    return ok;
+  }
+
+  // Each pipeline thread, first thing (after pinning): prefaults its stack
+  // and its malloc arena, and moves it to SCHED_FIFO at fifo_priority
+  // (1-99) if that's above 0. True if every step worked. The arena stays
+  // prefaulted only if Apply() retained the heap.
+  bool PrepareThread(const std::string& stage, int fifo_priority = 0) {
+    ThreadUtils::PrefaultStack(config_.prefault_stack_bytes);
+    bool ok = Record(stage + ".prefault_stack", true,
+                     std::to_string(config_.prefault_stack_bytes >> 10) + "KB");
+    if (config_.prefault_thread_heap_bytes > 0) {
+      ok &= Record(stage + ".prefault_heap", PrefaultHeap(config_.prefault_thread_heap_bytes),
+                   std::to_string(config_.prefault_thread_heap_bytes >> 20) + "MB");
+    }
+    if (fifo_priority > 0) {
+      ok &= Record(stage + ".sched_fifo", ThreadUtils::SetRealtimePriority(fifo_priority),
+                   "priority " + std::to_string(fifo_priority));
+    }
+    return ok;
+  }
+
+  std::vector<Step> Steps() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return steps_;
+  }
+
+  // One line per step: "mlockall: ok (current and future)" or
+  // "dma_latency: FAILED (Permission denied)".
+  std::string Report() const {
+    std::string out;
+    for (const Step& step : Steps()) {
+      out += step.name + (step.ok ? ": ok (" : ": FAILED (") + step.detail + ")\n";
+    }
+    return out;
+  }
+
+ private:
+  bool Record(const std::string& name, bool ok, const std::string& detail) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    steps_.push_back({name, ok, ok ? detail : std::strerror(errno)});
+    return ok;
+  }
+
+#if defined(__linux__)
+  // Large blocks would otherwise be separate mmaps, unmapped on free, and
+  // the top of each arena given back once it is free
+  static bool RetainHeap() {
+    if (mallopt(M_MMAP_MAX, 0) == 0 || mallopt(M_TRIM_THRESHOLD, -1) == 0) {
+      errno = EINVAL;
+      return false;
+    }
+    return true;
+  }
+#endif
+
+  // Touches bytes of the calling thread's malloc arena and gives it back,
+  // so later allocations land on pages already mapped.
+  static bool PrefaultHeap(size_t bytes) {
+    void* block = std::malloc(bytes);
+    if (block == nullptr) {
+      return false;
+    }
+    std::memset(block, 0, bytes);
+    // Keep the stores: memset before free is otherwise dead
+    asm volatile("" : : "r"(block) : "memory");
+    std::free(block);
+    return true;
+  }
+
+#if defined(__linux__)
+  bool HoldDmaLatency() {
+    dma_latency_fd_ = open("/dev/cpu_dma_latency", O_WRONLY | O_CLOEXEC);
+    if (dma_latency_fd_ < 0) {
+      return false;
+    }
+    const int32_t latency_us = 0;
+    if (write(dma_latency_fd_, &latency_us, sizeof(latency_us)) != sizeof(latency_us)) {
+      close(dma_latency_fd_);
+      dma_latency_fd_ = -1;
+      return false;
+    }
+    return true;
+  }
+#endif
+
+  const Config config_;
+  int dma_latency_fd_ = -1;
+  mutable std::mutex mutex_;
+  std::vector<Step> steps_;
+};
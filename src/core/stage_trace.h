@@ -0,0 +1,166 @@
+// src/core/stage_trace.h
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "core/interval_recorder.h"
+#include "core/latency_tracker.h"
+#include "core/thread_utils.h"
+#include "core/tsc_clock.h"
+
+// Points a message passes on its way from the socket to the book, in order.
+enum class Stage : uint8_t {
+  RECEIVE,             // Bytes handed to us by the client
+  PARSED,              // JSON parsed
+  RAW_ENQUEUE,         // Pushed to raw_buffer
+  RAW_DEQUEUE,         // Popped by the normalizer
+  NORMALIZED,          // Normalizer done
+  NORMALIZED_ENQUEUE,  // Pushed to normalized_buffer
+  NORMALIZED_DEQUEUE,  // Popped by the router
+  BOOK_APPLIED,        // Book shard applied it
+};
+
+inline constexpr size_t kStageCount = 8;
+
+inline const char* StageName(Stage stage) {
+  static constexpr const char* kNames[kStageCount] = {
+      "receive", "parsed", "raw_enqueue", "raw_dequeue",
+      "normalized", "normalized_enqueue", "normalized_dequeue", "book_applied"};
+  return kNames[static_cast<size_t>(stage)];
+}
+
+// TSC timestamps a message collects as it moves through the pipeline. The
+// receive tick is stored in full and the rest as 32-bit offsets from it;
+// offsets saturate about a second after receive on a 3-4GHz TSC, which only
+// ever hides how long a message was stuck. Each stamp also notes the core
+// its thread is pinned to, and dequeue stages can note the queue depth they
+// saw, so an outlier can be explained after the fact. 64 bytes in all.
+struct StageTrace {
+  uint64_t origin = 0;                            // RECEIVE tick; 0 = untraced
+  std::array<uint32_t, kStageCount - 1> offsets{};  // 0 = not stamped
+  std::array<uint16_t, kStageCount> depths{};       // Queue depth, see SetDepth()
+  std::array<uint8_t, kStageCount> cpus{};          // Pinned core + 1; 0 = unknown
+
+  void Stamp(Stage stage, uint64_t now = TscClock::Now()) {
+    if (stage == Stage::RECEIVE) {
+      origin = now;
+      offsets.fill(0);
+      depths.fill(0);
+      cpus.fill(0);
+      cpus[0] = CpuTag();
+      return;
+    }
+    if (origin == 0) {
+      return;
+    }
+    const uint64_t delta = now > origin ? now - origin : 0;
+    // 1 rather than 0 so a same-tick stamp still counts as stamped
+    offsets[static_cast<size_t>(stage) - 1] =
+        static_cast<uint32_t>(std::clamp<uint64_t>(delta, 1, UINT32_MAX));
+    cpus[static_cast<size_t>(stage)] = CpuTag();
+  }
+
+  // Items that were queued when the message was popped at stage.
+  void SetDepth(Stage stage, size_t depth) {
+    depths[static_cast<size_t>(stage)] =
+        static_cast<uint16_t>(std::min<size_t>(depth, UINT16_MAX));
+  }
+  size_t Depth(Stage stage) const { return depths[static_cast<size_t>(stage)]; }
+
+  // Core the stage ran on, or -1 if its thread wasn't pinned.
+  int Cpu(Stage stage) const { return static_cast<int>(cpus[static_cast<size_t>(stage)]) - 1; }
+
+  bool Has(Stage stage) const {
+    return stage == Stage::RECEIVE ? origin != 0
+                                   : origin != 0 && offsets[static_cast<size_t>(stage) - 1] != 0;
+  }
+
+  // Ticks since RECEIVE.
+  uint32_t Offset(Stage stage) const {
+    return stage == Stage::RECEIVE ? 0 : offsets[static_cast<size_t>(stage) - 1];
+  }
+
+ private:
+  static uint8_t CpuTag() {
+    const int core = ThreadUtils::PinnedCore();
+    return core < 0 || core >= UINT8_MAX ? 0 : static_cast<uint8_t>(core + 1);
+  }
+};
+
+static_assert(sizeof(StageTrace) == 64, "StageTrace should stay one cache line");
+
+// Per-thread per-hop histograms, fed by the thread that stamps a message's
+// last stage. Hop i covers stage i to the next stamped stage; hops whose
+// end wasn't stamped are skipped and the gap is folded into the next one.
+// A final recorder holds the end-to-end latency.
+class StageTraceRecorder {
+ public:
+  static constexpr size_t kHopCount = kStageCount - 1;
+  static constexpr size_t kTotal = kHopCount;  // Index of the end-to-end recorder
+
+  explicit StageTraceRecorder(uint64_t interval_ticks,
+                              const LatencyTracker::Config& config = LatencyTracker::Config()) {
+    for (size_t i = 0; i <= kHopCount; ++i) {
+      recorders_.push_back(std::make_unique<IntervalRecorder>(interval_ticks, config));
+    }
+  }
+
+  void Record(const StageTrace& trace, uint64_t now) {
+    if (trace.origin == 0) {
+      return;
+    }
+    size_t from = 0;
+    uint32_t from_offset = 0;
+    for (size_t s = 1; s < kStageCount; ++s) {
+      const uint32_t offset = trace.offsets[s - 1];
+      if (offset == 0) {
+        continue;
+      }
+      recorders_[s - 1]->Record(static_cast<int64_t>(offset) - from_offset, now);
+      from = s;
+      from_offset = offset;
+    }
+    if (from != 0) {
+      recorders_[kTotal]->Record(from_offset, now);
+    }
+  }
+
+  // Hop ending at stage (PARSED..BOOK_APPLIED), or kTotal.
+  IntervalRecorder* Hop(size_t index) { return recorders_[index].get(); }
+
+ private:
+  std::vector<std::unique_ptr<IntervalRecorder>> recorders_;
+};
+
+// Reporter side: per-hop interval and cumulative views across threads.
+class StageTraceReporter {
+ public:
+  explicit StageTraceReporter(const LatencyTracker::Config& config = LatencyTracker::Config()) {
+    for (size_t i = 0; i <= StageTraceRecorder::kHopCount; ++i) {
+      hops_.push_back(std::make_unique<LatencyReporter>(config));
+    }
+  }
+
+  void Add(StageTraceRecorder* recorder) {
+    for (size_t i = 0; i <= StageTraceRecorder::kHopCount; ++i) {
+      hops_[i]->Add(recorder->Hop(i));
+    }
+  }
+
+  void Collect() {
+    for (auto& hop : hops_) {
+      hop->Collect();
+    }
+  }
+
+  // Hop i ends at Stage(i + 1); StageTraceRecorder::kTotal is end to end.
+  const LatencyReporter& Hop(size_t index) const { return *hops_[index]; }
+
+ private:
+  std::vector<std::unique_ptr<LatencyReporter>> hops_;
+};
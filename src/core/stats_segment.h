@@ -0,0 +1,372 @@
+// src/core/stats_segment.h
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "core/latency_tracker.h"
+#include "core/tsc_clock.h"
+
+// Shared-memory stats, published by the pipeline and rendered by a separate
+// process (src/tools/stats_viewer.cpp), so the pipeline never formats text.
+//
+// The segment is a header, a fixed table of named slots and a data area for
+// histogram buckets. Slots are registered at startup and never move; the
+// header's slot_count is released after a slot is filled in, so a reader
+// only ever sees complete slot descriptions. Counters and gauges are single
+// atomics any thread may store. A histogram has one writer and is copied
+// under a per-slot sequence number: odd while a copy is in progress, and a
+// reader that sees it change retries. Everything shared is accessed through
+// atomics, so the viewer can attach and detach at any time.
+//
+// Readers check magic and version before trusting anything else; bump
+// kStatsLayoutVersion on any change to the structs below.
+inline constexpr uint64_t kStatsMagic = 0x5354415453'4c4c00;  // "\0LLSTATS"
+inline constexpr uint32_t kStatsLayoutVersion = 2;
+inline constexpr size_t kStatsNameSize = 64;
+inline constexpr const char* kDefaultStatsSegment = "/low_latency_stats";
+
+enum class StatKind : uint32_t {
+  COUNTER,    // Monotonic count; viewers show the rate too
+  GAUGE,      // Value as of the last publish
+  HISTOGRAM,           // LatencyTracker buckets, everything since start
+  INTERVAL_HISTOGRAM,  // LatencyTracker buckets for the last interval only
+};
+
+struct StatsHeader {
+  std::atomic<uint64_t> magic;  // Stored last when creating
+  uint32_t version;
+  uint32_t slot_capacity;
+  uint64_t size;         // Bytes in the segment
+  uint64_t data_offset;  // Start of the bucket area
+  uint32_t pid;
+  std::atomic<uint32_t> slot_count;
+  std::atomic<uint64_t> publishes;     // Bumped by Publish()
+  std::atomic<uint64_t> published_ns;  // CLOCK_MONOTONIC at the last Publish()
+};
+
+struct alignas(64) StatsSlot {
+  char name[kStatsNameSize];
+  StatKind kind;
+  uint32_t precision_bits;  // Histogram config, to rebuild the tracker
+  int64_t max_value;
+  double unit_ns;           // ns per recorded unit, e.g. 1/ticks-per-ns
+  uint64_t bucket_offset;   // From the start of the segment
+  uint64_t bucket_count;
+
+  std::atomic<int64_t> counter;
+  std::atomic<double> gauge;
+
+  // Histogram summary and buckets, under seq
+  std::atomic<uint64_t> seq;
+  std::atomic<double> sum;
+  std::atomic<int64_t> min;
+  std::atomic<int64_t> max;
+};
+
+inline bool IsHistogram(StatKind kind) {
+  return kind == StatKind::HISTOGRAM || kind == StatKind::INTERVAL_HISTOGRAM;
+}
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<double>::is_always_lock_free,
+              "Stats shared between processes must be lock-free");
+
+// Writer side: owns the segment and unlinks it on destruction.
+class StatsSegment {
+ public:
+  StatsSegment() = default;
+  ~StatsSegment() { Close(); }
+
+  StatsSegment(const StatsSegment&) = delete;
+  StatsSegment& operator=(const StatsSegment&) = delete;
+
+  // Creates (or replaces) the named POSIX shared-memory segment. False if
+  // it can't be created or mapped.
+  bool Create(const std::string& name = kDefaultStatsSegment, size_t slots = 128,
+              size_t bytes = 8 << 20) {
+    Close();
+    const size_t data_offset = Align(sizeof(StatsHeader)) + slots * sizeof(StatsSlot);
+    if (bytes <= data_offset) {
+      return false;
+    }
+    const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+      return false;
+    }
+    void* base = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+      base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+      shm_unlink(name.c_str());
+      return false;
+    }
+    name_ = name;
+    base_ = static_cast<char*>(base);
+    size_ = bytes;
+    data_used_ = data_offset;
+
+    // ftruncate zero-filled it; fill in the layout, then the magic
+    header_ = new (base_) StatsHeader();
+    header_->version = kStatsLayoutVersion;
+    header_->slot_capacity = static_cast<uint32_t>(slots);
+    header_->size = bytes;
+    header_->data_offset = data_offset;
+    header_->pid = static_cast<uint32_t>(getpid());
+    slots_ = reinterpret_cast<StatsSlot*>(base_ + Align(sizeof(StatsHeader)));
+    header_->magic.store(kStatsMagic, std::memory_order_release);
+    return true;
+  }
+
+  void Close() {
+    if (base_ == nullptr) {
+      return;
+    }
+    munmap(base_, size_);
+    shm_unlink(name_.c_str());
+    base_ = nullptr;
+    header_ = nullptr;
+    slots_ = nullptr;
+  }
+
+  // Registration, at startup from one thread. Not thread-safe: calls must
+  // not race each other, though they may race readers and the Set calls
+  // on slots already registered. Each returns the slot id, or -1 if the
+  // segment is full or not created.
+  int AddCounter(const std::string& name) { return AddSlot(name, StatKind::COUNTER, 0); }
+  int AddGauge(const std::string& name) { return AddSlot(name, StatKind::GAUGE, 0); }
+  int AddHistogram(const std::string& name,
+                   const LatencyTracker::Config& config = LatencyTracker::Config(),
+                   double unit_ns = 1.0, bool interval = false) {
+    const size_t buckets = LatencyTracker(config).BucketCount();
+    const int id = AddSlot(name, interval ? StatKind::INTERVAL_HISTOGRAM : StatKind::HISTOGRAM,
+                           buckets);
+    if (id >= 0) {
+      slots_[id].precision_bits = config.precision_bits;
+      slots_[id].max_value = config.max_value;
+      slots_[id].unit_ns = unit_ns;
+    }
+    return id;
+  }
+
+  // Any thread; one relaxed store.
+  void SetCounter(int id, int64_t value) {
+    if (id >= 0) slots_[id].counter.store(value, std::memory_order_relaxed);
+  }
+  void SetGauge(int id, double value) {
+    if (id >= 0) slots_[id].gauge.store(value, std::memory_order_relaxed);
+  }
+
+  // One writer per histogram. Copies the buckets and summary; false if the
+  // tracker's config doesn't match the one registered.
+  bool SetHistogram(int id, const LatencyTracker& tracker) {
+    if (id < 0) {
+      return false;
+    }
+    StatsSlot& slot = slots_[id];
+    const std::vector<uint64_t>& buckets = tracker.Buckets();
+    if (!IsHistogram(slot.kind) || buckets.size() != slot.bucket_count) {
+      return false;
+    }
+    const uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    uint64_t* data = reinterpret_cast<uint64_t*>(base_ + slot.bucket_offset);
+    for (size_t i = 0; i < buckets.size(); ++i) {
+      std::atomic_ref<uint64_t>(data[i]).store(buckets[i], std::memory_order_relaxed);
+    }
+    slot.sum.store(tracker.Sum(), std::memory_order_relaxed);
+    slot.min.store(tracker.MinLatency(), std::memory_order_relaxed);
+    slot.max.store(tracker.MaxLatency(), std::memory_order_relaxed);
+    slot.seq.store(seq + 2, std::memory_order_release);
+    return true;
+  }
+
+  // Marks a consistent round of updates, e.g. once per stats interval.
+  void Publish() {
+    if (header_ == nullptr) {
+      return;
+    }
+    header_->published_ns.store(TscClock::MonotonicNs(), std::memory_order_relaxed);
+    header_->publishes.fetch_add(1, std::memory_order_release);
+  }
+
+  bool IsOpen() const { return base_ != nullptr; }
+  const std::string& Name() const { return name_; }
+
+ private:
+  static size_t Align(size_t bytes) { return (bytes + 63) & ~size_t{63}; }
+
+  int AddSlot(const std::string& name, StatKind kind, size_t buckets) {
+    if (base_ == nullptr) {
+      return -1;
+    }
+    const uint32_t id = header_->slot_count.load(std::memory_order_relaxed);
+    const size_t bytes = Align(buckets * sizeof(uint64_t));
+    if (id >= header_->slot_capacity || data_used_ + bytes > size_) {
+      return -1;
+    }
+    StatsSlot* slot = new (&slots_[id]) StatsSlot();
+    std::strncpy(slot->name, name.c_str(), kStatsNameSize - 1);
+    slot->kind = kind;
+    slot->unit_ns = 1.0;
+    slot->bucket_offset = data_used_;
+    slot->bucket_count = buckets;
+    data_used_ += bytes;
+    header_->slot_count.store(id + 1, std::memory_order_release);
+    return static_cast<int>(id);
+  }
+
+  std::string name_;
+  char* base_ = nullptr;
+  size_t size_ = 0;
+  size_t data_used_ = 0;
+  StatsHeader* header_ = nullptr;
+  StatsSlot* slots_ = nullptr;
+};
+
+// Reader side, for viewers in another process.
+class StatsSegmentReader {
+ public:
+  struct Value {
+    std::string name;
+    StatKind kind = StatKind::COUNTER;
+    int64_t counter = 0;
+    double gauge = 0.0;
+    double unit_ns = 1.0;
+    LatencyTracker histogram;
+  };
+
+  StatsSegmentReader() = default;
+  ~StatsSegmentReader() { Detach(); }
+
+  StatsSegmentReader(const StatsSegmentReader&) = delete;
+  StatsSegmentReader& operator=(const StatsSegmentReader&) = delete;
+
+  // Maps the segment read-only. False if it doesn't exist yet or was
+  // written by a different layout version; see Error().
+  bool Attach(const std::string& name = kDefaultStatsSegment) {
+    Detach();
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+      error_ = "no segment " + name;
+      return false;
+    }
+    struct stat st {};
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(StatsHeader)) {
+      base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+      error_ = "can't map " + name;
+      return false;
+    }
+    base_ = static_cast<const char*>(base);
+    size_ = static_cast<size_t>(st.st_size);
+    header_ = reinterpret_cast<const StatsHeader*>(base_);
+    if (header_->magic.load(std::memory_order_acquire) != kStatsMagic) {
+      error_ = "segment not initialized";
+      Detach();
+      return false;
+    }
+    if (header_->version != kStatsLayoutVersion || header_->size != size_) {
+      error_ = "segment layout version " + std::to_string(header_->version) +
+               ", viewer understands " + std::to_string(kStatsLayoutVersion);
+      Detach();
+      return false;
+    }
+    slots_ = reinterpret_cast<const StatsSlot*>(base_ + ((sizeof(StatsHeader) + 63) & ~size_t{63}));
+    return true;
+  }
+
+  void Detach() {
+    if (base_ != nullptr) {
+      munmap(const_cast<char*>(base_), size_);
+    }
+    base_ = nullptr;
+    header_ = nullptr;
+    slots_ = nullptr;
+  }
+
+  size_t SlotCount() const {
+    return header_ == nullptr ? 0 : header_->slot_count.load(std::memory_order_acquire);
+  }
+  uint64_t Publishes() const {
+    return header_ == nullptr ? 0 : header_->publishes.load(std::memory_order_acquire);
+  }
+  uint64_t PublishedNs() const {
+    return header_ == nullptr ? 0 : header_->published_ns.load(std::memory_order_relaxed);
+  }
+  uint32_t Pid() const { return header_ == nullptr ? 0 : header_->pid; }
+  const std::string& Error() const { return error_; }
+
+  // Copies slot id into out, retrying while its writer is mid-update. False
+  // if the slot doesn't exist, or if a histogram stays mid-update for
+  // kReadAttempts tries: a writer that died mid-copy leaves its seq odd.
+  bool Read(size_t id, Value* out) const {
+    if (id >= SlotCount()) {
+      return false;
+    }
+    const StatsSlot& slot = slots_[id];
+    out->name.assign(slot.name, strnlen(slot.name, kStatsNameSize));
+    out->kind = slot.kind;
+    out->unit_ns = slot.unit_ns;
+    out->counter = slot.counter.load(std::memory_order_relaxed);
+    out->gauge = slot.gauge.load(std::memory_order_relaxed);
+    if (!IsHistogram(slot.kind)) {
+      return true;
+    }
+    if (out->histogram.BucketCount() != slot.bucket_count ||
+        out->histogram.GetConfig().precision_bits != slot.precision_bits) {
+      out->histogram = LatencyTracker(LatencyTracker::Config{slot.precision_bits, slot.max_value});
+    }
+    buckets_.resize(slot.bucket_count);
+    const uint64_t* data = reinterpret_cast<const uint64_t*>(base_ + slot.bucket_offset);
+    for (size_t attempt = 0; attempt < kReadAttempts; ++attempt) {
+      if (attempt > 0) {
+        std::this_thread::yield();
+      }
+      const uint64_t before = slot.seq.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;
+      }
+      for (size_t i = 0; i < buckets_.size(); ++i) {
+        buckets_[i] = std::atomic_ref<uint64_t>(const_cast<uint64_t&>(data[i])).load(std::memory_order_relaxed);
+      }
+      const double sum = slot.sum.load(std::memory_order_relaxed);
+      const int64_t min = slot.min.load(std::memory_order_relaxed);
+      const int64_t max = slot.max.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq.load(std::memory_order_relaxed) == before) {
+        return out->histogram.Load(buckets_.data(), buckets_.size(), sum, min, max);
+      }
+    }
+    return false;
+  }
+
+ private:
+  // A copy takes microseconds; this many yields is far longer
+  static constexpr size_t kReadAttempts = 10'000;
+
+  const char* base_ = nullptr;
+  size_t size_ = 0;
+  const StatsHeader* header_ = nullptr;
+  const StatsSlot* slots_ = nullptr;
+  std::string error_;
+  mutable std::vector<uint64_t> buckets_;
+};
@@ -0,0 +1,109 @@
+// src/core/thread_utils.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "core/cpu_topology.h"
+
+class ThreadUtils {
+ public:
+  // Pins the calling thread to one CPU. Returns false if the core doesn't
+  // exist or the platform has no affinity support.
+  static bool PinToCore(int core) {
+#if defined(__linux__)
+    if (core < 0 || core >= CPU_SETSIZE) {
+      return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+      return false;
+    }
+    pinned_core_ = core;
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    if (std::find(pinned_cores_.begin(), pinned_cores_.end(), core) == pinned_cores_.end()) {
+      pinned_cores_.push_back(core);
+    }
+    return true;
+#else
+    (void)core;
+    return false;
+#endif
+  }
+
+  static int CoreCount() {
+    return static_cast<int>(std::thread::hardware_concurrency());
+  }
+
+  // This host's CPUs as sysfs describes them, discovered on first use.
+  // Plan placements with a PlacementPlanner over it rather than
+  // hard-coding core numbers.
+  static const CpuTopology& Topology() {
+    static const CpuTopology topology = CpuTopology::Discover();
+    return topology;
+  }
+
+  // The core the calling thread was last pinned to by PinToCore(), or -1.
+  // A thread-local load, cheap enough to tag every message with.
+  static int PinnedCore() { return pinned_core_; }
+
+  // Every core PinToCore() has pinned a thread to so far, in order.
+  static std::vector<int> PinnedCores() {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    return pinned_cores_;
+  }
+
+  // Runs the calling thread under SCHED_IDLE, so it only gets a core that
+  // nothing else wants. For probes and housekeeping, never the pipeline.
+  static bool SetIdlePriority() {
+#if defined(__linux__)
+    sched_param param{};
+    param.sched_priority = 0;
+    return pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0;
+#else
+    return false;
+#endif
+  }
+
+  // Runs the calling thread under SCHED_FIFO at priority (1-99). Only for
+  // threads alone on an isolated core: a spinning FIFO thread never yields.
+  static bool SetRealtimePriority(int priority) {
+#if defined(__linux__)
+    sched_param param{};
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+    (void)priority;
+    return false;
+#endif
+  }
+
+  // Touches bytes of stack below the caller, so the thread's first deep
+  // call path doesn't take page faults. No-op off Linux.
+  [[gnu::noinline]] static void PrefaultStack(size_t bytes) {
+#if defined(__linux__)
+    volatile char* stack = static_cast<char*>(alloca(bytes));
+    for (size_t i = 0; i < bytes; i += 4096) {
+      stack[i] = 0;
+    }
+#else
+    (void)bytes;
+#endif
+  }
+
+ private:
+  static inline thread_local int pinned_core_ = -1;
+  static inline std::mutex registry_mutex_;
+  static inline std::vector<int> pinned_cores_;
+};
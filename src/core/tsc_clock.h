@@ -0,0 +1,131 @@
+// src/core/tsc_clock.h
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TSC_CLOCK_X86 1
+#endif
+
+// Timestamp counter clock for hot-path timing.
+//
+// Now() is a single rdtsc, well under the cost of a vDSO clock_gettime.
+// Timestamps are raw ticks: store and subtract them as they are, and convert
+// to ns only when reporting, using the rate measured by Calibrate() against
+// CLOCK_MONOTONIC. Ticks are only comparable across cores, and only a
+// steady rate, when the CPU has an invariant TSC; check InvariantTsc() at
+// startup. On other architectures the "ticks" are CLOCK_MONOTONIC ns.
+class TscClock {
+ public:
+  // Start-of-interval timestamp. Not ordered against surrounding loads and
+  // stores, so it may read slightly early.
+  static uint64_t Now() {
+#ifdef TSC_CLOCK_X86
+    return __rdtsc();
+#else
+    return MonotonicNs();
+#endif
+  }
+
+  // End-of-interval timestamp: rdtscp waits for prior instructions to
+  // finish, so the measured work can't leak past it.
+  static uint64_t NowOrdered() {
+#ifdef TSC_CLOCK_X86
+    unsigned int aux;
+    return __rdtscp(&aux);
+#else
+    return MonotonicNs();
+#endif
+  }
+
+  static uint64_t MonotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + static_cast<uint64_t>(ts.tv_nsec);
+  }
+
+  // CPUID 0x80000007 EDX bit 8: constant rate across P-states and C-states.
+  static bool InvariantTsc() {
+#ifdef TSC_CLOCK_X86
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) {
+      return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+#else
+    return true;
+#endif
+  }
+
+  // Measures the tick rate over duration. Blocks the caller; run it once at
+  // startup, before the pipeline threads. Returns false if the TSC isn't
+  // invariant, in which case conversions are only rough.
+  bool Calibrate(std::chrono::nanoseconds duration = std::chrono::milliseconds(100)) {
+#ifdef TSC_CLOCK_X86
+    uint64_t start_ticks = 0, start_ns = 0;
+    Sample(&start_ticks, &start_ns);
+    std::this_thread::sleep_for(duration);
+    uint64_t end_ticks = 0, end_ns = 0;
+    Sample(&end_ticks, &end_ns);
+    if (end_ns > start_ns && end_ticks > start_ticks) {
+      ticks_per_ns_ = static_cast<double>(end_ticks - start_ticks) /
+                      static_cast<double>(end_ns - start_ns);
+      ns_per_tick_ = 1.0 / ticks_per_ns_;
+    }
+    base_ticks_ = end_ticks;
+    base_ns_ = end_ns;
+    calibrated_ = true;
+    return InvariantTsc();
+#else
+    (void)duration;
+    base_ticks_ = base_ns_ = MonotonicNs();
+    calibrated_ = true;
+    return true;
+#endif
+  }
+
+  // Tick durations to ns and back.
+  double ToNanos(uint64_t ticks) const { return static_cast<double>(ticks) * ns_per_tick_; }
+  double ToNanos(int64_t ticks) const { return static_cast<double>(ticks) * ns_per_tick_; }
+  uint64_t FromNanos(uint64_t ns) const {
+    return static_cast<uint64_t>(static_cast<double>(ns) * ticks_per_ns_);
+  }
+
+  // A tick timestamp on the CLOCK_MONOTONIC timeline.
+  uint64_t ToMonotonicNs(uint64_t ticks) const {
+    const double delta = static_cast<double>(static_cast<int64_t>(ticks - base_ticks_));
+    return base_ns_ + static_cast<int64_t>(delta * ns_per_tick_);
+  }
+
+  double TicksPerNs() const { return ticks_per_ns_; }
+  bool Calibrated() const { return calibrated_; }
+
+ private:
+  // Reads the TSC either side of clock_gettime and keeps the tightest of a
+  // few tries, so a preemption between the reads doesn't skew the pair.
+  static void Sample(uint64_t* ticks, uint64_t* ns) {
+    uint64_t best_gap = UINT64_MAX;
+    for (int i = 0; i < 16; ++i) {
+      const uint64_t before = NowOrdered();
+      const uint64_t mono = MonotonicNs();
+      const uint64_t after = NowOrdered();
+      if (after - before < best_gap) {
+        best_gap = after - before;
+        *ticks = before + (after - before) / 2;
+        *ns = mono;
+      }
+    }
+  }
+
+  double ticks_per_ns_ = 1.0;
+  double ns_per_tick_ = 1.0;
+  uint64_t base_ticks_ = 0;
+  uint64_t base_ns_ = 0;
+  bool calibrated_ = false;
+};
@@ -8,6 +8,10 @@ class BinanceClient {
   bool Connect(const std::vector<std::string>& symbols);
   void Disconnect();
   
+  // REST depth snapshot (/api/v3/depth) for rebuilding a book; blocking,
+  // so never from a pipeline thread
+  bool FetchDepthSnapshot(const std::string& symbol, DepthSnapshot* out);
+  
  private:
   std::function<void(const std::string&)> message_handler_;
   std::unique_ptr<WebSocketClient> ws_client_;  // WebSocket implementation
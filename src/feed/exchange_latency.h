@@ -0,0 +1,223 @@
+// src/feed/exchange_latency.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "core/latency_tracker.h"
+#include "models/normalized_update.h"
+#include "models/symbol_table.h"
+
+// Tracks the offset between the exchange's clock and ours from one-way
+// samples (local receive time minus exchange event time).
+//
+// Each sample is true latency plus the clock offset, and latency is never
+// below the path's floor, so the minimum per window is the offset plus that
+// floor with the queueing noise filtered out. A least-squares line through
+// the last few window minima gives the drift. The floor can't be separated
+// from the offset with one-way data; Offset() includes it, so latency
+// measured against it is latency above the best the path has shown.
+class ClockOffsetEstimator {
+ public:
+  struct Config {
+    int64_t window_ns = 10'000'000'000;  // Minimum-filter window
+    size_t history = 30;                 // Windows in the drift fit
+  };
+
+  ClockOffsetEstimator() : ClockOffsetEstimator(Config()) {}
+  explicit ClockOffsetEstimator(const Config& config) : config_(config) {}
+
+  // Returns true if the sample closed a window.
+  bool Add(int64_t local_ns, int64_t delta_ns) {
+    bool closed = false;
+    if (window_count_ != 0 && local_ns - window_start_ >= config_.window_ns) {
+      CloseWindow();
+      closed = true;
+    }
+    if (window_count_ == 0) {
+      window_start_ = local_ns;
+      window_min_ = delta_ns;
+      window_min_at_ = local_ns;
+    } else if (delta_ns < window_min_) {
+      window_min_ = delta_ns;
+      window_min_at_ = local_ns;
+    }
+    ++window_count_;
+    return closed;
+  }
+
+  // Estimated delta floor at local time t, in ns.
+  double Offset(int64_t local_ns) const {
+    if (minima_.size() < 2) {
+      return static_cast<double>(minima_.empty() ? window_min_ : minima_.back().delta);
+    }
+    return intercept_ + slope_ * static_cast<double>(local_ns - fit_origin_);
+  }
+
+  // Our clock's rate relative to the exchange's, in parts per million.
+  double DriftPpm() const { return slope_ * 1e6; }
+
+  // Minimum of the window in progress, for spotting a path change before it
+  // closes.
+  int64_t WindowMin() const { return window_min_; }
+  int64_t LastWindowMin() const { return minima_.empty() ? window_min_ : minima_.back().delta; }
+  size_t Windows() const { return minima_.size(); }
+  bool Ready() const { return !minima_.empty(); }
+
+ private:
+  struct Minimum {
+    int64_t at;
+    int64_t delta;
+  };
+
+  void CloseWindow() {
+    minima_.push_back({window_min_at_, window_min_});
+    if (minima_.size() > config_.history) {
+      minima_.pop_front();
+    }
+    window_count_ = 0;
+    Fit();
+  }
+
+  void Fit() {
+    if (minima_.size() < 2) {
+      return;
+    }
+    // Centre on the first point so the sums stay well-conditioned
+    fit_origin_ = minima_.front().at;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (const Minimum& m : minima_) {
+      const double x = static_cast<double>(m.at - fit_origin_);
+      const double y = static_cast<double>(m.delta);
+      sx += x;
+      sy += y;
+      sxx += x * x;
+      sxy += x * y;
+    }
+    const double n = static_cast<double>(minima_.size());
+    const double denom = n * sxx - sx * sx;
+    slope_ = denom > 0.0 ? (n * sxy - sx * sy) / denom : 0.0;
+    intercept_ = (sy - slope_ * sx) / n;
+  }
+
+  Config config_;
+  int64_t window_start_ = 0;
+  int64_t window_min_ = 0;
+  int64_t window_min_at_ = 0;
+  uint64_t window_count_ = 0;
+  std::deque<Minimum> minima_;
+  int64_t fit_origin_ = 0;
+  double slope_ = 0.0;
+  double intercept_ = 0.0;
+};
+
+// Exchange-to-local latency for one connection: the clock offset, latency
+// above the path floor overall and per symbol, and a degraded flag for
+// failover decisions.
+//
+// exchange_ts is in exchange units (Binance event times are ms) and
+// received_ts in ns on the same epoch. Latency here is therefore everything
+// between the exchange stamping an event and our socket read, which isn't
+// ours to fix; compare it with StageTrace hops to see what is.
+class ExchangeLatencyMonitor {
+ public:
+  enum Degradation : uint32_t {
+    NONE = 0,
+    HIGH_TAIL = 1u << 0,     // Window p99 above degraded_p99_ns
+    FLOOR_SHIFT = 1u << 1,   // Window minimum moved off the fitted floor
+    STALLED = 1u << 2,       // No updates for stall_ns
+  };
+
+  struct Config {
+    int64_t exchange_ts_unit_ns = 1'000'000;
+    ClockOffsetEstimator::Config clock;
+    int64_t degraded_p99_ns = 50'000'000;
+    int64_t degraded_floor_shift_ns = 5'000'000;
+    int64_t stall_ns = 5'000'000'000;
+    // Per-symbol histograms are coarse so thousands of symbols stay cheap
+    LatencyTracker::Config symbol_tracker{5, 10'000'000'000};
+  };
+
+  ExchangeLatencyMonitor(size_t max_symbols, const Config& config)
+      : config_(config), offset_(config.clock), symbols_(max_symbols) {}
+  explicit ExchangeLatencyMonitor(size_t max_symbols)
+      : ExchangeLatencyMonitor(max_symbols, Config()) {}
+
+  void OnUpdate(SymbolId symbol, const NormalizedUpdate& update) {
+    const int64_t exchange_ns =
+        static_cast<int64_t>(update.exchange_ts) * config_.exchange_ts_unit_ns;
+    const int64_t local_ns = static_cast<int64_t>(update.received_ts);
+    const int64_t delta = local_ns - exchange_ns;
+    last_local_ns_ = local_ns;
+
+    // Where the floor should be by the current trend, before this sample
+    // can close a window and refit it
+    const bool trended = offset_.Windows() >= 2;
+    const double expected_floor = offset_.Offset(local_ns);
+    if (offset_.Add(local_ns, delta)) {
+      CloseWindow(trended, expected_floor);
+    }
+    if (!offset_.Ready()) {
+      return;  // Nothing to measure against until the first window closes
+    }
+    const int64_t latency =
+        std::max<int64_t>(0, delta - static_cast<int64_t>(offset_.Offset(local_ns)));
+    window_.RecordLatency(latency);
+    cumulative_.RecordLatency(latency);
+    if (symbol < symbols_.size()) {
+      if (!symbols_[symbol]) {
+        symbols_[symbol] = std::make_unique<LatencyTracker>(config_.symbol_tracker);
+      }
+      symbols_[symbol]->RecordLatency(latency);
+    }
+  }
+
+  // Bitmask of Degradation reasons as of now_ns (local clock).
+  uint32_t Degraded(int64_t now_ns) const {
+    uint32_t reasons = degraded_;
+    if (last_local_ns_ != 0 && now_ns - last_local_ns_ > config_.stall_ns) {
+      reasons |= STALLED;
+    }
+    return reasons;
+  }
+
+  const ClockOffsetEstimator& Clock() const { return offset_; }
+  const LatencyTracker& Cumulative() const { return cumulative_; }
+  // Distribution over the last closed window
+  const LatencyTracker& LastWindow() const { return last_window_; }
+  // nullptr for symbols with no updates yet
+  const LatencyTracker* Symbol(SymbolId symbol) const {
+    return symbol < symbols_.size() ? symbols_[symbol].get() : nullptr;
+  }
+
+ private:
+  void CloseWindow(bool trended, double expected_floor) {
+    last_window_.Reset();
+    last_window_.Merge(window_);
+    window_.Reset();
+
+    degraded_ = NONE;
+    if (last_window_.Count() != 0 &&
+        last_window_.PercentileLatency(99) > config_.degraded_p99_ns) {
+      degraded_ |= HIGH_TAIL;
+    }
+    // A path that got longer shows as a window floor above the trend
+    if (trended && static_cast<double>(offset_.LastWindowMin()) - expected_floor >
+                       static_cast<double>(config_.degraded_floor_shift_ns)) {
+      degraded_ |= FLOOR_SHIFT;
+    }
+  }
+
+  Config config_;
+  ClockOffsetEstimator offset_;
+  LatencyTracker window_;
+  LatencyTracker last_window_;
+  LatencyTracker cumulative_;
+  std::vector<std::unique_ptr<LatencyTracker>> symbols_;
+  int64_t last_local_ns_ = 0;
+  uint32_t degraded_ = NONE;
+};
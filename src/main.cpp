@@ -1,100 +1,490 @@
 // src/main.cpp
 int main() {
-  // Initialize buffers
-  LockFreeRingBuffer<MarketUpdate, 4096> raw_buffer;
-  LockFreeRingBuffer<NormalizedUpdate, 4096> normalized_buffer;
+  // Hot-path timestamps are raw TSC ticks, converted to ns only for reports
+  TscClock tsc;
+  if (!tsc.Calibrate()) {
+    std::cerr << "Warning: no invariant TSC, latency figures are approximate"
+              << std::endl;
+  }
   
-  // Latency tracking
-  LatencyTracker raw_to_normalized_latency;
-  LatencyTracker processing_latency;
+  // Thread placement from this host's topology: the feed -> normalize ->
+  // processing -> book chain on separate physical cores sharing a cache
+  // domain, housekeeping on core 0. Unpinned if the host is too small.
+  PlacementPlanner placement(ThreadUtils::Topology());
+  const size_t feed_stage = placement.AddStage("feed");
+  const size_t normalize_stage = placement.AddStage("normalize");
+  const size_t processing_stage = placement.AddStage("processing");
+  const size_t book_stages = placement.AddStage("book", 4);
+  if (!placement.Plan()) {
+    std::cerr << "Warning: running unpinned: " << placement.Error() << std::endl;
+  }
+  // -1 (unpinned) if the config lists no housekeeping core
+  const int housekeeping_core =
+      placement.Housekeeping().empty() ? -1 : placement.Housekeeping().front();
+  
+  // Rings on huge pages, on the node of the cores that use them; 64MB
+  // leaves room for more hot structures. On the heap instead if the arena
+  // couldn't be mapped or is full.
+  HugePageArena::Config arena_config;
+  if (const CpuInfo* cpu = ThreadUtils::Topology().Find(placement.Core(normalize_stage))) {
+    arena_config.node = cpu->node;
+  }
+  HugePageArena arena(arena_config);
+  if (const int error = arena.Stats().bind_error) {
+    std::cerr << "Warning: arena not bound to node " << arena_config.node << ": "
+              << std::strerror(error) << std::endl;
+  }
+  std::vector<std::shared_ptr<void>> heap_rings;
+  auto make_ring = [&]<typename Ring>(std::type_identity<Ring>) -> Ring& {
+    if (Ring* ring = arena.Create<Ring>()) {
+      return *ring;
+    }
+    std::cerr << "Warning: ring of " << sizeof(Ring) << " bytes on the heap, not the arena"
+              << std::endl;
+    auto ring = std::make_shared<Ring>();
+    heap_rings.push_back(ring);
+    return *ring;
+  };
+  auto& raw_buffer = make_ring(std::type_identity<LockFreeRingBuffer<MarketUpdate, 4096>>());
+  auto& normalized_buffer =
+      make_ring(std::type_identity<LockFreeRingBuffer<NormalizedUpdate, 4096>>());
+  auto& bar_buffer = make_ring(std::type_identity<LockFreeRingBuffer<Bar, 1024>>());
+  
+  // Lock and prefault memory, keep idle cores out of deep C-states and
+  // THP compaction out of our allocations, before any thread starts.
+  // Pipeline threads prefault their own stacks and arenas. SCHED_FIFO
+  // only where the planned cores are isolated; 0 keeps SCHED_OTHER.
+  RuntimeSetup runtime;
+  if (!runtime.Apply()) {
+    std::cerr << "Warning: runtime setup incomplete:\n" << runtime.Report();
+  }
+  constexpr int kPipelinePriority = 0;
+  // Every pipeline thread, first thing after pinning; a failed prefault or
+  // a refused SCHED_FIFO is reported by the thread it happened on
+  auto prepare_thread = [&runtime](const std::string& stage) {
+    if (runtime.PrepareThread(stage, kPipelinePriority)) {
+      return;
+    }
+    std::string failed;
+    for (const RuntimeSetup::Step& step : runtime.Steps()) {
+      if (!step.ok && step.name.starts_with(stage + ".")) {
+        failed += step.name + ": FAILED (" + step.detail + ")\n";
+      }
+    }
+    std::cerr << "Warning: " + stage + " thread setup incomplete:\n" + failed << std::flush;
+  };
+  
+  // Latency tracking: each worker records ticks into its own
+  // IntervalRecorder and the stats thread collects completed 1s intervals.
+  const uint64_t stats_interval = tsc.FromNanos(1'000'000'000);
+  IntervalRecorder raw_to_normalized_latency(stats_interval);
+  IntervalRecorder processing_latency(stats_interval);
+  
+  // Stats are published to shared memory for src/tools/stats_viewer; this
+  // process never formats them. Slots are registered before use, here for
+  // the ones other threads write.
+  StatsSegment stats;
+  if (!stats.Create()) {
+    std::cerr << "Warning: no stats segment, running without stats" << std::endl;
+  }
+  const int exchange_degraded = stats.AddGauge("exchange.degraded_reasons");
+  const int exchange_p99 = stats.AddGauge("exchange.window_p99_ns");
+  const int exchange_drift = stats.AddGauge("exchange.clock_drift_ppm");
+  const int shard_moves = stats.AddCounter("book_shards.moves");
+  const int shard_stalls = stats.AddCounter("book_shards.route_stalls");
+  const int book_resyncs = stats.AddCounter("book.resyncs");
+  // Drops are rare, so each one is a store; received is one relaxed store
+  // per message to a line only the exporters read
+  const int raw_received = stats.AddCounter("raw_buffer.received");
+  const int raw_drops = stats.AddCounter("raw_buffer.drops");
+  const int normalized_drops = stats.AddCounter("normalized_buffer.drops");
+  
+  // Host settings that cost latency on the planned cores, as logfmt on
+  // stdout for the log shipper; the warning count goes to the segment
+  std::vector<int> pinned_cores;
+  for (size_t stage : {feed_stage, normalize_stage, processing_stage, book_stages}) {
+    for (int core : placement.Cores(stage)) {
+      pinned_cores.push_back(core);
+    }
+  }
+  HostAudit::Config audit_config;
+  audit_config.cores = pinned_cores;
+  HostAudit audit(audit_config);
+  stats.SetGauge(stats.AddGauge("host.audit_warnings"), static_cast<double>(audit.Run()));
+  std::cout << audit.Report() << std::flush;
+  
+  // OpenMetrics on localhost:9464 for Prometheus. Runs on the housekeeping
+  // core and only reads the shared-memory segment.
+  MetricsServer::Config metrics_config;
+  metrics_config.core = housekeeping_core;
+  MetricsServer metrics(metrics_config);
+  if (!metrics.Start()) {
+    std::cerr << "Warning: metrics endpoint not started" << std::endl;
+  }
+  
+  // Hardware counters per stage, so a p99 move can be put down to cache
+  // misses or to more instructions. Each thread opens its own group.
+  PerfCounterGroup normalize_counters;
+  PerfCounterGroup routing_counters;
+  PerfStageRecorder normalize_perf(&normalize_counters, stats_interval);
+  PerfStageRecorder routing_perf(&routing_counters, stats_interval);
   
   // Initialize Binance client
+  uint64_t received = 0;
+  uint64_t raw_dropped = 0;
   BinanceClient client([&](const std::string& message) {
     auto now = std::chrono::high_resolution_clock::now();
     auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(
         now.time_since_epoch()).count();
     
     MarketUpdate update;
+    update.trace.Stamp(Stage::RECEIVE);
     update.timestamp_ns = ts;
     update.raw_data = nlohmann::json::parse(message);
     update.event_type = update.raw_data["e"].get<std::string>();
     update.symbol = update.raw_data["s"].get<std::string>();
+    update.trace.Stamp(Stage::PARSED);
     
-    raw_buffer.TryPush(update);
+    update.trace.Stamp(Stage::RAW_ENQUEUE);
+    if (!raw_buffer.TryPush(update)) {
+      stats.SetCounter(raw_drops, static_cast<int64_t>(++raw_dropped));
+    }
+    stats.SetCounter(raw_received, static_cast<int64_t>(++received));
   });
   
   // Normalization thread
   std::thread normalize_thread([&]() {
-    ThreadUtils::PinToCore(1);  // Pin to specific CPU core
+    ThreadUtils::PinToCore(placement.Core(normalize_stage));
+    prepare_thread("normalize");
+    normalize_counters.Open();
     
     Normalizer normalizer;
     MarketUpdate raw;
+    uint64_t dropped = 0;
     
     while (true) {
       if (raw_buffer.TryPop(&raw)) {
-        auto start = std::chrono::high_resolution_clock::now();
+        const uint64_t start = TscClock::Now();
+        raw.trace.SetDepth(Stage::RAW_DEQUEUE, raw_buffer.Occupancy());
+        raw.trace.Stamp(Stage::RAW_DEQUEUE, start);
+        normalize_perf.Begin();
         
         auto normalized = normalizer.Normalize(raw);
-        normalized_buffer.TryPush(normalized);
-        
-        auto end = std::chrono::high_resolution_clock::now();
-        auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            end - start);
+        normalized.trace = raw.trace;
+        normalized.trace.Stamp(Stage::NORMALIZED);
+        normalized.trace.Stamp(Stage::NORMALIZED_ENQUEUE);
+        if (!normalized_buffer.TryPush(normalized)) {
+          stats.SetCounter(normalized_drops, static_cast<int64_t>(++dropped));
+        }
         
-        raw_to_normalized_latency.RecordLatency(latency.count());
+        const uint64_t end = TscClock::NowOrdered();
+        normalize_perf.End(end);
+        raw_to_normalized_latency.Record(static_cast<int64_t>(end - start), end);
       }
     }
   });
   
-  // Processing thread (e.g. order book updates)
+  // Symbols we subscribe to, interned to dense ids for per-symbol arrays
+  SymbolTable symbols;
+  symbols.Intern("BTCUSDT");
+  symbols.Intern("ETHUSDT");
+  
+  // Completed trade bars for downstream consumers go to bar_buffer
+  BarSpec bar_spec;
+  bar_spec.time_interval = 1000;  // 1s; Binance trade times are in ms
+  bar_spec.ticks = 100;
+  
+  // Top-N book snapshots for risk/analytics readers, one publisher per symbol.
+  // Published every 100 updates or on RequestSnapshot(). Each publisher is
+  // only written by the shard that owns its symbol.
+  std::unordered_map<SymbolId, BookSnapshotPublisher<20>> snapshots;
+  snapshots.try_emplace(symbols.Find("BTCUSDT"), 100);
+  snapshots.try_emplace(symbols.Find("ETHUSDT"), 100);
+  
+  // Book building, sharded by symbol over four planned cores. Each shard
+  // owns its books exclusively; the processing thread below is the only
+  // router.
+  ShardedBookStage<4096>::Config shard_config;
+  shard_config.shard_count = 4;
+  shard_config.cores = placement.Cores(book_stages);
+  shard_config.on_thread_start = [&](size_t shard) {
+    prepare_thread("book" + std::to_string(shard));
+  };
+  shard_config.trace_interval = stats_interval;  // Per-hop wire-to-book latency
+  shard_config.perf_interval = stats_interval;   // Counters around book updates
+  // Dump the last 1024 traced updates when one takes over 1ms wire-to-book
+  shard_config.flight_threshold = tsc.FromNanos(1'000'000);
+  ShardedBookStage<4096> book_stage(symbols.Size(), shard_config,
+      [&](SymbolId symbol, const OrderBook& order_book, const LevelChange&) {
+        auto snapshot = snapshots.find(symbol);
+        if (snapshot != snapshots.end()) {
+          snapshot->second.MaybePublish(order_book);
+        }
+      });
+  book_stage.Start();
+  
+  // Writes flight recorder dumps off the hot cores
+  FlightRecorderDumper::Config dumper_config;
+  dumper_config.core = housekeeping_core;
+  FlightRecorderDumper flight_dumper(tsc, dumper_config);
+  for (size_t shard = 0; shard < book_stage.ShardCount(); ++shard) {
+    flight_dumper.Add(book_stage.Flight(shard));
+  }
+  flight_dumper.Start();
+  
+  // Processing thread: builds bars and routes depth to the book shards
   std::thread processing_thread([&]() {
-    ThreadUtils::PinToCore(2);
+    ThreadUtils::PinToCore(placement.Core(processing_stage));
+    prepare_thread("processing");
+    routing_counters.Open();
     
-    OrderBook order_book;
+    BarEngine<1024> bar_engine(bar_buffer, symbols.Size());
+    for (SymbolId id = 0; id < symbols.Size(); ++id) {
+      bar_engine.AddSymbol(id, bar_spec);
+    }
+    // Exchange-to-local latency for our one connection; a degraded path is
+    // the signal to fail over to another
+    ExchangeLatencyMonitor exchange_latency(symbols.Size());
     NormalizedUpdate update;
+    auto last_rebalance = std::chrono::steady_clock::now();
+    const uint64_t bar_check_interval = tsc.FromNanos(100'000'000);
+    uint64_t last_bar_check = TscClock::Now();
+    // Exchange gauges go out on the same interval boundaries as the latency
+    // histograms, busy feed or quiet; the monitor is this thread's alone
+    uint64_t exchange_publish_at = 0;
+    auto publish_exchange = [&](uint64_t now) {
+      if (now < exchange_publish_at) {
+        return;
+      }
+      exchange_publish_at = now - now % stats_interval + stats_interval;
+      const auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count();
+      stats.SetGauge(exchange_degraded, exchange_latency.Degraded(wall_ns));
+      stats.SetGauge(exchange_p99, static_cast<double>(
+          exchange_latency.LastWindow().PercentileLatency(99)));
+      stats.SetGauge(exchange_drift, exchange_latency.Clock().DriftPpm());
+    };
     
     while (true) {
       if (normalized_buffer.TryPop(&update)) {
-        auto start = std::chrono::high_resolution_clock::now();
+        update.trace.SetDepth(Stage::NORMALIZED_DEQUEUE, normalized_buffer.Occupancy());
+        update.trace.Stamp(Stage::NORMALIZED_DEQUEUE);
+        const SymbolId symbol = symbols.Find(update.symbol);
+        exchange_latency.OnUpdate(symbol, update);
+        if (update.type == NormalizedUpdate::Type::TRADE) {
+          bar_engine.OnTrade(symbol, update);
+          continue;
+        }
         
-        order_book.ProcessUpdate(update);
+        const uint64_t start = TscClock::Now();
+        routing_perf.Begin();
         
-        auto end = std::chrono::high_resolution_clock::now();
-        auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            end - start);
+        book_stage.Route(symbol, update);
         
-        processing_latency.RecordLatency(latency.count());
+        const uint64_t end = TscClock::NowOrdered();
+        routing_perf.End(end);
+        processing_latency.Record(static_cast<int64_t>(end - start), end);
+        publish_exchange(end);
+      } else if (TscClock::Now() - last_bar_check >= bar_check_interval) {
+        // Feed is quiet: close time bars of symbols that have gone quiet.
+        // Wall time less the measured offset is the exchange's clock, less
+        // the path floor, so no bar closes before its last trade could
+        // have arrived.
+        last_bar_check = TscClock::Now();
+        publish_exchange(last_bar_check);
+        const int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        const ClockOffsetEstimator& clock = exchange_latency.Clock();
+        const int64_t exchange_ns =
+            wall_ns - (clock.Ready() ? static_cast<int64_t>(clock.Offset(wall_ns)) : 0);
+        bar_engine.AdvanceTime(static_cast<uint64_t>(exchange_ns / 1'000'000));  // Binance ms
+      } else if (std::chrono::steady_clock::now() - last_rebalance >
+                 std::chrono::seconds(10)) {
+        // Feed is quiet: move hot symbols off overloaded shards
+        book_stage.Rebalance();
+        last_rebalance = std::chrono::steady_clock::now();
       }
     }
   });
   
-  // Statistics reporting thread
+  // Idle-priority probes on the pipeline's cores: gaps in their TSC spin
+  // are interrupts, SMIs or preemption, to line up against latency spikes.
+  // Off by default: our pipeline threads busy-spin, and a probe next to
+  // one steals slices from it. Enable on hosts with blocking threads or
+  // spare isolated cores to watch.
+  JitterProbe::Config jitter_config;
+  jitter_config.enabled = false;
+  jitter_config.cores = pinned_cores;
+  jitter_config.threshold_ticks = tsc.FromNanos(10'000);
+  jitter_config.interval_ticks = stats_interval;
+  JitterProbe jitter(jitter_config);
+  if (!jitter_config.cores.empty()) {
+    jitter.Start();
+  }
+  
+  // Statistics thread. Only reads what the workers published for the last
+  // interval; never touches their active histograms.
   std::thread stats_thread([&]() {
+    LatencyReporter raw_to_normalized;
+    raw_to_normalized.Add(&raw_to_normalized_latency);
+    LatencyReporter processing;
+    processing.Add(&processing_latency);
+    StageTraceReporter hops;
+    for (size_t shard = 0; shard < book_stage.ShardCount(); ++shard) {
+      hops.Add(book_stage.TraceRecorder(shard));
+    }
+    PerfReporter perf;
+    perf.Add(perf.AddStage("normalize"), &normalize_perf);
+    perf.Add(perf.AddStage("route"), &routing_perf);
+    const size_t book_apply = perf.AddStage("book_apply");
+    for (size_t shard = 0; shard < book_stage.ShardCount(); ++shard) {
+      perf.Add(book_apply, book_stage.PerfRecorder(shard));
+    }
+    
+    // Everything goes to the shared-memory segment; stats_viewer renders it
+    // in its own process. Histograms stay in ticks and carry the
+    // conversion, so nothing here formats or converts.
+    const double ns_per_tick = 1.0 / tsc.TicksPerNs();
+    struct Published {
+      int interval;
+      int cumulative;
+      const LatencyReporter* reporter;
+    };
+    std::vector<Published> histograms;
+    auto add = [&](const std::string& name, const LatencyReporter& reporter) {
+      histograms.push_back({stats.AddHistogram(name + ".interval", {}, ns_per_tick, true),
+                            stats.AddHistogram(name, {}, ns_per_tick),
+                            &reporter});
+    };
+    add("raw_to_normalized", raw_to_normalized);
+    add("processing", processing);
+    for (size_t hop = 0; hop < StageTraceRecorder::kHopCount; ++hop) {
+      add(std::string("hop.") + StageName(static_cast<Stage>(hop)) + "-" +
+              StageName(static_cast<Stage>(hop + 1)),
+          hops.Hop(hop));
+    }
+    add("wire_to_book", hops.Hop(StageTraceRecorder::kTotal));
+    std::array<LatencyReporter, kHiccupCauseCount> jitter_causes;
+    for (size_t cause = 0; cause < kHiccupCauseCount; ++cause) {
+      for (size_t probe = 0; probe < jitter.Size(); ++probe) {
+        jitter_causes[cause].Add(jitter.Detector(probe).Histogram(static_cast<HiccupCause>(cause)));
+      }
+      add(std::string("jitter.") + HiccupCauseName(static_cast<HiccupCause>(cause)),
+          jitter_causes[cause]);
+    }
+    
+    const int raw_occupancy = stats.AddGauge("raw_buffer.occupancy");
+    const int flight_dumps = stats.AddCounter("flight_recorder.dumps");
+    const int normalized_occupancy = stats.AddGauge("normalized_buffer.occupancy");
+    // Page-level view of the arena: how much of it THP or hugetlb covers
+    const int arena_used = stats.AddGauge("arena.used_bytes");
+    const int arena_huge = stats.AddGauge("arena.huge_bytes");
+    const int arena_resident = stats.AddGauge("arena.resident_bytes");
+    const int jitter_hiccups = stats.AddCounter("jitter.hiccups");
+    const int jitter_last_at = stats.AddGauge("jitter.last_hiccup_at_ns");
+    const int jitter_last_core = stats.AddGauge("jitter.last_hiccup_core");
+    const int jitter_interval_max = stats.AddGauge("jitter.interval_max_ns");
+    
+    // Cumulative sums per stage and event; the viewer shows their rates, and
+    // per message is the event rate over the samples rate
+    std::vector<std::array<int, kPerfEventCount + 1>> perf_slots(perf.StageCount());
+    for (size_t stage = 0; stage < perf.StageCount(); ++stage) {
+      for (size_t e = 0; e < kPerfEventCount; ++e) {
+        perf_slots[stage][e] = stats.AddCounter(
+            "perf." + perf.Name(stage) + "." + PerfEventName(static_cast<PerfEvent>(e)));
+      }
+      perf_slots[stage][kPerfEventCount] = stats.AddCounter("perf." + perf.Name(stage) + ".samples");
+    }
+    
     while (true) {
       std::this_thread::sleep_for(std::chrono::seconds(1));
       
-      std::cout << "Raw→Norm latency (ns): "
-                << "min=" << raw_to_normalized_latency.MinLatency() 
-                << " avg=" << raw_to_normalized_latency.AvgLatency()
-                << " max=" << raw_to_normalized_latency.MaxLatency()
-                << " p99=" << raw_to_normalized_latency.PercentileLatency(99)
-                << std::endl;
-                
-      std::cout << "Processing latency (ns): "
-                << "min=" << processing_latency.MinLatency() 
-                << " avg=" << processing_latency.AvgLatency()
-                << " max=" << processing_latency.MaxLatency()
-                << " p99=" << processing_latency.PercentileLatency(99)
-                << std::endl;
+      raw_to_normalized.Collect();
+      processing.Collect();
+      hops.Collect();  // Where wire-to-book time goes, queue waits included
+      perf.Collect();
+      for (LatencyReporter& cause : jitter_causes) {
+        cause.Collect();
+      }
+      for (const Published& h : histograms) {
+        stats.SetHistogram(h.interval, h.reporter->Interval());
+        stats.SetHistogram(h.cumulative, h.reporter->Cumulative());
+      }
+      // Instructions up means a longer code path; misses up at the same
+      // instruction count means cache
+      for (size_t stage = 0; stage < perf.StageCount(); ++stage) {
+        const PerfStageTotals& t = perf.Cumulative(stage);
+        for (size_t e = 0; e < kPerfEventCount; ++e) {
+          stats.SetCounter(perf_slots[stage][e], static_cast<int64_t>(t.sum.values[e]));
+        }
+        stats.SetCounter(perf_slots[stage][kPerfEventCount], static_cast<int64_t>(t.samples));
+      }
+      stats.SetCounter(shard_moves, static_cast<int64_t>(book_stage.Moves()));
+      stats.SetCounter(shard_stalls, static_cast<int64_t>(book_stage.Stalls()));
+      // Sampled here rather than by the exporters, which stay off the rings
+      stats.SetGauge(raw_occupancy, static_cast<double>(raw_buffer.Occupancy()));
+      stats.SetGauge(normalized_occupancy, static_cast<double>(normalized_buffer.Occupancy()));
+      const ArenaStats arena_stats = arena.Stats();
+      stats.SetGauge(arena_used, static_cast<double>(arena_stats.used_bytes));
+      stats.SetGauge(arena_huge, static_cast<double>(arena_stats.huge_bytes));
+      stats.SetGauge(arena_resident, static_cast<double>(arena_stats.resident_bytes));
+      stats.SetCounter(flight_dumps, static_cast<int64_t>(flight_dumper.Dumps()));
+      // Timestamped, so a hiccup can be matched to a flight recorder dump
+      Hiccup hiccup;
+      uint64_t hiccups = 0;
+      uint64_t interval_max = 0;
+      for (size_t probe = 0; probe < jitter.Size(); ++probe) {
+        hiccups += jitter.Detector(probe).Hiccups();
+        while (jitter.Detector(probe).PopHiccup(&hiccup)) {
+          interval_max = std::max(interval_max, hiccup.duration_ticks);
+          stats.SetGauge(jitter_last_at, static_cast<double>(tsc.ToMonotonicNs(hiccup.start_ticks)));
+          stats.SetGauge(jitter_last_core, hiccup.core);
+        }
+      }
+      stats.SetCounter(jitter_hiccups, static_cast<int64_t>(hiccups));
+      stats.SetGauge(jitter_interval_max, tsc.ToNanos(interval_max));
+      stats.Publish();
+    }
+  });
+  
+  // Books that fail an integrity check are rebuilt from a REST snapshot,
+  // fetched on the housekeeping core; the owning shard loads it
+  std::thread resync_thread([&]() {
+    ThreadUtils::PinToCore(housekeeping_core);
+    std::vector<uint32_t> pending(symbols.Size(), 0);  // Kept until a fetch works
+    uint64_t resyncs = 0;
+    while (true) {
+      bool failed = false;
+      for (SymbolId id = 0; id < symbols.Size(); ++id) {
+        pending[id] |= book_stage.TakeResync(id);
+        if (pending[id] == 0) {
+          continue;
+        }
+        DepthSnapshot snapshot;
+        if (!client.FetchDepthSnapshot(symbols.Name(id), &snapshot)) {
+          failed = true;
+          continue;
+        }
+        std::cerr << "Resynced " << symbols.Name(id) << " (faults 0x" << std::hex << pending[id]
+                  << std::dec << ")" << std::endl;
+        book_stage.Reload(id, std::move(snapshot));
+        pending[id] = 0;
+        stats.SetCounter(book_resyncs, static_cast<int64_t>(++resyncs));
+      }
+      // Back off from the REST endpoint while it's failing
+      std::this_thread::sleep_for(std::chrono::milliseconds(failed ? 1000 : 100));
     }
   });
   
-  // Connect to Binance
+  // Connect to Binance; the client's callbacks run on this thread
+  ThreadUtils::PinToCore(placement.Core(feed_stage));
+  prepare_thread("feed");
   client.Connect({"btcusdt@depth", "ethusdt@depth"});
   
   // Wait for threads (or implement proper shutdown)
   normalize_thread.join();
   processing_thread.join();
+  resync_thread.join();
   stats_thread.join();
   
   return 0;
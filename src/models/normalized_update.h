@@ -0,0 +1,20 @@
+// src/models/normalized_update.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "core/stage_trace.h"
+
+struct NormalizedUpdate {
+  enum class Type { TRADE, BID, ASK };
+  
+  uint64_t exchange_ts;           // Exchange timestamp
+  uint64_t received_ts;           // Local received timestamp
+  std::string symbol;
+  Type type;
+  double price;
+  double quantity;
+  uint64_t update_id;            // Binance specific sequence number
+  StageTrace trace;              // Pipeline timestamps, if traced
+};
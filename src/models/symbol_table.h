@@ -0,0 +1,53 @@
+// src/models/symbol_table.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Dense integer id for a trading pair, so per-symbol state can live in flat
+// arrays instead of string-keyed maps.
+using SymbolId = uint16_t;
+
+inline constexpr SymbolId kInvalidSymbol = 0xffff;
+
+// Interns symbol names into dense ids. Registration happens at startup;
+// lookups after that are read-only and safe from any thread.
+class SymbolTable {
+ public:
+  explicit SymbolTable(size_t capacity = 4096) {
+    names_.reserve(capacity);
+    ids_.reserve(capacity);
+  }
+
+  // Returns the id for name, assigning the next one if it's new.
+  SymbolId Intern(std::string_view name) {
+    auto it = ids_.find(std::string(name));
+    if (it != ids_.end()) {
+      return it->second;
+    }
+    if (names_.size() >= kInvalidSymbol) {
+      return kInvalidSymbol;
+    }
+    const SymbolId id = static_cast<SymbolId>(names_.size());
+    names_.emplace_back(name);
+    ids_.emplace(names_.back(), id);
+    return id;
+  }
+
+  // kInvalidSymbol if the name was never interned.
+  SymbolId Find(const std::string& name) const {
+    auto it = ids_.find(name);
+    return it == ids_.end() ? kInvalidSymbol : it->second;
+  }
+
+  const std::string& Name(SymbolId id) const { return names_[id]; }
+  size_t Size() const { return names_.size(); }
+
+ private:
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, SymbolId> ids_;
+};
@@ -0,0 +1,121 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "../bars/bar_engine.h"
+
+namespace {
+
+NormalizedUpdate Trade(uint64_t ts, double price, double quantity) {
+    return NormalizedUpdate{ts, ts + 1, "BTCUSDT", NormalizedUpdate::Type::TRADE,
+                            price, quantity, 0, {}};
+}
+
+template <size_t N>
+std::vector<Bar> Drain(LockFreeRingBuffer<Bar, N>& ring) {
+    std::vector<Bar> bars;
+    Bar bar;
+    while (ring.TryPop(&bar)) {
+        bars.push_back(bar);
+    }
+    return bars;
+}
+
+}  // namespace
+
+void symbol_table_test() {
+    SymbolTable table;
+    [[maybe_unused]] const SymbolId btc = table.Intern("BTCUSDT");
+    [[maybe_unused]] const SymbolId eth = table.Intern("ETHUSDT");
+    assert(btc == 0 && eth == 1);
+    assert(table.Intern("BTCUSDT") == btc);
+    assert(table.Find("ETHUSDT") == eth);
+    assert(table.Find("XRPUSDT") == kInvalidSymbol);
+    assert(table.Name(eth) == "ETHUSDT");
+    assert(table.Size() == 2);
+}
+
+void bar_kinds_test() {
+    LockFreeRingBuffer<Bar, 64> ring;
+    BarEngine<64> engine(ring, 4);
+
+    BarSpec spec;
+    spec.time_interval = 1000;
+    spec.ticks = 3;
+    spec.volume = 5.0;
+    spec.dollars = 1000.0;
+    assert(engine.AddSymbol(1, spec));
+    assert(!engine.AddSymbol(9, spec));
+
+    // Depth updates and unregistered symbols are ignored
+    engine.OnTrade(1, NormalizedUpdate{10, 11, "BTCUSDT", NormalizedUpdate::Type::BID,
+                                       100.0, 1.0, 1, {}});
+    engine.OnTrade(2, Trade(10, 100.0, 1.0));
+    assert(engine.OpenBar(1, BarKind::TICK).trade_count == 0);
+
+    engine.OnTrade(1, Trade(100, 100.0, 1.0));
+    engine.OnTrade(1, Trade(200, 102.0, 2.0));
+    assert(Drain(ring).empty());
+
+    // Third trade closes the tick bar and, at 6 units, the volume bar
+    engine.OnTrade(1, Trade(300, 99.0, 3.0));
+    std::vector<Bar> bars = Drain(ring);
+    assert(bars.size() == 2);
+    [[maybe_unused]] const Bar& tick = bars[0];
+    assert(tick.kind == BarKind::TICK && tick.symbol == 1);
+    assert(tick.open == 100.0 && tick.high == 102.0 && tick.low == 99.0 && tick.close == 99.0);
+    assert(tick.volume == 6.0 && tick.trade_count == 3);
+    assert(tick.open_ts == 100 && tick.close_ts == 300);
+    assert(std::fabs(tick.Vwap() - (100.0 + 204.0 + 297.0) / 6.0) < 1e-12);
+    assert(bars[1].kind == BarKind::VOLUME && bars[1].volume == 6.0);
+
+    // Notional so far is 601; this trade takes it past 1000
+    engine.OnTrade(1, Trade(400, 100.0, 4.0));
+    bars = Drain(ring);
+    assert(bars.size() == 1 && bars[0].kind == BarKind::DOLLAR);
+    assert(bars[0].notional == 1001.0 && bars[0].trade_count == 4);
+
+    // Time bar [0, 1000) closes on the first trade of the next interval;
+    // the same trade fills the volume bar (4 + 1 units)
+    engine.OnTrade(1, Trade(1500, 101.0, 1.0));
+    bars = Drain(ring);
+    assert(bars.size() == 2 && bars[0].kind == BarKind::TIME);
+    assert(bars[1].kind == BarKind::VOLUME && bars[1].open_ts == 400);
+    assert(bars[0].open_ts == 0 && bars[0].close_ts == 1000);
+    assert(bars[0].trade_count == 4 && bars[0].close == 100.0);
+
+    // A quiet symbol's time bar closes from AdvanceTime
+    engine.AdvanceTime(1999);
+    assert(Drain(ring).empty());
+    engine.AdvanceTime(2000);
+    bars = Drain(ring);
+    assert(bars.size() == 1 && bars[0].open_ts == 1000 && bars[0].trade_count == 1);
+    assert(engine.OpenBar(1, BarKind::TIME).trade_count == 0);
+    assert(engine.PublishedBars() == 6);
+}
+
+void full_ring_test() {
+    LockFreeRingBuffer<Bar, 4> ring;  // 3 usable slots
+    BarEngine<4> engine(ring, 1);
+    BarSpec spec;
+    spec.ticks = 1;
+    engine.AddSymbol(0, spec);
+    for (uint64_t i = 0; i < 5; ++i) {
+        engine.OnTrade(0, Trade(i, 100.0, 1.0));
+    }
+    assert(engine.PublishedBars() == 3);
+    assert(engine.DroppedBars() == 2);
+}
+
+int main() {
+    std::cout << "Testing symbol table..." << std::endl;
+    symbol_table_test();
+    std::cout << "Symbol table tests passed!" << std::endl;
+
+    std::cout << "\nTesting bar engine..." << std::endl;
+    bar_kinds_test();
+    full_ring_test();
+    std::cout << "Bar engine tests passed!" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "../core/cpu_topology.h"
+#include "../core/thread_utils.h"
+#include "fake_tree.h"
+
+namespace {
+
+// A sysfs tree for 2 sockets x 4 cores x 2 threads, numbered the way Linux
+// does it: cpus 0-7 are the first thread of each core, 8-15 their siblings.
+// One NUMA node and L3 per socket, an L2 per core. cpu15 is offline.
+void FakeSysfs(const FakeTree& tree) {
+    tree.Write("cpu/online", "0-14");
+    tree.Write("node/node0/cpulist", "0-3,8-11");
+    tree.Write("node/node1/cpulist", "4-7,12-15");
+    tree.Write("node/possible", "0-1");
+    for (int cpu = 0; cpu < 16; ++cpu) {
+        const int core = cpu % 8;
+        const int package = core / 4;
+        const std::string dir = "cpu/cpu" + std::to_string(cpu) + "/";
+        tree.Write(dir + "topology/physical_package_id", std::to_string(package));
+        tree.Write(dir + "topology/core_id", std::to_string(core % 4));
+        const std::string core_cpus = std::to_string(core) + "," + std::to_string(core + 8);
+        const std::string package_cpus = package == 0 ? "0-3,8-11" : "4-7,12-15";
+        tree.Write(dir + "cache/index0/level", "1");
+        tree.Write(dir + "cache/index0/type", "Data");
+        tree.Write(dir + "cache/index0/shared_cpu_list", core_cpus);
+        tree.Write(dir + "cache/index1/level", "1");
+        tree.Write(dir + "cache/index1/type", "Instruction");
+        tree.Write(dir + "cache/index1/shared_cpu_list", core_cpus);
+        tree.Write(dir + "cache/index2/level", "2");
+        tree.Write(dir + "cache/index2/type", "Unified");
+        tree.Write(dir + "cache/index2/shared_cpu_list", core_cpus);
+        tree.Write(dir + "cache/index3/level", "3");
+        tree.Write(dir + "cache/index3/type", "Unified");
+        tree.Write(dir + "cache/index3/shared_cpu_list", package_cpus);
+    }
+}
+
+}  // namespace
+
+void parse_list_test() {
+    std::vector<int> cpus;
+    assert(CpuTopology::ParseList("0-3,8,10-11", &cpus));
+    assert((cpus == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    assert(CpuTopology::ParseList("5", &cpus) && cpus == std::vector<int>{5});
+    assert(!CpuTopology::ParseList("", &cpus));
+    assert(!CpuTopology::ParseList("3-1", &cpus));
+    assert(!CpuTopology::ParseList("0-x", &cpus));
+    assert(!CpuTopology::ParseList("a", &cpus));
+}
+
+void discover_test(const std::string& root) {
+    const CpuTopology topology = CpuTopology::Discover(root);
+    assert(topology.Cpus().size() == 15);
+    assert(topology.PackageCount() == 2);
+    assert(topology.NodeCount() == 2);
+    assert(topology.CoreCount() == 8);
+    assert(topology.L3Count() == 2);
+    assert(topology.Find(15) == nullptr);
+
+    [[maybe_unused]] const CpuInfo* cpu1 = topology.Find(1);
+    [[maybe_unused]] const CpuInfo* cpu9 = topology.Find(9);
+    [[maybe_unused]] const CpuInfo* cpu5 = topology.Find(5);
+    assert(cpu1 != nullptr && cpu9 != nullptr && cpu5 != nullptr);
+    assert(cpu1->core == cpu9->core && cpu1->l2 == cpu9->l2);
+    assert(cpu1->core != topology.Find(2)->core && cpu1->l2 != topology.Find(2)->l2);
+    assert(cpu1->l3 == topology.Find(3)->l3 && cpu1->l3 != cpu5->l3);
+    assert(cpu1->package != cpu5->package && cpu1->node != cpu5->node);
+    assert(topology.Siblings(1) == std::vector<int>{9});
+    assert(topology.Siblings(7).empty());  // cpu15 is offline
+
+    assert(CpuTopology::Discover(root + "/missing").Empty());
+    std::cout << "  fake host: " << topology.Describe() << std::endl;
+}
+
+void placement_test(const std::string& root) {
+    const CpuTopology topology = CpuTopology::Discover(root);
+
+    // Socket 1 has four free cores to socket 0's three: the chain goes there
+    PlacementPlanner small(topology);
+    [[maybe_unused]] const size_t feed = small.AddStage("feed");
+    [[maybe_unused]] const size_t normalize = small.AddStage("normalize");
+    [[maybe_unused]] const size_t processing = small.AddStage("processing");
+    assert(small.Core(feed) == -1);
+    assert(small.Plan());
+    assert(small.Core(feed) == 4 && small.Core(normalize) == 5 && small.Core(processing) == 6);
+
+    // Seven threads: socket 1 fills up, then socket 0 away from cpu0's core
+    PlacementPlanner large(topology);
+    large.AddStage("feed");
+    large.AddStage("normalize");
+    large.AddStage("processing");
+    const size_t book = large.AddStage("book", 4);
+    assert(large.Plan());
+    std::set<int> cores;
+    std::set<int> used;
+    for (size_t stage = 0; stage <= book; ++stage) {
+        for (int cpu : large.Cores(stage)) {
+            [[maybe_unused]] const CpuInfo* info = topology.Find(cpu);
+            assert(info != nullptr);
+            assert(cores.insert(info->core).second);  // Never SMT siblings
+            assert(info->core != topology.Find(0)->core);
+            used.insert(cpu);
+        }
+    }
+    assert(used.size() == 7);
+    assert((large.Cores(book) == std::vector<int>{7, 1, 2, 3}));
+    std::cout << large.Describe();
+
+    // Eight threads don't fit without doubling up on a core
+    PlacementPlanner crowded(topology);
+    crowded.AddStage("all", 8);
+    assert(!crowded.Plan() && !crowded.Error().empty());
+    assert(crowded.Core(0) == -1);
+
+    // A housekeeping CPU takes its sibling out as well: cpu12 costs socket
+    // 1 the core of cpu4, and the tie goes to socket 0
+    PlacementPlanner::Config config;
+    config.housekeeping = {0, 12};
+    PlacementPlanner reserved(topology, config);
+    reserved.AddStage("pipeline", 3);
+    assert(reserved.Plan());
+    assert((reserved.Cores(0) == std::vector<int>{1, 2, 3}));
+}
+
+void host_test() {
+    const CpuTopology& topology = ThreadUtils::Topology();
+    assert(&topology == &ThreadUtils::Topology());
+    std::cout << "  this host: " << topology.Describe() << std::endl;
+    for ([[maybe_unused]] const CpuInfo& info : topology.Cpus()) {
+        assert(info.core >= 0 && info.core < static_cast<int>(topology.CoreCount()));
+    }
+}
+
+int main() {
+    const FakeTree tree("cpu_topology_test");
+    FakeSysfs(tree);
+    const std::string root = tree.Root().string();
+
+    std::cout << "Testing CPU list parsing..." << std::endl;
+    parse_list_test();
+    std::cout << "CPU list parsing tests passed!" << std::endl;
+
+    std::cout << "\nTesting topology discovery..." << std::endl;
+    discover_test(root);
+    host_test();
+    std::cout << "Topology discovery tests passed!" << std::endl;
+
+    std::cout << "\nTesting thread placement..." << std::endl;
+    placement_test(root);
+    std::cout << "Thread placement tests passed!" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <cassert>
+#include <iostream>
+#include <cmath>
+#include <random>
+#include "../feed/exchange_latency.h"
+
+namespace {
+
+// Binance-style event: exchange_ts in ms, received_ts in local ns
+NormalizedUpdate Event(uint64_t exchange_ms, uint64_t received_ns) {
+    return NormalizedUpdate{exchange_ms, received_ns, "BTCUSDT", NormalizedUpdate::Type::BID,
+                            100.0, 1.0, 1, {}};
+}
+
+}  // namespace
+
+void clock_offset_test() {
+    ClockOffsetEstimator::Config config;
+    config.window_ns = 1000;
+    ClockOffsetEstimator clock(config);
+    assert(!clock.Ready());
+
+    // Floor of 50 rising 1 per 1000 (1000ppm), with noise above it
+    std::mt19937 rng(1);
+    for (int64_t t = 0; t < 20'000; t += 10) {
+        clock.Add(t, 50 + t / 1000 + static_cast<int64_t>(rng() % 40));
+    }
+    assert(clock.Ready() && clock.Windows() == 19);
+    assert(std::fabs(clock.DriftPpm() - 1000.0) < 100.0);
+    assert(std::fabs(clock.Offset(20'000) - 70.0) < 3.0);
+}
+
+void exchange_latency_test() {
+    ExchangeLatencyMonitor::Config config;
+    config.clock.window_ns = 1'000'000'000;
+    config.degraded_p99_ns = 5'000'000;
+    config.degraded_floor_shift_ns = 3'000'000;
+    ExchangeLatencyMonitor monitor(8, config);
+
+    // Exchange sends every ms; the path takes 2ms plus exponential queueing,
+    // and our clock runs 5ms ahead and 20ppm fast
+    const uint64_t epoch_ns = 1'700'000'000'000'000'000;
+    std::mt19937_64 rng(4);
+    std::exponential_distribution<double> queueing(1.0 / 300'000.0);
+    uint64_t send_ns = 0;
+    auto receive = [&](int64_t extra_ns) {
+        send_ns += 1'000'000;
+        const double arrive = static_cast<double>(send_ns) + 2'000'000 + extra_ns + queueing(rng);
+        const uint64_t local = epoch_ns + 5'000'000 + static_cast<uint64_t>(arrive * (1.0 + 20e-6));
+        monitor.OnUpdate(static_cast<SymbolId>(send_ns / 1'000'000 % 2),
+                         Event((epoch_ns + send_ns) / 1'000'000, local));
+        return static_cast<int64_t>(local);
+    };
+
+    int64_t now = 0;
+    for (int i = 0; i < 120'000; ++i) {
+        now = receive(0);
+    }
+    const ClockOffsetEstimator& clock = monitor.Clock();
+    std::cout << "  drift " << clock.DriftPpm() << " ppm, p50 " << monitor.Cumulative().PercentileLatency(50)
+              << " ns, p99 " << monitor.Cumulative().PercentileLatency(99) << " ns above floor"
+              << std::endl;
+    assert(std::fabs(clock.DriftPpm() - 20.0) < 5.0);
+    // Queueing plus up to 1ms of exchange timestamp truncation
+    assert(monitor.Cumulative().PercentileLatency(50) < 1'500'000);
+    assert(monitor.Degraded(now) == ExchangeLatencyMonitor::NONE);
+    assert(monitor.Symbol(0) != nullptr && monitor.Symbol(1) != nullptr);
+    assert(monitor.Symbol(0)->Count() + monitor.Symbol(1)->Count() == monitor.Cumulative().Count());
+    assert(monitor.Symbol(5) == nullptr);
+
+    // The path gets 10ms longer: the next windows' floor jumps off the trend
+    uint32_t seen = 0;
+    for (int i = 0; i < 3'000; ++i) {
+        now = receive(10'000'000);
+        seen |= monitor.Degraded(now);
+    }
+    assert(seen & ExchangeLatencyMonitor::FLOOR_SHIFT);
+    assert(seen & ExchangeLatencyMonitor::HIGH_TAIL);
+
+    // Nothing for longer than stall_ns
+    assert(monitor.Degraded(now + 6'000'000'000) & ExchangeLatencyMonitor::STALLED);
+}
+
+int main() {
+    std::cout << "Testing clock offset estimation..." << std::endl;
+    clock_offset_test();
+    std::cout << "Clock offset tests passed!" << std::endl;
+
+    std::cout << "\nTesting exchange latency monitor..." << std::endl;
+    exchange_latency_test();
+    std::cout << "Exchange latency tests passed!" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+// src/tests/fake_tree.h
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+// A scratch directory standing in for /proc or /sys in tests that read
+// them, removed again when it goes. Per-process name so parallel test runs
+// don't share one.
+class FakeTree {
+ public:
+    explicit FakeTree(const std::string& name)
+        : root_(std::filesystem::temp_directory_path() / (name + "_" + std::to_string(getpid()))) {
+        std::filesystem::remove_all(root_);
+        std::filesystem::create_directories(root_);
+    }
+    ~FakeTree() { std::filesystem::remove_all(root_); }
+
+    FakeTree(const FakeTree&) = delete;
+    FakeTree& operator=(const FakeTree&) = delete;
+
+    const std::filesystem::path& Root() const { return root_; }
+    std::string Path(const std::string& relative) const { return (root_ / relative).string(); }
+
+    // Creates the parent directories; contents get a trailing newline, as
+    // the kernel's files have.
+    void Write(const std::string& relative, const std::string& contents) const {
+        const std::filesystem::path path = root_ / relative;
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path) << contents << "\n";
+    }
+
+ private:
+    std::filesystem::path root_;
+};
@@ -0,0 +1,162 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/huge_page_arena.h"
+#include "../core/ring_buffer.h"
+
+void allocate_test() {
+    HugePageArena::Config config;
+    config.bytes = 3 << 20;
+    HugePageArena arena(config);
+    assert(arena.Ok());
+
+    ArenaStats stats = arena.Stats();
+    // Whatever the backing, whole 2MB extents
+    assert(stats.reserved_bytes == 4u << 20);
+    assert(stats.pages * stats.page_size == stats.reserved_bytes);
+    assert(stats.used_bytes == 0 && stats.allocations == 0);
+    assert(stats.resident_bytes == stats.reserved_bytes);  // Prefaulted
+    std::cout << "  backing " << PageBackingName(stats.backing) << ", " << stats.pages
+              << " pages of " << (stats.page_size >> 10) << "KB, node " << stats.node
+              << ", " << (stats.huge_bytes >> 10) << "KB on huge pages" << std::endl;
+
+    [[maybe_unused]] void* a = arena.Allocate(10, 1);
+    [[maybe_unused]] void* b = arena.Allocate(8, 64);
+    assert(a != nullptr && b != nullptr);
+    assert(reinterpret_cast<uintptr_t>(b) % 64 == 0);
+    assert(static_cast<char*>(b) >= static_cast<char*>(a) + 10);
+    assert(arena.Owns(a) && arena.Owns(b));
+    [[maybe_unused]] int local = 0;
+    assert(!arena.Owns(&local));
+
+    // Exhaustion is a nullptr and a count, not a crash
+    assert(arena.Allocate(8u << 20) == nullptr);
+    assert(arena.Allocate(static_cast<size_t>(-1) - 8) == nullptr);
+    stats = arena.Stats();
+    assert(stats.allocations == 2 && stats.failures == 2);
+    assert(stats.used_bytes == static_cast<size_t>(static_cast<char*>(b) + 8 -
+                                                   static_cast<char*>(a)));
+
+    // The rest of it is still there
+    assert(arena.Allocate(stats.reserved_bytes - stats.used_bytes, 1) != nullptr);
+    assert(arena.Allocate(1, 1) == nullptr);
+}
+
+void node_test() {
+    HugePageArena::Config config;
+    config.bytes = 2 << 20;
+    config.node = 0;
+    HugePageArena arena(config);
+    assert(arena.Ok());
+    assert(arena.Stats().node == 0 || arena.Stats().node == -1);  // -1: no NUMA
+    assert(arena.Stats().bind_error == 0 || arena.Stats().bind_error == ENOSYS);
+
+    // A node that doesn't exist: still mapped, on first touch, and said so
+    config.node = 1000;
+    HugePageArena nowhere(config);
+    assert(nowhere.Ok() && nowhere.Stats().bind_error != 0);
+    assert(nowhere.Allocate(64) != nullptr);
+}
+
+void allocator_test() {
+    HugePageArena::Config config;
+    config.bytes = 4 << 20;
+    HugePageArena arena(config);
+
+    std::vector<int, ArenaAllocator<int>> levels{ArenaAllocator<int>(&arena)};
+    levels.reserve(1000);
+    for (int i = 0; i < 1000; ++i) {
+        levels.push_back(i);
+    }
+    assert(arena.Owns(levels.data()) && levels[999] == 999);
+
+    // Node-based containers rebind the allocator
+    using Map = std::map<int, double, std::less<int>, ArenaAllocator<std::pair<const int, double>>>;
+    Map far_levels{ArenaAllocator<std::pair<const int, double>>(&arena)};
+    far_levels[42] = 1.5;
+    far_levels[7] = 2.5;
+    assert(arena.Owns(&*far_levels.begin()) && far_levels.begin()->first == 7);
+    assert(ArenaAllocator<int>(&arena) == ArenaAllocator<double>(&arena));
+
+    // A full arena throws, as std containers expect
+    HugePageArena::Config tiny_config;
+    tiny_config.bytes = 1;
+    HugePageArena tiny(tiny_config);
+    std::vector<char, ArenaAllocator<char>> big{ArenaAllocator<char>(&tiny)};
+    [[maybe_unused]] bool threw = false;
+    try {
+        big.reserve(4u << 20);
+    } catch (const std::bad_alloc&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void create_test() {
+    HugePageArena arena;
+    using Ring = LockFreeRingBuffer<uint64_t, 4096>;
+    Ring* ring = arena.Create<Ring>();
+    assert(ring != nullptr && arena.Owns(ring));
+    assert(reinterpret_cast<uintptr_t>(ring) % alignof(Ring) == 0);
+    assert(ring->TryPush(7));
+    [[maybe_unused]] uint64_t value = 0;
+    assert(ring->TryPop(&value) && value == 7);
+    arena.Destroy(ring);
+
+    struct Big { char bytes[128 << 20]; };
+    assert(arena.Create<Big>() == nullptr);
+}
+
+void concurrent_test() {
+    HugePageArena::Config config;
+    config.bytes = 8 << 20;
+    HugePageArena arena(config);
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 10'000;
+    std::vector<std::vector<uintptr_t>> blocks(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                blocks[t].push_back(reinterpret_cast<uintptr_t>(arena.Allocate(64, 64)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::set<uintptr_t> all;
+    for (const auto& thread_blocks : blocks) {
+        for (uintptr_t block : thread_blocks) {
+            assert(block != 0 && block % 64 == 0);
+            all.insert(block);
+        }
+    }
+    // No two threads got the same block
+    assert(all.size() == kThreads * kPerThread);
+    assert(arena.Stats().used_bytes == 64u * kThreads * kPerThread);
+}
+
+int main() {
+    std::cout << "Testing arena allocation..." << std::endl;
+    allocate_test();
+    node_test();
+    std::cout << "Arena allocation tests passed!" << std::endl;
+
+    std::cout << "\nTesting arena std allocator..." << std::endl;
+    allocator_test();
+    create_test();
+    std::cout << "Arena std allocator tests passed!" << std::endl;
+
+    std::cout << "\nTesting concurrent allocation..." << std::endl;
+    concurrent_test();
+    std::cout << "Concurrent allocation tests passed!" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,549 @@
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include "../core/latency_tracker.h"
+#include "../core/interval_recorder.h"
+#include "../core/tsc_clock.h"
+#include "../core/stage_trace.h"
+#include "../core/perf_counters.h"
+#include "../core/flight_recorder.h"
+#include "../core/jitter_probe.h"
+#include "../core/thread_utils.h"
+
+namespace {
+
+// Exact percentile the way ring_buffer.cpp computes it, by sorting
+int64_t exact_percentile(const std::vector<int64_t>& sorted, double percentile) {
+    const size_t rank = std::max<size_t>(
+        1, static_cast<size_t>(std::ceil(percentile / 100.0 * sorted.size())));
+    return sorted[rank - 1];
+}
+
+[[maybe_unused]] bool within(int64_t estimate, int64_t exact, double relative_error) {
+    return std::abs(static_cast<double>(estimate - exact)) <=
+           relative_error * static_cast<double>(exact) + 1.0;
+}
+
+}  // namespace
+
+void basic_tracker_test() {
+    LatencyTracker tracker;
+    assert(tracker.Count() == 0);
+    assert(tracker.MinLatency() == 0 && tracker.MaxLatency() == 0);
+    assert(tracker.PercentileLatency(99) == 0);
+
+    // Small values are exact
+    for (int64_t v = 1; v <= 100; ++v) {
+        tracker.RecordLatency(v);
+    }
+    assert(tracker.Count() == 100);
+    assert(tracker.MinLatency() == 1 && tracker.MaxLatency() == 100);
+    assert(tracker.AvgLatency() == 50.5);
+    assert(tracker.PercentileLatency(50) == 50);
+    assert(tracker.PercentileLatency(99) == 99);
+    assert(tracker.PercentileLatency(100) == 100);
+    assert(tracker.PercentileLatency(0) == 1);
+
+    // Negative values (clock steps) count as zero
+    tracker.RecordLatency(-5);
+    assert(tracker.MinLatency() == 0);
+
+    // Beyond max_value: clamped into the top bucket, max still exact
+    LatencyTracker::Config config;
+    config.max_value = 1'000'000;
+    LatencyTracker bounded(config);
+    bounded.RecordLatency(5'000'000'000);
+    assert(bounded.MaxLatency() == 5'000'000'000);
+    assert(bounded.PercentileLatency(50) == 5'000'000'000);
+    assert(bounded.BucketCount() < tracker.BucketCount());
+
+    tracker.Reset();
+    assert(tracker.Count() == 0 && tracker.MinLatency() == 0 && tracker.MaxLatency() == 0);
+
+    // A 1000ns stall seen by a tester sending every 100ns hid nine more
+    // sends: 900, 800, ..., 100
+    tracker.RecordLatencyCorrected(1000, 100);
+    assert(tracker.Count() == 10 && tracker.MinLatency() == 100);
+    assert(tracker.AvgLatency() == 550.0);
+    tracker.RecordLatencyCorrected(50, 100);
+    assert(tracker.Count() == 11);
+}
+
+void accuracy_test() {
+    // Heavy-tailed, like real latency: most around 1us, a tail into ms
+    std::mt19937_64 rng(3);
+    std::lognormal_distribution<double> latency(7.0, 1.2);
+    std::vector<int64_t> samples;
+    samples.reserve(2'000'000);
+    for (uint32_t bits : {6u, 8u, 11u}) {
+        LatencyTracker::Config config;
+        config.precision_bits = bits;
+        LatencyTracker tracker(config);
+        samples.clear();
+        for (int i = 0; i < 2'000'000; ++i) {
+            const int64_t v = static_cast<int64_t>(latency(rng));
+            samples.push_back(v);
+            tracker.RecordLatency(v);
+        }
+        std::sort(samples.begin(), samples.end());
+        for (double p : {50.0, 90.0, 99.0, 99.9, 99.99}) {
+            [[maybe_unused]] const int64_t exact = exact_percentile(samples, p);
+            assert(within(tracker.PercentileLatency(p), exact, tracker.RelativeError()));
+        }
+        assert(tracker.MinLatency() == samples.front());
+        assert(tracker.MaxLatency() == samples.back());
+        std::cout << "  " << bits << " bits: " << tracker.BucketCount() << " buckets, p99.99 "
+                  << tracker.PercentileLatency(99.99) << " vs exact "
+                  << exact_percentile(samples, 99.99) << std::endl;
+    }
+}
+
+void merge_test() {
+    std::mt19937_64 rng(9);
+    std::exponential_distribution<double> latency(1.0 / 5000.0);
+    LatencyTracker a;
+    LatencyTracker b;
+    LatencyTracker combined;
+    for (int i = 0; i < 100'000; ++i) {
+        const int64_t v = static_cast<int64_t>(latency(rng));
+        (i % 3 == 0 ? a : b).RecordLatency(v);
+        combined.RecordLatency(v);
+    }
+    a.Merge(b);
+    assert(a.Count() == combined.Count());
+    assert(a.MinLatency() == combined.MinLatency());
+    assert(a.MaxLatency() == combined.MaxLatency());
+    assert(std::fabs(a.AvgLatency() - combined.AvgLatency()) < 1e-6 * combined.AvgLatency());
+    for ([[maybe_unused]] double p : {50.0, 99.0, 99.9}) {
+        assert(a.PercentileLatency(p) == combined.PercentileLatency(p));
+    }
+
+    // Different precision: re-bucketed, so only as precise as the coarser
+    LatencyTracker::Config coarse_config;
+    coarse_config.precision_bits = 5;
+    LatencyTracker coarse(coarse_config);
+    coarse.Merge(combined);
+    assert(coarse.Count() == combined.Count());
+    assert(std::fabs(coarse.AvgLatency() - combined.AvgLatency()) < 1e-6 * combined.AvgLatency());
+    assert(within(coarse.PercentileLatency(99), combined.PercentileLatency(99),
+                  2 * coarse.RelativeError()));
+}
+
+void interval_recorder_test() {
+    IntervalRecorder recorder(1000);
+    LatencyTracker out;
+    [[maybe_unused]] uint64_t start = 0;
+    [[maybe_unused]] uint64_t end = 0;
+    assert(!recorder.Collect(out));
+
+    // First sample opens [0, 1000); crossing 1000 publishes it
+    recorder.Record(5, 100);
+    assert(!recorder.Collect(out));
+    recorder.Record(7, 1500);
+    assert(recorder.Collect(out, &start, &end));
+    assert(out.Count() == 1 && out.MaxLatency() == 5 && start == 0 && end == 1000);
+    assert(!recorder.Collect(out));
+
+    // Reporter lags: the worker can't flip onto the uncollected buffer, so
+    // the open interval runs long
+    recorder.Record(9, 2100);
+    recorder.Record(11, 3100);
+    assert(recorder.ExtendedIntervals() == 1);
+    out.Reset();
+    assert(recorder.Collect(out, &start, &end));
+    assert(out.Count() == 1 && out.MaxLatency() == 7 && start == 1000 && end == 2000);
+    recorder.Record(13, 4200);
+    out.Reset();
+    assert(recorder.Collect(out, &start, &end));
+    assert(out.Count() == 2 && out.MinLatency() == 9 && start == 2000 && end == 4000);
+
+    // Workers record while the reporter collects; every sample shows up
+    // exactly once in the cumulative view
+    const int kSamples = 500'000;
+    IntervalRecorder a(10'000);
+    IntervalRecorder b(10'000);
+    LatencyReporter reporter;
+    reporter.Add(&a);
+    reporter.Add(&b);
+    std::atomic<int> running{2};
+    auto work = [&](IntervalRecorder& recorder, int64_t base) {
+        for (int i = 1; i <= kSamples; ++i) {
+            recorder.Record(base + i % 1000, static_cast<uint64_t>(i) * 10);
+        }
+        running.fetch_sub(1);
+    };
+    std::thread wa(work, std::ref(a), 1000);
+    std::thread wb(work, std::ref(b), 5000);
+    uint64_t intervals = 0;
+    while (running.load() != 0) {
+        intervals += reporter.Collect();
+        std::this_thread::yield();
+    }
+    wa.join();
+    wb.join();
+    // The workers are done; flush their open intervals from here
+    for (uint64_t t = 6'000'000; reporter.Cumulative().Count() < 2 * kSamples; t += 10'000) {
+        a.Tick(t);
+        b.Tick(t);
+        reporter.Collect();
+    }
+    assert(reporter.Cumulative().Count() == 2 * kSamples);
+    assert(reporter.Cumulative().MinLatency() == 1000);
+    assert(reporter.Cumulative().MaxLatency() == 5999);
+    std::cout << "  " << intervals << " intervals collected live, "
+              << a.ExtendedIntervals() + b.ExtendedIntervals() << " extended" << std::endl;
+}
+
+void tsc_clock_test() {
+    TscClock clock;
+    assert(!clock.Calibrated());
+    const bool invariant = clock.Calibrate(std::chrono::milliseconds(50));
+    assert(clock.Calibrated() && clock.TicksPerNs() > 0.0);
+    std::cout << "  " << clock.TicksPerNs() << " ticks/ns, invariant TSC: "
+              << (invariant ? "yes" : "no") << std::endl;
+
+    // A 20ms sleep timed both ways agrees to within a few percent
+    [[maybe_unused]] const uint64_t mono_start = TscClock::MonotonicNs();
+    const uint64_t start = TscClock::Now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const uint64_t end = TscClock::NowOrdered();
+    [[maybe_unused]] const uint64_t mono_end = TscClock::MonotonicNs();
+    [[maybe_unused]] const double elapsed = clock.ToNanos(end - start);
+    assert(std::fabs(elapsed - static_cast<double>(mono_end - mono_start)) <
+           0.05 * static_cast<double>(mono_end - mono_start));
+    assert(std::llabs(static_cast<long long>(clock.ToMonotonicNs(end)) -
+                      static_cast<long long>(mono_end)) < 2'000'000);
+    [[maybe_unused]] const uint64_t second = clock.FromNanos(1'000'000'000);
+    assert(std::fabs(clock.ToNanos(second) - 1e9) < 1e3);
+
+    // What a timed section pays just for its two clock reads
+    const int kReads = 1'000'000;
+    uint64_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kReads; ++i) {
+        sink += static_cast<uint64_t>(
+            std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kReads; ++i) {
+        sink += TscClock::Now();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kReads; ++i) {
+        sink += TscClock::NowOrdered();
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    auto per_read = [&](auto a, auto b) {
+        return std::chrono::duration<double, std::nano>(b - a).count() / kReads;
+    };
+    std::cout << "  high_resolution_clock: " << per_read(t0, t1) << " ns/read, rdtsc: "
+              << per_read(t1, t2) << " ns/read, rdtscp: " << per_read(t2, t3)
+              << " ns/read" << (sink == 0 ? " " : "") << std::endl;
+}
+
+void stage_trace_test() {
+    StageTrace trace;
+    assert(!trace.Has(Stage::RECEIVE));
+    trace.Stamp(Stage::PARSED, 50);  // Untraced messages ignore stamps
+    assert(!trace.Has(Stage::PARSED));
+
+    trace.Stamp(Stage::RECEIVE, 1000);
+    trace.Stamp(Stage::PARSED, 1300);
+    trace.Stamp(Stage::RAW_ENQUEUE, 1300);  // Same tick still counts
+    trace.Stamp(Stage::RAW_DEQUEUE, 2000);
+    trace.Stamp(Stage::NORMALIZED, 2100);
+    // NORMALIZED_ENQUEUE missing: its time folds into the next hop
+    trace.Stamp(Stage::NORMALIZED_DEQUEUE, 5000);
+    trace.Stamp(Stage::BOOK_APPLIED, 5400);
+    assert(trace.Has(Stage::RAW_ENQUEUE) && !trace.Has(Stage::NORMALIZED_ENQUEUE));
+    assert(trace.Offset(Stage::BOOK_APPLIED) == 4400);
+
+    // Offsets saturate rather than wrap
+    StageTrace stuck;
+    stuck.Stamp(Stage::RECEIVE, 1);
+    stuck.Stamp(Stage::PARSED, uint64_t{1} << 40);
+    assert(stuck.Offset(Stage::PARSED) == UINT32_MAX);
+
+    StageTraceRecorder recorder(1'000'000);
+    StageTraceReporter reporter;
+    reporter.Add(&recorder);
+    recorder.Record(trace, 10);
+    recorder.Record(StageTrace(), 20);  // Untraced: nothing recorded
+    recorder.Hop(StageTraceRecorder::kTotal)->Tick(2'000'000);
+    for (size_t i = 0; i < StageTraceRecorder::kHopCount; ++i) {
+        recorder.Hop(i)->Tick(2'000'000);
+    }
+    reporter.Collect();
+
+    [[maybe_unused]] auto hop = [&](Stage end) {
+        return reporter.Hop(static_cast<size_t>(end) - 1).Interval();
+    };
+    assert(hop(Stage::PARSED).MaxLatency() == 300);
+    assert(hop(Stage::RAW_ENQUEUE).Count() == 1 && hop(Stage::RAW_ENQUEUE).MaxLatency() == 0);
+    assert(hop(Stage::RAW_DEQUEUE).MaxLatency() == 700);
+    assert(hop(Stage::NORMALIZED).MaxLatency() == 100);
+    assert(hop(Stage::NORMALIZED_ENQUEUE).Count() == 0);
+    assert(hop(Stage::NORMALIZED_DEQUEUE).MaxLatency() == 2900);
+    assert(hop(Stage::BOOK_APPLIED).MaxLatency() == 400);
+    assert(reporter.Hop(StageTraceRecorder::kTotal).Interval().Count() == 1);
+    assert(reporter.Hop(StageTraceRecorder::kTotal).Interval().MaxLatency() == 4400);
+    assert(std::string(StageName(Stage::RAW_DEQUEUE)) == "raw_dequeue");
+}
+
+void perf_counters_test() {
+    // Interval hand-off with deltas supplied directly
+    PerfStageRecorder recorder(nullptr, 1'000'000);
+    PerfReporter reporter;
+    const size_t stage = reporter.AddStage("normalize");
+    reporter.Add(stage, &recorder);
+    PerfCounts delta;
+    delta.values = {1000, 2500, 10, 2, 5};
+    recorder.Record(delta, 100);
+    recorder.Record(delta, 200);
+    reporter.Collect();
+    assert(reporter.Interval(stage).samples == 0);  // Interval still open
+    recorder.Tick(1'500'000);
+    reporter.Collect();
+    assert(reporter.Interval(stage).samples == 2);
+    assert(reporter.Interval(stage).sum[PerfEvent::CYCLES] == 2000);
+    assert(reporter.Interval(stage).Ipc() == 2.5);
+    assert(reporter.Interval(stage).PerSample(PerfEvent::L1D_MISSES) == 10.0);
+    assert(reporter.Cumulative(stage).samples == 2);
+    assert(reporter.Name(stage) == "normalize");
+
+    // No group: Begin/End only keep the interval ticking
+    recorder.Begin();
+    recorder.End(2'500'000);
+    reporter.Collect();
+    assert(reporter.Interval(stage).samples == 0);
+
+    // Real counters where the host exposes a PMU; most VMs don't
+    PerfCounterGroup group;
+    if (!group.Open()) {
+        PerfCounts counts;
+        [[maybe_unused]] const bool read = group.Read(&counts);
+        assert(!read && !group.IsOpen());
+        std::cout << "  No hardware counters available, skipping live read" << std::endl;
+        return;
+    }
+    PerfStageRecorder live(&group, 1'000'000, 1);
+    PerfReporter live_reporter;
+    live_reporter.Add(live_reporter.AddStage("loop"), &live);
+    volatile uint64_t sink = 0;
+    live.Begin();
+    for (int i = 0; i < 100'000; ++i) {
+        sink = sink + static_cast<uint64_t>(i);
+    }
+    live.End(100);
+    live.Tick(2'000'000);
+    live_reporter.Collect();
+    [[maybe_unused]] const PerfStageTotals& loop = live_reporter.Interval(0);
+    assert(loop.samples == 1);
+    assert(loop.sum[PerfEvent::INSTRUCTIONS] >= 100'000);
+    std::cout << "  " << (group.UsesRdpmc() ? "rdpmc" : "read()") << ": "
+              << loop.sum[PerfEvent::INSTRUCTIONS] << " instructions, IPC " << loop.Ipc()
+              << std::endl;
+}
+
+void flight_recorder_test() {
+    // Stamps carry the pinned core and dequeue depths
+    StageTrace trace;
+    trace.Stamp(Stage::RECEIVE, 1000);
+    assert(trace.Cpu(Stage::RECEIVE) == ThreadUtils::PinnedCore());
+    if (ThreadUtils::PinToCore(0)) {
+        trace.Stamp(Stage::PARSED, 1100);
+        assert(trace.Cpu(Stage::PARSED) == 0);
+    }
+    trace.SetDepth(Stage::RAW_DEQUEUE, 100'000);  // Saturates
+    assert(trace.Depth(Stage::RAW_DEQUEUE) == UINT16_MAX);
+    assert(trace.Cpu(Stage::BOOK_APPLIED) == -1);
+
+    FlightRecorder::Config config;
+    config.name = "test_shard";
+    config.threshold_ticks = 10'000;
+    config.dump_events = 8;
+    config.cooldown_ticks = 1'000'000;
+    FlightRecorder recorder(config);
+
+    // 20 fast messages, then an outlier
+    StageTrace fast;
+    for (uint32_t i = 0; i < 20; ++i) {
+        const uint64_t origin = 1'000 + i * 100;
+        fast.Stamp(Stage::RECEIVE, origin);
+        fast.Stamp(Stage::BOOK_APPLIED, origin + 500);
+        recorder.Record(fast, 1, i, origin + 500);
+    }
+    StageTrace slow;
+    slow.Stamp(Stage::RECEIVE, 5'000);
+    slow.SetDepth(Stage::NORMALIZED_DEQUEUE, 37);
+    slow.Stamp(Stage::BOOK_APPLIED, 25'000);
+    recorder.Record(slow, 2, 99, 25'000);
+    recorder.Record(slow, 2, 100, 26'000);  // Dump still pending
+    assert(recorder.Suppressed() == 1);
+    recorder.Record(StageTrace(), 3, 0, 27'000);  // Untraced: ignored
+    assert(recorder.Recorded() == 22);
+
+    // Writer keeps going past the trigger but not far enough to lap it
+    for (uint32_t i = 0; i < 5; ++i) {
+        recorder.Record(fast, 1, 200 + i, 3'400);
+    }
+
+    std::vector<FlightEvent> events;
+    uint64_t trigger = 0;
+    [[maybe_unused]] const bool taken = recorder.TakeDump(&events, &trigger);
+    assert(taken && trigger == 25'000);
+    assert(events.size() == 8);
+    assert(events.front().update_id == 13 && events.back().update_id == 99);
+    assert(events.back().trace.Depth(Stage::NORMALIZED_DEQUEUE) == 37);
+    assert(!recorder.TakeDump(&events, &trigger));
+
+    // Within the cooldown: counted, not dumped
+    recorder.Record(slow, 2, 101, 40'000);
+    assert(recorder.Suppressed() == 2);
+
+    // A writer that laps the ring before the dump is taken: only events it
+    // hasn't claimed the slot of are kept
+    FlightRecorder lapped(config);
+    lapped.Record(slow, 2, 1, 25'000);
+    for (uint32_t i = 0; i < 15; ++i) {  // Ring of 16: just fits
+        lapped.Record(fast, 1, 10 + i, 3'400);
+    }
+    lapped.Record(slow, 2, 2, 25'000);  // Suppressed, but still recorded
+    [[maybe_unused]] const bool lapped_taken = lapped.TakeDump(&events, &trigger);
+    assert(lapped_taken && events.empty());  // The outlier's slot is reused
+
+    // Through the dumper, to a file
+    TscClock clock;
+    clock.Calibrate(std::chrono::milliseconds(1));
+    FlightRecorderDumper::Config dumper_config;
+    dumper_config.directory = std::filesystem::temp_directory_path().string();
+    FlightRecorderDumper dumper(clock, dumper_config);
+    dumper.Add(&recorder);
+    recorder.Record(slow, 2, 102, 2'000'000);
+    assert(dumper.Poll() == 1 && dumper.Dumps() == 1);
+    std::ifstream file(dumper.LastFile());
+    std::string header;
+    std::getline(file, header);
+    assert(header.rfind("receive_ns,symbol,update_id,parsed_ns,", 0) == 0);
+    assert(header.find("normalized_dequeue_depth") != std::string::npos);
+    size_t rows = 0;
+    std::string row;
+    while (std::getline(file, row)) {
+        ++rows;
+    }
+    assert(rows == 8);
+    std::filesystem::remove(dumper.LastFile());
+}
+
+void jitter_probe_test() {
+    // Synthetic gaps: core -1 skips the migration and SMI checks
+    HiccupDetector detector(-1, HiccupDetector::Config{1'000'000, 10'000'000});
+    LatencyReporter interrupts;
+    interrupts.Add(detector.Histogram(HiccupCause::INTERRUPT));
+    LatencyReporter preemptions;
+    preemptions.Add(detector.Histogram(HiccupCause::PREEMPTION));
+    detector.Begin();
+    const uint64_t t0 = TscClock::Now();
+    detector.Sample(t0);
+    [[maybe_unused]] const uint64_t before = detector.Hiccups();  // 1 if we were preempted just now
+    detector.Sample(t0 + 5'000'000);
+    assert(detector.Hiccups() == before + 1);
+
+    Hiccup hiccup;
+    while (detector.PopHiccup(&hiccup) && hiccup.duration_ticks != 5'000'000) {}
+    assert(hiccup.start_ticks == t0 && hiccup.duration_ticks == 5'000'000);
+    assert(hiccup.core == -1);
+    // Nothing switched us out in between, unless the scheduler did
+    assert(hiccup.cause == HiccupCause::INTERRUPT || hiccup.cause == HiccupCause::PREEMPTION);
+    assert(!detector.PopHiccup(&hiccup));
+    assert(std::string(HiccupCauseName(HiccupCause::SMI)) == "smi");
+
+    detector.Histogram(HiccupCause::INTERRUPT)->Tick(t0 + 100'000'000);
+    detector.Histogram(HiccupCause::PREEMPTION)->Tick(t0 + 100'000'000);
+    interrupts.Collect();
+    preemptions.Collect();
+    assert(interrupts.Interval().Count() + preemptions.Interval().Count() == before + 1);
+    assert(std::max(interrupts.Interval().MaxLatency(), preemptions.Interval().MaxLatency()) >=
+           4'900'000);
+
+    // Live probe on a pinned core, sharing it with this thread's sleep
+    ThreadUtils::PinToCore(0);
+    [[maybe_unused]] const std::vector<int> pinned = ThreadUtils::PinnedCores();
+    assert(std::find(pinned.begin(), pinned.end(), 0) != pinned.end() ||
+           ThreadUtils::PinnedCore() == -1);
+    TscClock clock;
+    clock.Calibrate(std::chrono::milliseconds(10));
+    JitterProbe::Config config;
+    config.cores = {0};
+    config.threshold_ticks = clock.FromNanos(20'000);
+    config.interval_ticks = clock.FromNanos(100'000'000);
+    JitterProbe disabled(config);
+    disabled.Start();  // Off by default
+    assert(disabled.Size() == 0);
+    config.enabled = true;
+    JitterProbe probe(config);
+    probe.Start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    probe.Stop();
+    assert(probe.Size() == 1 && probe.Detector(0).Core() == 0);
+    uint64_t by_cause[kHiccupCauseCount] = {};
+    uint64_t longest = 0;
+    while (probe.Detector(0).PopHiccup(&hiccup)) {
+        ++by_cause[static_cast<size_t>(hiccup.cause)];
+        longest = std::max(longest, hiccup.duration_ticks);
+    }
+    std::cout << "  200ms on core 0: " << probe.Detector(0).Hiccups() << " hiccups over 20us";
+    for (size_t c = 0; c < kHiccupCauseCount; ++c) {
+        std::cout << ", " << HiccupCauseName(static_cast<HiccupCause>(c)) << " " << by_cause[c];
+    }
+    std::cout << ", longest " << clock.ToNanos(longest) / 1000 << "us" << std::endl;
+}
+
+int main() {
+    std::cout << "Testing latency tracker..." << std::endl;
+    basic_tracker_test();
+    std::cout << "Latency tracker tests passed!" << std::endl;
+
+    std::cout << "\nTesting percentile accuracy..." << std::endl;
+    accuracy_test();
+    std::cout << "Percentile accuracy tests passed!" << std::endl;
+
+    std::cout << "\nTesting merge..." << std::endl;
+    merge_test();
+    std::cout << "Merge tests passed!" << std::endl;
+
+    std::cout << "\nTesting interval recorder..." << std::endl;
+    interval_recorder_test();
+    std::cout << "Interval recorder tests passed!" << std::endl;
+
+    std::cout << "\nTesting TSC clock..." << std::endl;
+    tsc_clock_test();
+    std::cout << "TSC clock tests passed!" << std::endl;
+
+    std::cout << "\nTesting stage tracing..." << std::endl;
+    stage_trace_test();
+    std::cout << "Stage tracing tests passed!" << std::endl;
+
+    std::cout << "\nTesting performance counters..." << std::endl;
+    perf_counters_test();
+    std::cout << "Performance counter tests passed!" << std::endl;
+
+    std::cout << "\nTesting flight recorder..." << std::endl;
+    flight_recorder_test();
+    std::cout << "Flight recorder tests passed!" << std::endl;
+
+    std::cout << "\nTesting jitter probe..." << std::endl;
+    jitter_probe_test();
+    std::cout << "Jitter probe tests passed!" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,1009 @@
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "../book/order_book.h"
+#include "../book/book_snapshot.h"
+#include "../book/band_depth_view.h"
+#include "../book/queue_position.h"
+#include "../book/book_shards.h"
+
+namespace {
+
+NormalizedUpdate MakeLevel(NormalizedUpdate::Type type, double price, double quantity,
+                           uint64_t update_id) {
+    return NormalizedUpdate{update_id * 1000, update_id * 1000 + 5, "BTCUSDT",
+                            type, price, quantity, update_id, {}};
+}
+
+NormalizedUpdate Bid(double price, double quantity, uint64_t update_id = 1) {
+    return MakeLevel(NormalizedUpdate::Type::BID, price, quantity, update_id);
+}
+
+NormalizedUpdate Ask(double price, double quantity, uint64_t update_id = 1) {
+    return MakeLevel(NormalizedUpdate::Type::ASK, price, quantity, update_id);
+}
+
+NormalizedUpdate Trade(double price, double quantity, uint64_t update_id = 1) {
+    return MakeLevel(NormalizedUpdate::Type::TRADE, price, quantity, update_id);
+}
+
+}  // namespace
+
+void basic_book_test() {
+    OrderBook book;
+    assert(!book.HasBid() && !book.HasAsk());
+
+    book.ProcessUpdate(Bid(100.0, 1.0));
+    book.ProcessUpdate(Bid(101.0, 2.0));
+    book.ProcessUpdate(Bid(99.0, 3.0));
+    book.ProcessUpdate(Ask(102.0, 1.5));
+    book.ProcessUpdate(Ask(104.0, 2.5));
+    book.ProcessUpdate(Ask(103.0, 0.5, 2));
+
+    // Sides are sorted best-first
+    assert(book.Bids().size() == 3);
+    assert(book.BestBid().price == 101.0);
+    assert(book.Bids()[1].price == 100.0);
+    assert(book.Bids()[2].price == 99.0);
+    assert(book.BestAsk().price == 102.0);
+    assert(book.Asks()[1].price == 103.0);
+    assert(book.LastUpdateId() == 2);
+
+    // Update in place, then remove with zero quantity
+    book.ProcessUpdate(Bid(100.0, 7.0, 3));
+    assert(book.Bids()[1].quantity == 7.0);
+    book.ProcessUpdate(Bid(101.0, 0.0, 4));
+    assert(book.Bids().size() == 2);
+    assert(book.BestBid().price == 100.0);
+
+    // Removing a missing level is a no-op
+    book.ProcessUpdate(Ask(150.0, 0.0, 5));
+    assert(book.Asks().size() == 3);
+
+    // Trades don't change the book or its update id
+    book.ProcessUpdate(MakeLevel(NormalizedUpdate::Type::TRADE, 102.0, 1.0, 9));
+    assert(book.Asks().size() == 3);
+    assert(book.LastUpdateId() == 5);
+}
+
+void snapshot_publish_test() {
+    OrderBook book;
+    BookSnapshotPublisher<2> publisher;
+    assert(!publisher.Acquire());
+
+    book.ProcessUpdate(Bid(100.0, 1.0));
+    book.ProcessUpdate(Bid(99.0, 1.0));
+    book.ProcessUpdate(Bid(98.0, 1.0));
+    book.ProcessUpdate(Ask(101.0, 2.0, 2));
+
+    // Nothing due and nothing requested
+    assert(!publisher.MaybePublish(book));
+    publisher.RequestSnapshot();
+    assert(publisher.MaybePublish(book));
+
+    {
+        auto snap = publisher.Acquire();
+        assert(snap);
+        assert(snap->sequence == 1);
+        assert(snap->update_id == 2);
+        assert(snap->bid_count == 2);  // Truncated to Depth
+        assert(snap->ask_count == 1);
+        assert(snap->bids[0].price == 100.0);
+        assert(snap->bids[1].price == 99.0);
+
+        // A pinned snapshot survives later publishes
+        book.ProcessUpdate(Bid(100.0, 0.0, 3));
+        assert(publisher.Publish(book));
+        assert(publisher.Publish(book));
+        assert(snap->sequence == 1);
+        assert(snap->bids[0].price == 100.0);
+    }
+
+    auto latest = publisher.Acquire();
+    assert(latest->sequence == 3);
+    assert(latest->bids[0].price == 99.0);
+
+    // Periodic publishing
+    BookSnapshotPublisher<2> periodic(3);
+    assert(!periodic.MaybePublish(book));
+    assert(!periodic.MaybePublish(book));
+    assert(periodic.MaybePublish(book));
+}
+
+void snapshot_concurrency_test() {
+    constexpr size_t kDepth = 16;
+    constexpr uint64_t kPublishes = 200000;
+
+    BookSnapshotPublisher<kDepth> publisher;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> reads{0};
+
+    // Every level of a given publish carries the same quantity, so a torn
+    // snapshot shows up as mixed quantities.
+    auto reader = [&]() {
+        uint64_t last_sequence = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            auto snap = publisher.Acquire();
+            if (!snap) {
+                continue;
+            }
+            if (snap->sequence < last_sequence) {
+                torn.fetch_add(1, std::memory_order_relaxed);
+            }
+            last_sequence = snap->sequence;
+            const double expected = snap->bids[0].quantity;
+            for (size_t i = 0; i < snap->bid_count; ++i) {
+                if (snap->bids[i].quantity != expected ||
+                    snap->asks[i].quantity != expected) {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            reads.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::thread reader1(reader);
+    std::thread reader2(reader);
+
+    OrderBook book;
+    for (uint64_t seq = 1; seq <= kPublishes; ++seq) {
+        const double quantity = static_cast<double>(seq);
+        for (size_t level = 0; level < kDepth; ++level) {
+            book.ProcessUpdate(Bid(1000.0 - level, quantity, seq));
+            book.ProcessUpdate(Ask(1001.0 + level, quantity, seq));
+        }
+        publisher.Publish(book);
+    }
+    done.store(true, std::memory_order_release);
+    reader1.join();
+    reader2.join();
+
+    std::cout << "  Reads: " << reads.load() << ", skipped publishes: "
+              << publisher.SkippedPublishes() << std::endl;
+    assert(torn.load() == 0);
+}
+
+// Random walk around the touch with inserts, updates and deletes. Calls
+// on_change after every ProcessUpdate, including the ones that uncross.
+template <typename OnChange>
+void random_walk(OrderBook& book, uint64_t steps, OnChange on_change, uint64_t seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> offset(0, 40);
+    std::uniform_int_distribution<int> qty(0, 9);
+    double mid_ticks = 10000.0;
+    const uint64_t first_id = book.LastUpdateId() + 1;
+    for (uint64_t i = first_id; i < first_id + steps; ++i) {
+        if (i % 97 == 0) {
+            mid_ticks += (rng() % 2 == 0) ? 3.0 : -3.0;
+        }
+        const bool bid = rng() % 2 == 0;
+        const double ticks = bid ? mid_ticks - 1 - offset(rng) : mid_ticks + 1 + offset(rng);
+        const double quantity = qty(rng) < 3 ? 0.0 : qty(rng) * 0.5;
+        on_change(book.ProcessUpdate(bid ? Bid(ticks * 0.01, quantity, i)
+                                         : Ask(ticks * 0.01, quantity, i)));
+        // Keep the book uncrossed the way the exchange would
+        if (bid) {
+            while (book.HasAsk() && book.BestAsk().price <= ticks * 0.01) {
+                on_change(book.ProcessUpdate(Ask(book.BestAsk().price, 0.0, i)));
+            }
+        } else {
+            while (book.HasBid() && book.BestBid().price >= ticks * 0.01) {
+                on_change(book.ProcessUpdate(Bid(book.BestBid().price, 0.0, i)));
+            }
+        }
+    }
+}
+
+bool near(double a, double b) {
+    return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+// Recomputes every signal from scratch and compares with the incremental values
+void check_analytics(const OrderBook& book) {
+    const BookAnalytics& a = book.Analytics();
+    const BookAnalytics::Config& config = a.GetConfig();
+    if (!book.HasBid() || !book.HasAsk()) {
+        assert(!a.HasTwoSidedQuote());
+        assert(a.BidDepthInBand() == 0.0 && a.AskDepthInBand() == 0.0);
+        return;
+    }
+    const PriceLevel& bid = book.BestBid();
+    const PriceLevel& ask = book.BestAsk();
+    const double mid = 0.5 * (bid.price + ask.price);
+    assert(near(a.Spread(), ask.price - bid.price));
+    assert(near(a.Mid(), mid));
+    assert(near(a.Microprice(), (bid.price * ask.quantity + ask.price * bid.quantity) /
+                                    (bid.quantity + ask.quantity)));
+
+    double bid_k = 0.0, ask_k = 0.0;
+    for (size_t i = 0; i < config.imbalance_levels && i < book.Bids().size(); ++i) {
+        bid_k += book.Bids()[i].quantity;
+    }
+    for (size_t i = 0; i < config.imbalance_levels && i < book.Asks().size(); ++i) {
+        ask_k += book.Asks()[i].quantity;
+    }
+    assert(near(a.BidTopKQuantity(), bid_k));
+    assert(near(a.AskTopKQuantity(), ask_k));
+
+    const double fraction = config.depth_band_bps / 10000.0;
+    double bid_band = 0.0, ask_band = 0.0;
+    for (const PriceLevel& level : book.Bids()) {
+        if (level.price >= mid * (1.0 - fraction)) bid_band += level.quantity;
+    }
+    for (const PriceLevel& level : book.Asks()) {
+        if (level.price <= mid * (1.0 + fraction)) ask_band += level.quantity;
+    }
+    assert(near(a.BidDepthInBand(), bid_band));
+    assert(near(a.AskDepthInBand(), ask_band));
+}
+
+void analytics_test() {
+    OrderBook::Config config;
+    config.analytics_config.imbalance_levels = 3;
+    config.analytics_config.depth_band_bps = 5.0;
+    OrderBook book(config);
+
+    book.ProcessUpdate(Bid(100.00, 2.0));
+    assert(!book.Analytics().HasTwoSidedQuote());
+    book.ProcessUpdate(Ask(100.02, 6.0));
+    assert(near(book.Analytics().Spread(), 0.02));
+    assert(near(book.Analytics().Mid(), 100.01));
+    // Heavier ask pulls the microprice toward the bid
+    assert(near(book.Analytics().Microprice(), (100.00 * 6.0 + 100.02 * 2.0) / 8.0));
+    check_analytics(book);
+
+    random_walk(book, 50000, [&](const LevelChange&) { check_analytics(book); });
+
+    book.Clear();
+    check_analytics(book);
+}
+
+void integrity_test() {
+    OrderBook book;
+    ResyncSignal& resync = book.Resync();
+
+    // A batch may cross the book transiently; only the end state counts
+    book.ProcessUpdate(Bid(100.0, 1.0, 10));
+    book.ProcessUpdate(Ask(101.0, 1.0, 10));
+    book.ProcessUpdate(Bid(101.5, 1.0, 11));
+    book.ProcessUpdate(Ask(101.0, 0.0, 11));
+    book.ProcessUpdate(Ask(102.0, 1.0, 11));
+    book.FinishBatch();
+    assert(!resync.Pending());
+    assert(book.Integrity().BatchesChecked() == 2);
+
+    // Locked at the end of a batch
+    book.ProcessUpdate(Ask(101.5, 2.0, 12));
+    book.FinishBatch();
+    assert(book.Integrity().FaultCount(IntegrityFault::LOCKED) == 1);
+    assert(resync.Take() == FaultBit(IntegrityFault::LOCKED));
+    assert(!resync.Pending());
+
+    // Crossed, detected when the next batch starts
+    book.ProcessUpdate(Bid(103.0, 1.0, 13));
+    assert(!resync.Pending());
+    book.ProcessUpdate(Bid(99.0, 1.0, 14));
+    assert(resync.Reasons() == FaultBit(IntegrityFault::CROSSED));
+    resync.Take();
+
+    // Stale update_id and bad quantities are dropped
+    book.ProcessUpdate(Bid(98.0, 1.0, 13));
+    book.ProcessUpdate(Bid(97.0, -1.0, 14));
+    book.ProcessUpdate(Bid(96.0, std::nan(""), 14));
+    assert(book.Integrity().FaultCount(IntegrityFault::OUT_OF_ORDER) == 1);
+    assert(book.Integrity().FaultCount(IntegrityFault::BAD_QUANTITY) == 2);
+    assert(resync.Take() == (FaultBit(IntegrityFault::OUT_OF_ORDER) |
+                             FaultBit(IntegrityFault::BAD_QUANTITY)));
+    assert(std::all_of(book.Bids().begin(), book.Bids().end(), [](const PriceLevel& level) {
+        return level.price > 99.0 - 1e-9 && level.quantity > 0.0;
+    }));
+
+    // Resync from a snapshot, then check against references
+    DepthSnapshot snapshot;
+    snapshot.update_id = 20;
+    snapshot.bids = {{100.0, 1.0}, {99.0, 2.0}};
+    snapshot.asks = {{101.0, 1.0}, {102.0, 3.0}};
+    book.LoadSnapshot(snapshot);
+    assert(book.LastUpdateId() == 20);
+    assert(book.Bids().size() == 2 && book.Asks().size() == 2);
+
+    // Reference at the current update id is compared immediately
+    book.VerifyAgainst(snapshot);
+    assert(book.Integrity().ReferencesChecked() == 1);
+    assert(!resync.Pending());
+
+    // Future reference, compared when the book lands on it
+    DepthSnapshot reference = snapshot;
+    reference.update_id = 21;
+    reference.bids[0].quantity = 5.0;
+    book.VerifyAgainst(reference);
+    book.ProcessUpdate(Bid(100.0, 5.0, 21));
+    book.FinishBatch();
+    assert(book.Integrity().ReferencesChecked() == 2);
+    assert(!resync.Pending());
+
+    // Mismatch raises the signal
+    reference.update_id = 22;
+    book.VerifyAgainst(reference);
+    book.ProcessUpdate(Ask(101.0, 4.0, 22));
+    book.FinishBatch();
+    assert(resync.Take() == FaultBit(IntegrityFault::CHECKSUM_MISMATCH));
+
+    // A reference the book skipped over can't be checked
+    reference.update_id = 23;
+    book.VerifyAgainst(reference);
+    book.ProcessUpdate(Ask(101.0, 3.0, 24));
+    book.FinishBatch();
+    assert(book.Integrity().ReferencesSkipped() == 1);
+    assert(!resync.Pending());
+}
+
+void check_bands(const OrderBook& book, const BandDepthView& view) {
+    const size_t n = view.BucketCount();
+    std::vector<double> bid_qty(n, 0.0), ask_qty(n, 0.0);
+    std::vector<uint32_t> bid_levels(n, 0), ask_levels(n, 0);
+    book.ForEachLevel(BookSide::BID, [&](const PriceLevel& level) {
+        const int64_t b = view.BucketOf(level.price);
+        if (b >= 0 && b < static_cast<int64_t>(n)) {
+            bid_qty[b] += level.quantity;
+            ++bid_levels[b];
+        }
+    });
+    book.ForEachLevel(BookSide::ASK, [&](const PriceLevel& level) {
+        const int64_t b = view.BucketOf(level.price);
+        if (b >= 0 && b < static_cast<int64_t>(n)) {
+            ask_qty[b] += level.quantity;
+            ++ask_levels[b];
+        }
+    });
+    for (size_t i = 0; i < n; ++i) {
+        assert(near(view.BidQuantities()[i], bid_qty[i]));
+        assert(near(view.AskQuantities()[i], ask_qty[i]));
+        assert(view.BidLevelCounts()[i] == bid_levels[i]);
+        assert(view.AskLevelCounts()[i] == ask_levels[i]);
+    }
+}
+
+void band_view_test() {
+    // 10-tick bands on a 0.01 tick
+    OrderBook book;
+    BandDepthView::Config config = BandDepthView::TickBands(0.01, 10, 64);
+    config.recenter_margin = 28;  // Recenter after a few bands of drift
+    BandDepthView view(config);
+    assert(!view.IsCentered());
+
+    view.Apply(book, book.ProcessUpdate(Bid(100.00, 1.0)));
+    view.Apply(book, book.ProcessUpdate(Ask(100.05, 2.0)));
+    view.Apply(book, book.ProcessUpdate(Bid(99.95, 3.0)));
+    view.Apply(book, book.ProcessUpdate(Bid(99.91, 4.0)));
+    view.Apply(book, book.ProcessUpdate(Ask(100.10, 5.0)));
+    assert(view.IsCentered());
+    assert(near(view.BucketWidth(), 0.1));
+
+    // 99.91 and 99.95 share the [99.90, 100.00) band; 100.00 starts the next
+    [[maybe_unused]] const int64_t low_band = view.BucketOf(99.95);
+    assert(view.BucketOf(99.91) == low_band);
+    assert(view.BucketOf(100.00) == low_band + 1);
+    assert(near(view.BucketLowPrice(low_band), 99.90));
+    assert(near(view.BidQuantities()[low_band], 7.0));
+    assert(view.BidLevelCounts()[low_band] == 2);
+    assert(near(view.AskQuantities()[low_band + 1], 2.0));
+    assert(near(view.AskQuantities()[low_band + 2], 5.0));
+
+    view.Apply(book, book.ProcessUpdate(Bid(99.95, 0.0, 2)));
+    assert(near(view.BidQuantities()[low_band], 4.0));
+    assert(view.BidLevelCounts()[low_band] == 1);
+    check_bands(book, view);
+
+    // Long random walk drifts far enough to force recenters
+    random_walk(book, 100000, [&](const LevelChange& change) {
+        view.Apply(book, change);
+    }, 7);
+    check_bands(book, view);
+    assert(view.Recenters() > 1);
+
+    // Basis-point bands
+    OrderBook bps_book;
+    BandDepthView bps_view(BandDepthView::BpsBands(1.0, 128));
+    random_walk(bps_book, 20000, [&](const LevelChange& change) {
+        bps_view.Apply(bps_book, change);
+    });
+    check_bands(bps_book, bps_view);
+    // 1bp of a ~100 mid
+    assert(bps_view.BucketWidth() > 0.0095 && bps_view.BucketWidth() < 0.0105);
+}
+
+// Applies a diff to a subscriber's top-N view
+void apply_diff(std::vector<PriceLevel>& bids, std::vector<PriceLevel>& asks,
+                const BookDiff& diff) {
+    for (const DiffEntry& entry : diff.entries) {
+        std::vector<PriceLevel>& levels = entry.side == BookSide::BID ? bids : asks;
+        auto it = std::find_if(levels.begin(), levels.end(), [&](const PriceLevel& level) {
+            return level.price == entry.price;
+        });
+        if (entry.quantity == 0.0) {
+            assert(it != levels.end());
+            levels.erase(it);
+        } else if (it != levels.end()) {
+            it->quantity = entry.quantity;
+        } else {
+            levels.push_back({entry.price, entry.quantity});
+        }
+    }
+    std::sort(bids.begin(), bids.end(), [](auto& a, auto& b) { return a.price > b.price; });
+    std::sort(asks.begin(), asks.end(), [](auto& a, auto& b) { return a.price < b.price; });
+}
+
+bool same_top(const std::vector<PriceLevel>& view, const std::vector<PriceLevel>& levels,
+              size_t depth) {
+    const size_t n = std::min(depth, levels.size());
+    if (view.size() != n) return false;
+    for (size_t i = 0; i < n; ++i) {
+        if (view[i].price != levels[i].price || view[i].quantity != levels[i].quantity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void diff_test() {
+    OrderBook::Config config;
+    config.diff_depth = 3;
+    OrderBook book(config);
+    assert(book.TakeDiff() == nullptr);
+
+    book.ProcessUpdate(Bid(100.0, 1.0, 1));
+    book.ProcessUpdate(Bid(99.0, 1.0, 1));
+    book.ProcessUpdate(Ask(101.0, 2.0, 1));
+    assert(book.TakeDiff() == nullptr);  // Batch still open
+    book.FinishBatch();
+    const BookDiff* diff = book.TakeDiff();
+    assert(diff != nullptr && diff->entries.size() == 3 && diff->update_id == 1);
+    assert(book.TakeDiff() == nullptr);  // Taken once
+
+    // Churn that comes back to where it started produces nothing
+    book.ProcessUpdate(Bid(100.0, 5.0, 2));
+    book.ProcessUpdate(Bid(98.5, 1.0, 2));
+    book.ProcessUpdate(Bid(100.0, 1.0, 2));
+    book.ProcessUpdate(Bid(98.5, 0.0, 2));
+    book.FinishBatch();
+    assert(book.TakeDiff() == nullptr);
+    assert(book.DiffTracker().CancelledBatches() == 1);
+
+    // Only the net change survives; the next update id closes the batch
+    book.ProcessUpdate(Ask(101.0, 7.0, 3));
+    book.ProcessUpdate(Ask(101.0, 3.0, 3));
+    book.ProcessUpdate(Ask(102.0, 1.0, 4));
+    diff = book.TakeDiff();
+    assert(diff != nullptr && diff->entries.size() == 1 && diff->update_id == 3);
+    assert(diff->entries[0].side == BookSide::ASK);
+    assert(diff->entries[0].price == 101.0 && diff->entries[0].quantity == 3.0);
+
+    // Changes below the top N are not reported
+    book.FinishBatch();
+    book.TakeDiff();
+    book.ProcessUpdate(Bid(97.0, 1.0, 5));
+    book.ProcessUpdate(Bid(96.0, 1.0, 5));
+    book.FinishBatch();
+    diff = book.TakeDiff();
+    assert(diff != nullptr && diff->entries.size() == 1);  // 97 enters the top 3
+    book.ProcessUpdate(Bid(96.0, 2.0, 6));
+    book.FinishBatch();
+    assert(book.TakeDiff() == nullptr);
+
+    // A level pushed out of the top N by an insert is reported as removed
+    book.ProcessUpdate(Bid(100.5, 1.0, 7));
+    book.FinishBatch();
+    diff = book.TakeDiff();
+    assert(diff != nullptr && diff->entries.size() == 2);
+    assert(diff->entries[0].price == 100.5 && diff->entries[0].quantity == 1.0);
+    assert(diff->entries[1].price == 97.0 && diff->entries[1].quantity == 0.0);
+
+    // A subscriber applying every diff tracks the top N exactly
+    OrderBook::Config deep_config;
+    deep_config.diff_depth = 10;
+    OrderBook deep(deep_config);
+    std::vector<PriceLevel> view_bids, view_asks;
+    uint64_t raw_updates = 0;
+    random_walk(deep, 30000, [&](const LevelChange&) {
+        ++raw_updates;
+        if (const BookDiff* d = deep.TakeDiff()) {
+            apply_diff(view_bids, view_asks, *d);
+        }
+    });
+    deep.FinishBatch();
+    if (const BookDiff* d = deep.TakeDiff()) {
+        apply_diff(view_bids, view_asks, *d);
+    }
+    assert(same_top(view_bids, deep.Bids(), 10));
+    assert(same_top(view_asks, deep.Asks(), 10));
+    std::cout << "  Raw updates: " << raw_updates << ", diff entries: "
+              << deep.DiffTracker().EntriesEmitted() << std::endl;
+
+    // Reloading from a snapshot emits the move to the snapshot right away
+    DepthSnapshot snapshot;
+    snapshot.update_id = deep.LastUpdateId() + 10;
+    snapshot.bids = {{99.0, 1.0}};
+    snapshot.asks = {{101.0, 1.0}};
+    deep.LoadSnapshot(snapshot);
+    diff = deep.TakeDiff();
+    assert(diff != nullptr);
+    apply_diff(view_bids, view_asks, *diff);
+    assert(same_top(view_bids, deep.Bids(), 10));
+    assert(same_top(view_asks, deep.Asks(), 10));
+}
+
+std::vector<PriceLevel> all_levels(const OrderBook& book, BookSide side) {
+    std::vector<PriceLevel> levels;
+    book.ForEachLevel(side, [&](const PriceLevel& level) { levels.push_back(level); });
+    return levels;
+}
+
+bool same_levels(const std::vector<PriceLevel>& a, const std::vector<PriceLevel>& b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](const PriceLevel& x, const PriceLevel& y) {
+               return x.price == y.price && x.quantity == y.quantity;
+           });
+}
+
+void bounded_depth_test() {
+    OrderBook::Config config;
+    config.max_depth = 3;
+    OrderBook book(config);
+
+    for (int i = 0; i < 5; ++i) {
+        book.ProcessUpdate(Bid(100.0 - i, 1.0 + i));
+    }
+    assert(book.Bids().size() == 3);
+    assert(book.FarLevels(BookSide::BID) == 2);
+    assert(book.Bids().back().price == 98.0);
+
+    // Update past the retained depth goes to the far levels
+    [[maybe_unused]] LevelChange change = book.ProcessUpdate(Bid(96.0, 9.0, 2));
+    assert(change.action == LevelAction::UPDATE && change.index == 3);
+    assert(book.FarUpdates() == 3);  // Including the inserts of 97 and 96
+
+    // Better insert evicts the worst retained level
+    book.ProcessUpdate(Bid(100.5, 1.0, 3));
+    assert(book.Bids().size() == 3 && book.Bids().back().price == 99.0);
+    assert(book.FarLevels(BookSide::BID) == 3);
+    assert(book.Evictions() == 1);
+
+    // Removing retained levels pulls far levels back into range, in order
+    book.ProcessUpdate(Bid(100.5, 0.0, 4));
+    book.ProcessUpdate(Bid(100.0, 0.0, 4));
+    assert(book.Bids().size() == 3);
+    assert(book.Bids()[1].price == 98.0 && book.Bids()[2].price == 97.0);
+    assert(book.Promotions() == 2);
+    book.ProcessUpdate(Bid(99.0, 0.0, 5));
+    book.ProcessUpdate(Bid(98.0, 0.0, 5));
+    assert(book.Bids().size() == 2 && book.FarLevels(BookSide::BID) == 0);
+    assert(book.Bids()[1].price == 96.0 && book.Bids()[1].quantity == 9.0);
+    assert(book.Analytics().BidTopKQuantity() == 4.0 + 9.0);
+
+    // The checksum only covers retained levels, so a full-depth reference
+    // that agrees on them passes
+    assert(book.Integrity().ChecksumDepth() == 3);
+    DepthSnapshot reference;
+    reference.update_id = 5;
+    reference.bids = {{97.0, 4.0}, {96.0, 9.0}};
+    for (int i = 0; i < 6; ++i) {
+        reference.asks.push_back({101.0 + i, 1.0});
+    }
+    OrderBook checked(config);
+    checked.LoadSnapshot(reference);
+    checked.VerifyAgainst(reference);
+    assert(checked.Integrity().ReferencesChecked() == 1);
+    assert(checked.Integrity().FaultCount(IntegrityFault::CHECKSUM_MISMATCH) == 0);
+
+    // Against an unbounded book on a long random walk: the retained levels
+    // are exactly the top of the full book, and nothing is lost
+    OrderBook::Config bounded_config;
+    bounded_config.max_depth = 8;
+    bounded_config.diff_depth = 5;
+    OrderBook bounded(bounded_config);
+    OrderBook full;
+    BandDepthView::Config band_config = BandDepthView::TickBands(0.01, 5, 64);
+    band_config.recenter_margin = 24;
+    BandDepthView bounded_view(band_config);
+    std::vector<PriceLevel> view_bids, view_asks;
+    random_walk(full, 40000, [](const LevelChange&) {}, 3);
+    random_walk(bounded, 40000, [&](const LevelChange& c) {
+        bounded_view.Apply(bounded, c);
+        check_analytics(bounded);
+        if (const BookDiff* d = bounded.TakeDiff()) {
+            apply_diff(view_bids, view_asks, *d);
+        }
+    }, 3);
+    for (BookSide side : {BookSide::BID, BookSide::ASK}) {
+        [[maybe_unused]] const std::vector<PriceLevel>& retained = bounded.Levels(side);
+        [[maybe_unused]] const std::vector<PriceLevel>& reference = full.Levels(side);
+        assert(retained.size() == std::min<size_t>(8, reference.size()));
+        assert(same_levels(retained, std::vector<PriceLevel>(reference.begin(),
+                                                             reference.begin() + retained.size())));
+        assert(same_levels(all_levels(bounded, side), reference));
+    }
+    assert(bounded.Evictions() > 0 && bounded.Promotions() > 0);
+    check_bands(bounded, bounded_view);
+    bounded.FinishBatch();
+    if (const BookDiff* d = bounded.TakeDiff()) {
+        apply_diff(view_bids, view_asks, *d);
+    }
+    assert(same_top(view_bids, bounded.Bids(), 5));
+    assert(same_top(view_asks, bounded.Asks(), 5));
+
+    // Snapshots beyond the retained depth land in the far levels
+    DepthSnapshot snapshot;
+    snapshot.update_id = 100000;
+    for (int i = 0; i < 20; ++i) {
+        snapshot.bids.push_back({100.0 - i, 1.0});
+        snapshot.asks.push_back({101.0 + i, 1.0});
+    }
+    bounded.LoadSnapshot(snapshot);
+    assert(bounded.Bids().size() == 8 && bounded.FarLevels(BookSide::BID) == 12);
+    assert(same_levels(all_levels(bounded, BookSide::ASK), snapshot.asks));
+}
+
+// Brute-force book walk
+FillEstimate walk(const std::vector<PriceLevel>& levels, double quantity) {
+    FillEstimate e;
+    double remaining = quantity;
+    for (const PriceLevel& level : levels) {
+        const double take = std::min(remaining, level.quantity);
+        e.filled_quantity += take;
+        e.notional += take * level.price;
+        e.worst_price = level.price;
+        ++e.levels;
+        remaining -= take;
+        if (remaining <= 0.0) {
+            e.complete = true;
+            break;
+        }
+    }
+    if (e.filled_quantity > 0.0) e.average_price = e.notional / e.filled_quantity;
+    return e;
+}
+
+void check_liquidity(const OrderBook& book) {
+    for (double q : {0.5, 3.0, 12.5, 40.0, 1e6}) {
+        for (BookSide side : {BookSide::BID, BookSide::ASK}) {
+            [[maybe_unused]] const FillEstimate got = side == BookSide::ASK ? book.EstimateBuy(q)
+                                                           : book.EstimateSell(q);
+            [[maybe_unused]] const FillEstimate want = walk(book.Levels(side), q);
+            assert(got.complete == want.complete);
+            assert(got.levels == want.levels);
+            assert(near(got.filled_quantity, want.filled_quantity));
+            assert(near(got.notional, want.notional));
+            assert(got.worst_price == want.worst_price);
+        }
+    }
+    if (!book.HasBid() || !book.HasAsk()) {
+        return;
+    }
+    const double mid = 0.5 * (book.BestBid().price + book.BestAsk().price);
+    for (double bps : {0.0, 2.0, 10.0, 50.0}) {
+        double bid_qty = 0.0, ask_qty = 0.0;
+        for (const PriceLevel& l : book.Bids()) {
+            if (l.price >= mid - mid * bps / 10000.0) bid_qty += l.quantity;
+        }
+        for (const PriceLevel& l : book.Asks()) {
+            if (l.price <= mid + mid * bps / 10000.0) ask_qty += l.quantity;
+        }
+        assert(near(book.QuantityWithinBps(BookSide::BID, bps), bid_qty));
+        assert(near(book.QuantityWithinBps(BookSide::ASK, bps), ask_qty));
+    }
+}
+
+void liquidity_test() {
+    OrderBook book;
+    assert(!book.EstimateBuy(1.0).complete);
+
+    book.ProcessUpdate(Ask(100.0, 1.0));
+    book.ProcessUpdate(Ask(101.0, 2.0));
+    book.ProcessUpdate(Ask(102.0, 3.0));
+    book.ProcessUpdate(Bid(99.0, 4.0));
+
+    // 1 @ 100 + 2 @ 101 + 0.5 @ 102
+    FillEstimate buy = book.EstimateBuy(3.5);
+    assert(buy.complete && buy.levels == 3);
+    assert(near(buy.notional, 100.0 + 202.0 + 51.0));
+    assert(near(buy.average_price, 353.0 / 3.5));
+    assert(buy.worst_price == 102.0);
+    assert(near(buy.slippage_bps, (353.0 / 3.5 - 99.5) / 99.5 * 10000.0));
+
+    // More than the side holds
+    buy = book.EstimateBuy(10.0);
+    assert(!buy.complete && buy.filled_quantity == 6.0 && buy.levels == 3);
+
+    // An insert ahead of cached levels shifts them
+    book.ProcessUpdate(Ask(100.5, 5.0, 2));
+    buy = book.EstimateBuy(3.5);
+    assert(buy.levels == 2 && near(buy.notional, 100.0 + 2.5 * 100.5));
+
+    [[maybe_unused]] FillEstimate sell = book.EstimateSell(2.0);
+    assert(sell.complete && sell.average_price == 99.0);
+    assert(near(sell.slippage_bps, (99.5 - 99.0) / 99.5 * 10000.0));
+
+    // Mid 99.5: 100 and 100.5 lie within 120bps, 101 doesn't
+    assert(near(book.QuantityWithinBps(BookSide::ASK, 120.0), 6.0));
+    assert(near(book.QuantityWithinBps(BookSide::ASK, 80.0), 1.0));
+    check_liquidity(book);
+
+    random_walk(book, 20000, [&](const LevelChange&) { check_liquidity(book); }, 11);
+
+    OrderBook::Config config;
+    config.max_depth = 6;
+    OrderBook bounded(config);
+    random_walk(bounded, 20000, [&](const LevelChange&) { check_liquidity(bounded); }, 12);
+}
+
+void queue_position_test() {
+    using Estimator = QueuePositionEstimator;
+    OrderBook book;
+    book.ProcessUpdate(Bid(100.0, 10.0));
+    book.ProcessUpdate(Ask(101.0, 5.0));
+
+    // Hypothetical order: joins behind the 10 resting at 100
+    Estimator::Config config;
+    config.model = Estimator::CancelModel::PROPORTIONAL;
+    Estimator proportional(config);
+    config.model = Estimator::CancelModel::PESSIMISTIC;
+    Estimator pessimistic(config);
+    config.model = Estimator::CancelModel::OPTIMISTIC;
+    Estimator optimistic(config);
+    Estimator* all[] = {&proportional, &pessimistic, &optimistic};
+    Estimator::OrderId ids[3];
+    for (int k = 0; k < 3; ++k) {
+        ids[k] = all[k]->AddOrder(book, BookSide::BID, 100.0, 2.0);
+        assert(all[k]->Find(ids[k])->queue_ahead == 10.0);
+    }
+    auto apply = [&](const NormalizedUpdate& update) {
+        if (update.type == NormalizedUpdate::Type::TRADE) {
+            for (Estimator* e : all) e->OnTrade(update);
+            return;
+        }
+        LevelChange change = book.ProcessUpdate(update);
+        for (Estimator* e : all) e->OnLevelChange(change);
+    };
+
+    // Growth goes behind us
+    apply(Bid(100.0, 14.0, 2));
+    for (int k = 0; k < 3; ++k) {
+        assert(all[k]->Find(ids[k])->queue_ahead == 10.0);
+    }
+
+    // Trade of 3 at our price comes off the front; the depth update that
+    // follows shouldn't move us again
+    apply(Trade(100.0, 3.0, 3));
+    apply(Bid(100.0, 11.0, 3));
+    for (int k = 0; k < 3; ++k) {
+        assert(all[k]->Find(ids[k])->queue_ahead == 7.0);
+        assert(all[k]->Find(ids[k])->traded_at_price == 3.0);
+    }
+
+    // A 4 lot cancel with 7 ahead and 4 behind
+    apply(Bid(100.0, 7.0, 4));
+    assert(near(proportional.Find(ids[0])->queue_ahead, 7.0 - 4.0 * 7.0 / 11.0));
+    assert(pessimistic.Find(ids[1])->queue_ahead == 7.0);
+    assert(optimistic.Find(ids[2])->queue_ahead == 3.0);
+    assert(near(optimistic.Find(ids[2])->QueueProgress(), 0.7));
+
+    // Never more ahead than the level holds
+    apply(Bid(100.0, 5.0, 5));
+    assert(pessimistic.Find(ids[1])->queue_ahead == 5.0);
+
+    // A print bigger than the queue ahead fills us
+    apply(Trade(100.0, 6.0, 6));
+    [[maybe_unused]] const OwnOrder* filled = pessimistic.Find(ids[1]);
+    assert(filled->queue_ahead == 0.0 && filled->filled == 1.0 && filled->Remaining() == 1.0);
+
+    // Level cleared: we're at the front
+    apply(Bid(100.0, 0.0, 7));
+    for (int k = 0; k < 3; ++k) {
+        assert(all[k]->Find(ids[k])->queue_ahead == 0.0);
+    }
+
+    // Unrelated prices and sides are ignored
+    apply(Ask(100.0, 3.0, 8));
+    apply(Bid(99.0, 3.0, 8));
+    assert(optimistic.Find(ids[2])->level_quantity == 0.0);
+
+    // Several orders at one price, and removal from the middle of the list
+    book.Clear();
+    book.ProcessUpdate(Ask(101.0, 4.0, 9));
+    Estimator asks;
+    Estimator::OrderId first = asks.AddOrder(book, BookSide::ASK, 101.0, 1.0);
+    Estimator::OrderId second = asks.AddOrder(book, BookSide::ASK, 101.0, 1.0);
+    Estimator::OrderId third = asks.AddOrder(book, BookSide::ASK, 101.0, 1.0);
+    asks.RemoveOrder(second);
+    assert(asks.Find(second) == nullptr);
+    asks.OnTrade(Trade(101.0, 1.0, 10));
+    assert(asks.Find(first)->queue_ahead == 3.0 && asks.Find(third)->queue_ahead == 3.0);
+    asks.RemoveOrder(first);
+    asks.RemoveOrder(third);
+    asks.OnTrade(Trade(101.0, 1.0, 11));
+    // Freed slots are reused
+    [[maybe_unused]] Estimator::OrderId reused = asks.AddOrder(book, BookSide::ASK, 102.0, 1.0);
+    assert(reused == third && asks.Find(reused)->queue_ahead == 0.0);
+
+    // Real orders count themselves in the level: added once the book shows
+    // ours, the rest of the level is ahead of it
+    config.model = Estimator::CancelModel::PROPORTIONAL;
+    config.orders_in_book = true;
+    Estimator real(config);
+    book.ProcessUpdate(Ask(101.0, 6.0, 12));
+    [[maybe_unused]] Estimator::OrderId own = real.AddOrder(book, BookSide::ASK, 101.0, 2.0);
+    assert(real.Find(own)->queue_ahead == 4.0);
+    assert(real.Find(own)->initial_ahead == 4.0);
+    // 4 ahead, nobody else behind: a cancel must come from ahead
+    real.OnLevelChange(book.ProcessUpdate(Ask(101.0, 5.0, 13)));
+    assert(near(real.Find(own)->queue_ahead, 3.0));
+    real.OnLevelChange(book.ProcessUpdate(Ask(101.0, 2.0, 14)));
+    assert(real.Find(own)->queue_ahead == 0.0);
+}
+
+void sharded_stage_test() {
+    const size_t kSymbols = 12;
+    ShardedBookStage<256>::Config config;
+    config.shard_count = 3;
+    std::atomic<uint64_t> heard{0};
+    ShardedBookStage<256> stage(kSymbols, config,
+                                [&](SymbolId, const OrderBook&, const LevelChange&) {
+                                    heard.fetch_add(1, std::memory_order_relaxed);
+                                });
+    assert(stage.ShardOf(4) == 1);
+
+    std::vector<OrderBook> reference(kSymbols);
+    std::vector<uint64_t> next_id(kSymbols, 1);
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> offset(0, 30);
+    std::uniform_int_distribution<int> qty(0, 9);
+    // Symbols 0-2 are hot, all on different shards to start with
+    auto route = [&](size_t count) {
+        for (size_t n = 0; n < count; ++n) {
+            const SymbolId symbol = rng() % 4 != 0 ? static_cast<SymbolId>(rng() % 3)
+                                                   : static_cast<SymbolId>(rng() % kSymbols);
+            const bool bid = rng() % 2 == 0;
+            const double price = bid ? 100.0 - offset(rng) * 0.01 : 100.01 + offset(rng) * 0.01;
+            const double quantity = qty(rng) < 3 ? 0.0 : qty(rng) * 0.5;
+            const NormalizedUpdate update = bid ? Bid(price, quantity, next_id[symbol]++)
+                                                : Ask(price, quantity, next_id[symbol]++);
+            reference[symbol].ProcessUpdate(update);
+            [[maybe_unused]] bool routed = stage.Route(symbol, update);
+            assert(routed);
+        }
+    };
+    auto check = [&]() {
+        stage.Drain();
+        for (SymbolId s = 0; s < kSymbols; ++s) {
+            [[maybe_unused]] const OrderBook* book = stage.Book(s);
+            assert(book != nullptr);
+            assert(same_levels(book->Bids(), reference[s].Bids()));
+            assert(same_levels(book->Asks(), reference[s].Asks()));
+            assert(book->LastUpdateId() == reference[s].LastUpdateId());
+        }
+    };
+
+    stage.Start();
+    route(20000);
+    check();
+
+    // Shard 0 carries symbols 0, 3, 6, 9; pile load onto it
+    for (int round = 0; round < 2000; ++round) {
+        stage.Route(0, Bid(99.0, 1.0 + round % 3, next_id[0]));
+        reference[0].ProcessUpdate(Bid(99.0, 1.0 + round % 3, next_id[0]++));
+        stage.Route(3, Ask(101.0, 1.0 + round % 3, next_id[3]));
+        reference[3].ProcessUpdate(Ask(101.0, 1.0 + round % 3, next_id[3]++));
+    }
+    stage.Drain();
+    [[maybe_unused]] size_t moved = stage.Rebalance();
+    assert(moved > 0 && stage.Moves() == moved);
+    assert(stage.ShardOf(0) != stage.ShardOf(3));
+
+    // Books follow their symbols to the new shards, including mid-stream
+    // moves that have to wait for the old shard to catch up
+    for (int round = 0; round < 10; ++round) {
+        route(3000);
+        stage.Rebalance();
+        stage.Move(static_cast<SymbolId>(round % kSymbols), round % 3);
+    }
+    check();
+
+    stage.Stop();
+    uint64_t applied = 0;
+    for (size_t s = 0; s < stage.ShardCount(); ++s) {
+        applied += stage.ShardUpdates(s);
+    }
+    assert(applied == heard.load() && applied == 20000 + 4000 + 30000);
+    assert(!stage.Route(kSymbols, Bid(1.0, 1.0)));
+}
+
+void sharded_resync_test() {
+    ShardedBookStage<256>::Config config;
+    config.shard_count = 2;
+    ShardedBookStage<256> stage(4, config);
+    stage.Start();
+    stage.Route(1, Bid(100.0, 1.0, 10));
+    stage.Route(1, Ask(101.0, 1.0, 10));
+    stage.Drain();
+    assert(stage.TakeResync(1) == 0);
+
+    // A stale update: the book drops it and asks for a resync, once
+    stage.Route(1, Bid(99.0, 1.0, 5));
+    stage.Route(1, Bid(99.5, 1.0, 11));
+    stage.Drain();
+    assert(stage.TakeResync(1) == FaultBit(IntegrityFault::OUT_OF_ORDER));
+    assert(stage.TakeResync(1) == 0 && stage.TakeResync(0) == 0);
+    assert(stage.TakeResync(4) == 0);
+
+    // The snapshot goes in before the next update; updates it already
+    // covers are skipped, the rest applied on top
+    DepthSnapshot snapshot;
+    snapshot.update_id = 20;
+    snapshot.bids = {{100.5, 2.0}, {100.0, 3.0}};
+    snapshot.asks = {{101.0, 4.0}};
+    assert(stage.Reload(1, snapshot));
+    assert(!stage.Reload(4, snapshot));
+    stage.Route(1, Bid(100.0, 7.0, 19));
+    stage.Route(1, Bid(100.0, 5.0, 20));
+    stage.Route(1, Ask(101.5, 1.0, 21));
+    stage.Drain();
+    [[maybe_unused]] const OrderBook* book = stage.Book(1);
+    assert(stage.Reloads() == 1 && stage.SkippedUpdates() == 2);
+    assert((same_levels(book->Bids(), {{100.5, 2.0}, {100.0, 3.0}})));
+    assert((same_levels(book->Asks(), {{101.0, 4.0}, {101.5, 1.0}})));
+    assert(book->LastUpdateId() == 21);
+    assert(stage.TakeResync(1) == 0);
+    stage.Stop();
+}
+
+int main() {
+    std::cout << "Testing order book..." << std::endl;
+    basic_book_test();
+    std::cout << "Order book tests passed!" << std::endl;
+
+    std::cout << "\nTesting incremental analytics..." << std::endl;
+    analytics_test();
+    std::cout << "Incremental analytics tests passed!" << std::endl;
+
+    std::cout << "\nTesting integrity checks..." << std::endl;
+    integrity_test();
+    std::cout << "Integrity tests passed!" << std::endl;
+
+    std::cout << "\nTesting band depth view..." << std::endl;
+    band_view_test();
+    std::cout << "Band depth view tests passed!" << std::endl;
+
+    std::cout << "\nTesting top-N diffs..." << std::endl;
+    diff_test();
+    std::cout << "Top-N diff tests passed!" << std::endl;
+
+    std::cout << "\nTesting bounded depth..." << std::endl;
+    bounded_depth_test();
+    std::cout << "Bounded depth tests passed!" << std::endl;
+
+    std::cout << "\nTesting liquidity queries..." << std::endl;
+    liquidity_test();
+    std::cout << "Liquidity query tests passed!" << std::endl;
+
+    std::cout << "\nTesting queue position..." << std::endl;
+    queue_position_test();
+    std::cout << "Queue position tests passed!" << std::endl;
+
+    std::cout << "\nTesting sharded book stage..." << std::endl;
+    sharded_stage_test();
+    sharded_resync_test();
+    std::cout << "Sharded book stage tests passed!" << std::endl;
+
+    std::cout << "\nTesting snapshot publishing..." << std::endl;
+    snapshot_publish_test();
+    snapshot_concurrency_test();
+    std::cout << "Snapshot publishing tests passed!" << std::endl;
+
+    return 0;
+}
@@ -5,8 +5,9 @@
 #include <chrono>
 #include <string>
 #include <iomanip>
-#include <algorithm>  // For std::sort
 #include "../core/ring_buffer.h"
+#include "../core/latency_tracker.h"
+#include "../core/load_generator.h"
 
 // More realistic market data structures
 struct MarketTick {
@@ -56,6 +57,7 @@ void basic_functionality_test() {
     assert(buffer.TryPush(tick4));
     assert(buffer.TryPush(tick5));
     assert(!buffer.TryPush({}));  // Should be full again
+    assert(buffer.Occupancy() == 3 && buffer.Occupancy() == buffer.Capacity());  // Wrapped
     
     // Empty the buffer
     assert(buffer.TryPop(&result));
@@ -65,30 +67,33 @@ void basic_functionality_test() {
     assert(buffer.TryPop(&result));
     assert(result == tick5);
     assert(!buffer.TryPop(&result));  // Should be empty
+    assert(buffer.Occupancy() == 0);
 }
 
 void market_data_pipeline_test() {
     constexpr size_t NUM_TICKS = 5000;
     constexpr size_t BUFFER_SIZE = 1024;
+    constexpr double TICKS_PER_SECOND = 100'000.0;
     
     LockFreeRingBuffer<MarketTick, BUFFER_SIZE> buffer;  // Only use one buffer
     
     std::atomic<bool> start{false};
     std::atomic<int> producer_count{0};
     std::atomic<int> consumer_count{0};
-    std::vector<int64_t> latencies;
-    latencies.reserve(NUM_TICKS);
+    LatencyTracker latencies;
     
     std::cout << "  Starting producer/consumer test with " << NUM_TICKS << " ticks..." << std::endl;
     
-    // Producer thread - simulates market data feed
+    // Producer thread - simulates market data feed at a constant rate. Each
+    // tick is stamped with when it was due, not when it got sent, so a
+    // stalled consumer shows up in the latencies instead of hiding them.
     std::thread producer([&]() {
         std::cout << "  Producer thread started" << std::endl;
         while (!start) { std::this_thread::yield(); }
         
+        ConstantRateSchedule schedule(TICKS_PER_SECOND);
         for (size_t i = 1; i <= NUM_TICKS; ++i) {
-            auto now = std::chrono::high_resolution_clock::now().time_since_epoch();
-            int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+            int64_t timestamp = static_cast<int64_t>(schedule.WaitFor(i, true));
             
             // Alternate between BTC and ETH
             std::string symbol = (i % 2 == 0) ? "BTCUSD" : "ETHUSD";
@@ -110,16 +115,12 @@ void market_data_pipeline_test() {
             while (!buffer.TryPush(tick)) { std::this_thread::yield(); }
             producer_count++;
             
-            // Add a small sleep every 100 ticks to avoid overwhelming the consumer
-            if (i % 100 == 0) {
-                std::this_thread::sleep_for(std::chrono::microseconds(10));
-            }
-            
             if (i % 1000 == 0) {
                 std::cout << "  Producer: " << i << " ticks sent" << std::endl;
             }
         }
-        std::cout << "  Producer finished" << std::endl;
+        std::cout << "  Producer finished (" << schedule.LateSends() << " sends behind schedule)"
+                  << std::endl;
     });
     
     // Consumer thread - processes market data
@@ -131,11 +132,10 @@ void market_data_pipeline_test() {
         for (size_t i = 1; i <= NUM_TICKS; ++i) {
             while (!buffer.TryPop(&tick)) { std::this_thread::yield(); }
             
-            // Record processing latency
-            auto now = std::chrono::high_resolution_clock::now().time_since_epoch();
-            int64_t process_ts = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+            // Record latency from the intended send time
+            int64_t process_ts = static_cast<int64_t>(TscClock::MonotonicNs());
             int64_t latency = process_ts - tick.timestamp_ns;
-            latencies.push_back(latency);
+            latencies.RecordLatency(latency);
             
             // Simulate some processing
             double processed_price = tick.price * tick.quantity;  // Just do some basic calculation
@@ -159,11 +159,10 @@ void market_data_pipeline_test() {
     
     // Calculate latency stats
     std::cout << "  Calculating statistics..." << std::endl;
-    std::sort(latencies.begin(), latencies.end());
-    int64_t min_latency = latencies.front();
-    int64_t max_latency = latencies.back();
-    int64_t median_latency = latencies[latencies.size() / 2];
-    int64_t p99_latency = latencies[latencies.size() * 99 / 100];
+    int64_t min_latency = latencies.MinLatency();
+    int64_t max_latency = latencies.MaxLatency();
+    int64_t median_latency = latencies.PercentileLatency(50);
+    int64_t p99_latency = latencies.PercentileLatency(99);
     
     std::cout << "Market data pipeline test results:\n";
     std::cout << "Producer pushed: " << producer_count << " ticks\n";
@@ -172,6 +171,7 @@ void market_data_pipeline_test() {
     std::cout << "  Min: " << min_latency << "\n";
     std::cout << "  Median: " << median_latency << "\n";
     std::cout << "  99th percentile: " << p99_latency << "\n";
+    std::cout << "  99.9th percentile: " << latencies.PercentileLatency(99.9) << "\n";
     std::cout << "  Max: " << max_latency << "\n";
 }
 
@@ -0,0 +1,104 @@
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <sys/resource.h>
+#include "../core/runtime_setup.h"
+
+namespace {
+
+long MinorFaults() {
+    rusage usage{};
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_minflt;
+}
+
+// Minor faults taken by one thread touching a fresh 4MB allocation.
+long FaultsForFirstTouch(RuntimeSetup* setup) {
+    long faults = 0;
+    std::thread worker([&]() {
+        if (setup != nullptr) {
+            setup->PrepareThread("worker");
+        }
+        const long before = MinorFaults();
+        void* block = std::malloc(4 << 20);
+        std::memset(block, 1, 4 << 20);
+        asm volatile("" : : "r"(block) : "memory");
+        std::free(block);
+        faults = MinorFaults() - before;
+    });
+    worker.join();
+    return faults;
+}
+
+[[maybe_unused]] bool HasStep(const RuntimeSetup& setup, const std::string& name) {
+    for (const RuntimeSetup::Step& step : setup.Steps()) {
+        if (step.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+void prefault_test() {
+    // Before any mlockall, which would populate everything regardless
+    RuntimeSetup::Config config;
+    config.lock_memory = false;
+    config.hold_dma_latency = false;
+    config.disable_thp = false;
+    config.prefault_heap_bytes = 0;
+    RuntimeSetup setup(config);
+    assert(setup.Apply());
+    assert(setup.Steps().size() == 1 && HasStep(setup, "retain_heap"));
+
+    const long cold = FaultsForFirstTouch(nullptr);
+    const long warm = FaultsForFirstTouch(&setup);
+    std::cout << "  first touch of 4MB: " << cold << " faults cold, " << warm
+              << " after PrepareThread" << std::endl;
+    assert(warm < cold / 4);
+    assert(HasStep(setup, "worker.prefault_stack"));
+    assert(HasStep(setup, "worker.prefault_heap"));
+    assert(!HasStep(setup, "worker.sched_fifo"));
+}
+
+void report_test() {
+    RuntimeSetup::Config config;
+    config.prefault_heap_bytes = 16 << 20;
+    RuntimeSetup setup(config);
+    [[maybe_unused]] const bool all_ok = setup.Apply();
+    for ([[maybe_unused]] const char* step : {"thp", "mlockall", "retain_heap", "prefault_heap", "dma_latency"}) {
+        assert(HasStep(setup, step));
+    }
+    std::thread worker([&]() { setup.PrepareThread("worker", 10); });
+    worker.join();
+    assert(HasStep(setup, "worker.sched_fifo"));
+
+    // Unprivileged, most steps fail; they're reported either way
+    [[maybe_unused]] bool process_ok = true;
+    for (const RuntimeSetup::Step& step : setup.Steps()) {
+        assert(step.ok || !step.detail.empty());
+        if (step.name.find('.') == std::string::npos) {
+            process_ok &= step.ok;
+        }
+    }
+    assert(all_ok == process_ok);
+    const std::string report = setup.Report();
+    assert(report.find("mlockall: ") != std::string::npos);
+    std::cout << report;
+}
+
+int main() {
+    std::cout << "Testing prefaulting..." << std::endl;
+    prefault_test();
+    std::cout << "Prefaulting tests passed!" << std::endl;
+
+    std::cout << "\nTesting runtime setup report..." << std::endl;
+    report_test();
+    std::cout << "Runtime setup report tests passed!" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../core/metrics_server.h"
+#include "../core/stats_segment.h"
+
+namespace {
+
+// Per-process name so parallel test runs don't share a segment
+std::string SegmentName() {
+    return "/low_latency_stats_test_" + std::to_string(getpid());
+}
+
+// One plain HTTP/1.1 request to localhost; returns the whole response.
+std::string HttpGet(uint16_t port, const std::string& path) {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::string response;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        const std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        send(fd, request.data(), request.size(), 0);
+        char buffer[4096];
+        ssize_t n;
+        while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            response.append(buffer, static_cast<size_t>(n));
+        }
+    }
+    close(fd);
+    return response;
+}
+
+}  // namespace
+
+void publish_read_test() {
+    const std::string name = SegmentName();
+    StatsSegmentReader reader;
+    assert(!reader.Attach(name));  // Nothing there yet
+
+    StatsSegment segment;
+    [[maybe_unused]] const bool created = segment.Create(name, 8, 1 << 20);
+    assert(created);
+    const int messages = segment.AddCounter("messages");
+    const int drift = segment.AddGauge("clock_drift_ppm");
+    LatencyTracker::Config config;
+    config.max_value = 1'000'000;
+    const int latency = segment.AddHistogram("latency", config, 0.5);
+    assert(messages == 0 && drift == 1 && latency == 2);
+
+    segment.SetCounter(messages, 42);
+    segment.SetGauge(drift, -1.5);
+    LatencyTracker tracker(config);
+    for (int64_t v = 1; v <= 1000; ++v) {
+        tracker.RecordLatency(v);
+    }
+    [[maybe_unused]] const bool set = segment.SetHistogram(latency, tracker);
+    assert(set);
+    assert(!segment.SetHistogram(latency, LatencyTracker()));  // Wrong config
+    segment.Publish();
+
+    [[maybe_unused]] const bool attached = reader.Attach(name);
+    assert(attached);
+    assert(reader.SlotCount() == 3 && reader.Publishes() == 1);
+    assert(reader.Pid() == static_cast<uint32_t>(getpid()));
+
+    StatsSegmentReader::Value value;
+    assert(reader.Read(0, &value) && value.name == "messages" && value.counter == 42);
+    assert(reader.Read(1, &value) && value.kind == StatKind::GAUGE && value.gauge == -1.5);
+    assert(reader.Read(2, &value) && value.kind == StatKind::HISTOGRAM);
+    assert(value.unit_ns == 0.5);
+    assert(value.histogram.Count() == 1000);
+    assert(value.histogram.MinLatency() == 1 && value.histogram.MaxLatency() == 1000);
+    assert(value.histogram.AvgLatency() == tracker.AvgLatency());
+    assert(value.histogram.PercentileLatency(99) == tracker.PercentileLatency(99));
+    assert(!reader.Read(3, &value));
+
+    // Slots registered after attach show up
+    segment.AddCounter("late");
+    assert(reader.SlotCount() == 4);
+
+    // Full table
+    for (int i = 0; i < 4; ++i) {
+        segment.AddCounter("filler");
+    }
+    assert(segment.AddCounter("one_too_many") == -1);
+}
+
+void version_test() {
+    const std::string name = SegmentName();
+    StatsSegment segment;
+    segment.Create(name, 4, 1 << 16);
+
+    // A viewer built against another layout must refuse it: patch the
+    // version field the way an older writer would have left it
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    assert(fd >= 0);
+    void* base = mmap(nullptr, sizeof(StatsHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    static_cast<StatsHeader*>(base)->version = kStatsLayoutVersion + 1;
+    munmap(base, sizeof(StatsHeader));
+
+    StatsSegmentReader reader;
+    [[maybe_unused]] const bool attached = reader.Attach(name);
+    assert(!attached);
+    assert(reader.Error().find("version") != std::string::npos);
+}
+
+void dead_writer_test() {
+    const std::string name = SegmentName();
+    StatsSegment segment;
+    segment.Create(name, 4, 1 << 16);
+    segment.AddHistogram("latency");
+
+    // A writer killed mid-copy leaves the slot's seq odd: patch it so
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    assert(fd >= 0);
+    const size_t slots = (sizeof(StatsHeader) + 63) & ~size_t{63};
+    void* base = mmap(nullptr, slots + sizeof(StatsSlot), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    StatsSlot* slot = reinterpret_cast<StatsSlot*>(static_cast<char*>(base) + slots);
+    slot->seq.store(1, std::memory_order_release);
+
+    StatsSegmentReader reader;
+    [[maybe_unused]] const bool attached = reader.Attach(name);
+    assert(attached);
+    StatsSegmentReader::Value value;
+    assert(!reader.Read(0, &value));  // Gives up rather than spinning
+
+    slot->seq.store(2, std::memory_order_release);
+    assert(reader.Read(0, &value) && value.histogram.Count() == 0);
+    munmap(base, slots + sizeof(StatsSlot));
+}
+
+void concurrent_read_test() {
+    const std::string name = SegmentName();
+    StatsSegment segment;
+    segment.Create(name, 4, 1 << 20);
+    const int latency = segment.AddHistogram("latency");
+
+    // The writer republishes a histogram whose samples are all equal to its
+    // round number; a torn copy would mix rounds
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+        LatencyTracker tracker;
+        for (int64_t round = 1; round <= 20'000; ++round) {
+            tracker.Reset();
+            tracker.RecordLatency(round % 200 + 1, 10);
+            segment.SetHistogram(latency, tracker);
+            segment.Publish();
+        }
+        done.store(true);
+    });
+
+    StatsSegmentReader reader;
+    while (!reader.Attach(name)) {
+        std::this_thread::yield();
+    }
+    StatsSegmentReader::Value value;
+    size_t reads = 0;
+    while (!done.load()) {
+        if (reader.Read(0, &value) && value.histogram.Count() != 0) {
+            assert(value.histogram.Count() == 10);
+            assert(value.histogram.MinLatency() == value.histogram.MaxLatency());
+            assert(value.histogram.PercentileLatency(0) == value.histogram.PercentileLatency(100));
+            ++reads;
+        }
+        std::this_thread::yield();
+    }
+    writer.join();
+    std::cout << "  Consistent reads during updates: " << reads << std::endl;
+}
+
+void metrics_server_test() {
+    const std::string name = SegmentName();
+    MetricsServer::Config config;
+    config.segment = name;
+    config.port = 0;  // Any free port
+    MetricsServer server(config);
+    [[maybe_unused]] const bool started = server.Start();
+    assert(started && server.Port() != 0);
+
+    // No segment yet
+    assert(HttpGet(server.Port(), "/metrics").find("503") != std::string::npos);
+
+    StatsSegment segment;
+    segment.Create(name, 8, 1 << 20);
+    segment.SetCounter(segment.AddCounter("raw_buffer.drops"), 3);
+    segment.SetGauge(segment.AddGauge("raw_buffer.occupancy"), 17);
+    segment.SetGauge(segment.AddGauge("clock.drift"), std::nan(""));
+    segment.SetGauge(segment.AddGauge("clock.skew"), -std::numeric_limits<double>::infinity());
+    const int latency = segment.AddHistogram("processing", {}, 1.0);
+    const int interval = segment.AddHistogram("processing.interval", {}, 1.0, true);
+    LatencyTracker tracker;
+    tracker.RecordLatency(150);        // In the 200ns bucket
+    tracker.RecordLatency(3'000);      // 5us
+    tracker.RecordLatency(2'000'000);  // 2ms
+    segment.SetHistogram(latency, tracker);
+    segment.SetHistogram(interval, tracker);
+    segment.Publish();
+
+    const std::string response = HttpGet(server.Port(), "/metrics");
+    [[maybe_unused]] auto has = [&](const std::string& line) {
+        return response.find(line + "\n") != std::string::npos;
+    };
+    assert(response.rfind("HTTP/1.1 200 OK", 0) == 0);
+    assert(response.find("application/openmetrics-text") != std::string::npos);
+    assert(has("# TYPE low_latency_raw_buffer_drops counter"));
+    assert(has("low_latency_raw_buffer_drops_total 3"));
+    assert(has("low_latency_raw_buffer_occupancy 17"));
+    assert(has("low_latency_clock_drift NaN"));
+    assert(has("low_latency_clock_skew -Inf"));
+    assert(has("# TYPE low_latency_processing_seconds histogram"));
+    assert(has("# UNIT low_latency_processing_seconds seconds"));
+    assert(has("low_latency_processing_seconds_bucket{le=\"1e-07\"} 0"));
+    assert(has("low_latency_processing_seconds_bucket{le=\"2e-07\"} 1"));
+    assert(has("low_latency_processing_seconds_bucket{le=\"5e-06\"} 2"));
+    assert(has("low_latency_processing_seconds_bucket{le=\"0.002\"} 2"));
+    assert(has("low_latency_processing_seconds_bucket{le=\"0.005\"} 3"));
+    assert(has("low_latency_processing_seconds_bucket{le=\"+Inf\"} 3"));
+    assert(has("low_latency_processing_seconds_count 3"));
+    assert(has("# TYPE low_latency_processing_interval_seconds gaugehistogram"));
+    assert(has("low_latency_processing_interval_seconds_gcount 3"));
+    assert(response.size() > 6 && response.compare(response.size() - 6, 6, "# EOF\n") == 0);
+
+    assert(HttpGet(server.Port(), "/").find("404") != std::string::npos);
+    assert(server.Scrapes() == 1);
+    server.Stop();
+}
+
+int main() {
+    std::cout << "Testing stats segment..." << std::endl;
+    publish_read_test();
+    std::cout << "Stats segment tests passed!" << std::endl;
+
+    std::cout << "\nTesting layout versioning..." << std::endl;
+    version_test();
+    std::cout << "Layout versioning tests passed!" << std::endl;
+
+    std::cout << "\nTesting a dead writer..." << std::endl;
+    dead_writer_test();
+    std::cout << "Dead writer tests passed!" << std::endl;
+
+    std::cout << "\nTesting concurrent reads..." << std::endl;
+    concurrent_read_test();
+    std::cout << "Concurrent read tests passed!" << std::endl;
+
+    std::cout << "\nTesting metrics endpoint..." << std::endl;
+    metrics_server_test();
+    std::cout << "Metrics endpoint tests passed!" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Attaches to the pipeline's shared-memory stats segment and renders it.
+//
+//   stats_viewer [--once] [--interval-ms N] [segment]
+//
+// Runs in its own process, so formatting, sorting and terminal output never
+// touch the pipeline's cores. Reattaches when the pipeline restarts.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../core/stats_segment.h"
+
+namespace {
+
+struct Options {
+    std::string segment = kDefaultStatsSegment;
+    int interval_ms = 1000;
+    bool once = false;
+};
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--once") == 0) {
+            options->once = true;
+        } else if (std::strcmp(argv[i], "--interval-ms") == 0 && i + 1 < argc) {
+            options->interval_ms = std::max(1, std::atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            return false;
+        } else {
+            options->segment = argv[i];
+        }
+    }
+    return true;
+}
+
+void PrintHistogram(const StatsSegmentReader::Value& value) {
+    const LatencyTracker& t = value.histogram;
+    auto ns = [&](int64_t v) { return static_cast<double>(v) * value.unit_ns; };
+    std::cout << "  " << std::left << std::setw(40) << value.name << std::right
+              << " n=" << std::setw(10) << t.Count()
+              << std::fixed << std::setprecision(0)
+              << "  avg " << std::setw(8) << t.AvgLatency() * value.unit_ns
+              << "  p50 " << std::setw(8) << ns(t.PercentileLatency(50))
+              << "  p99 " << std::setw(8) << ns(t.PercentileLatency(99))
+              << "  p99.9 " << std::setw(8) << ns(t.PercentileLatency(99.9))
+              << "  p99.99 " << std::setw(8) << ns(t.PercentileLatency(99.99))
+              << "  max " << std::setw(8) << ns(t.MaxLatency()) << " ns"
+              << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        std::cerr << "usage: " << argv[0] << " [--once] [--interval-ms N] [segment]" << std::endl;
+        return 2;
+    }
+
+    StatsSegmentReader reader;
+    std::vector<StatsSegmentReader::Value> values;
+    std::unordered_map<std::string, int64_t> last_counters;
+    uint32_t pid = 0;
+    auto last_read = std::chrono::steady_clock::now();
+
+    while (true) {
+        if (reader.SlotCount() == 0 && !reader.Attach(options.segment)) {
+            if (options.once) {
+                std::cerr << reader.Error() << std::endl;
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+        if (reader.Pid() != pid) {
+            // New pipeline process: counter rates start over
+            pid = reader.Pid();
+            last_counters.clear();
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(now - last_read).count();
+        last_read = now;
+        const double age_s =
+            static_cast<double>(TscClock::MonotonicNs() - reader.PublishedNs()) / 1e9;
+
+        values.resize(reader.SlotCount());
+        if (!options.once) {
+            std::cout << "\033[H\033[2J";
+        }
+        std::cout << options.segment << "  pid " << reader.Pid() << "  publishes "
+                  << reader.Publishes() << std::fixed << std::setprecision(1)
+                  << "  last " << age_s << "s ago" << (age_s > 5.0 ? " (stale)" : "")
+                  << std::defaultfloat << std::setprecision(6) << std::endl;
+        for (size_t i = 0; i < values.size(); ++i) {
+            StatsSegmentReader::Value& value = values[i];
+            if (!reader.Read(i, &value)) {
+                continue;
+            }
+            switch (value.kind) {
+                case StatKind::COUNTER: {
+                    auto last = last_counters.find(value.name);
+                    std::cout << "  " << std::left << std::setw(40) << value.name << std::right
+                              << " " << std::setw(14) << value.counter;
+                    if (last != last_counters.end() && elapsed > 0) {
+                        std::cout << "  " << std::fixed << std::setprecision(1)
+                                  << static_cast<double>(value.counter - last->second) / elapsed
+                                  << "/s" << std::defaultfloat << std::setprecision(6);
+                    }
+                    std::cout << std::endl;
+                    last_counters[value.name] = value.counter;
+                    break;
+                }
+                case StatKind::GAUGE:
+                    std::cout << "  " << std::left << std::setw(40) << value.name << std::right
+                              << " " << std::setw(14) << value.gauge << std::endl;
+                    break;
+                case StatKind::HISTOGRAM:
+                case StatKind::INTERVAL_HISTOGRAM:
+                    PrintHistogram(value);
+                    break;
+            }
+        }
+        if (options.once) {
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.interval_ms));
+        // Pick up a restarted pipeline's new segment
+        if (age_s > 5.0) {
+            reader.Detach();
+        }
+    }
+}